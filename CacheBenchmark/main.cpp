@@ -0,0 +1,329 @@
+#define VULKAN_HPP_DISPATCH_LOADER_DYNAMIC 1
+
+#include "stdafx.h"
+#include "common/hpp_resource_caching.h"
+
+#include <fstream>
+
+VULKAN_HPP_DEFAULT_DISPATCH_LOADER_DYNAMIC_STORAGE
+
+namespace
+{
+    // Stands in for the render pass, lookups never touch the cached object so no device is needed
+    struct CachedObject
+    {
+        uint64_t value = 0;
+    };
+
+    // The arguments of a render pass request, keyed the same way as HPPResourceCache::request_render_pass
+    struct Request
+    {
+        std::vector<vkb::rendering::HPPAttachment> attachments;
+        vkb::core::HPPRenderPassDesc               desc;
+    };
+
+    using RenderPassKey = vkb::common::HPPCacheKey<std::vector<vkb::rendering::HPPAttachment>, vkb::core::HPPRenderPassDesc>;
+
+    // Wall times of the repetitions of a run, in milliseconds
+    struct Timing
+    {
+        double min_ms    = 0.0;
+        double median_ms = 0.0;
+    };
+
+    struct Result
+    {
+        uint32_t thread_count = 0;
+        Timing   hit;          // Warm cache, every request finds its object
+        Timing   build;        // Cold cache, the threads race to build the same objects
+    };
+
+    void print_usage()
+    {
+        std::printf("Usage: CacheBenchmark [-j <threads>] [-k <keys>] [-n <requests>] [-r <repetitions>] [-o <file>]\n"
+                    "\n"
+                    "    -j <threads>      Largest number of threads, all the cores by default\n"
+                    "    -k <keys>         Number of distinct render passes, 256 by default\n"
+                    "    -n <requests>     Requests of each thread in the warm runs, 1000000 by default\n"
+                    "    -r <repetitions>  Number of timed runs of each thread count, 5 by default\n"
+                    "    -o <file>         Writes the results to a file instead of the standard output\n"
+                    "\n"
+                    "Requests render passes from 1, 2, 4... up to the given number of threads, all against the same\n"
+                    "sharded cache, keyed as the resource cache keys them. Warm runs only hit the cache, cold runs start\n"
+                    "from an empty cache where every thread requests every key, so builds race and wait for each other.\n"
+                    "The throughput of each thread count is written as JSON.\n");
+    }
+
+    // Distinct render passes with the attachment counts and formats of a typical frame
+    std::vector<Request> make_requests(size_t count)
+    {
+        const vk::Format color_formats[] = { vk::Format::eR8G8B8A8Unorm, vk::Format::eB8G8R8A8Srgb, vk::Format::eR16G16B16A16Sfloat, vk::Format::eR32Sfloat };
+
+        std::vector<Request> requests;
+        requests.reserve(count);
+
+        for (size_t i = 0; i < count; i++)
+        {
+            uint32_t color_count = 1 + i % 4;
+
+            std::vector<vkb::rendering::HPPAttachment> attachments;
+            std::vector<vkb::HPPLoadStoreInfo>         load_store_infos;
+
+            for (uint32_t c = 0; c < color_count; c++)
+            {
+                attachments.emplace_back(color_formats[(i / 4 + c) % 4], vk::SampleCountFlagBits::e1, vk::ImageUsageFlagBits::eColorAttachment);
+                load_store_infos.push_back({ (i / 16) % 2 ? vk::AttachmentLoadOp::eLoad : vk::AttachmentLoadOp::eClear, vk::AttachmentStoreOp::eStore });
+            }
+
+            attachments.emplace_back(vk::Format::eD32Sfloat, vk::SampleCountFlagBits::e1, vk::ImageUsageFlagBits::eDepthStencilAttachment);
+            load_store_infos.push_back({ vk::AttachmentLoadOp::eClear, vk::AttachmentStoreOp::eDontCare });
+
+            // The combinations above repeat every 32 keys, the subpass count tells the repetitions apart
+            vkb::core::HPPSubpassInfo subpass{};
+            for (uint32_t c = 0; c < color_count; c++)
+            {
+                subpass.output_attachments.push_back(c);
+            }
+
+            std::vector<vkb::core::HPPSubpassInfo> subpasses(1 + i / 32, subpass);
+
+            requests.push_back({ std::move(attachments), vkb::core::HPPRenderPassDesc{ load_store_infos, subpasses } });
+        }
+
+        return requests;
+    }
+
+    // Calls func with each thread index on thread_count threads released together, returns the wall time in milliseconds
+    template <class F>
+    double run_threads(uint32_t thread_count, F& func)
+    {
+        std::atomic<uint32_t> ready{ 0 };
+        std::atomic<bool>     start{ false };
+
+        std::vector<std::thread> threads;
+        threads.reserve(thread_count);
+
+        for (uint32_t t = 0; t < thread_count; t++)
+        {
+            threads.emplace_back([&, t]() {
+                ready++;
+                while (!start.load(std::memory_order_acquire))
+                {
+                    std::this_thread::yield();
+                }
+
+                func(t);
+            });
+        }
+
+        while (ready.load() < thread_count)
+        {
+            std::this_thread::yield();
+        }
+
+        auto begin = std::chrono::steady_clock::now();
+
+        start.store(true, std::memory_order_release);
+
+        for (auto& thread : threads)
+        {
+            thread.join();
+        }
+
+        return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - begin).count();
+    }
+
+    /**
+     * @brief Times the runs of a thread count
+     * @param setup Called before each run, untimed
+     */
+    template <class Setup, class F>
+    Timing measure(uint32_t thread_count, uint32_t repetitions, Setup&& setup, F&& func)
+    {
+        std::vector<double> times;
+        times.reserve(repetitions);
+
+        for (uint32_t r = 0; r < repetitions; r++)
+        {
+            setup();
+
+            times.push_back(run_threads(thread_count, func));
+        }
+
+        std::ranges::sort(times);
+
+        size_t middle = times.size() / 2;
+
+        return { times.front(), times.size() % 2 ? times[middle] : (times[middle - 1] + times[middle]) / 2.0 };
+    }
+
+    // Requests per second of a run
+    double get_throughput(double request_count, const Timing& timing)
+    {
+        return timing.median_ms > 0.0 ? request_count * 1000.0 / timing.median_ms : 0.0;
+    }
+}
+
+int main(int argc, char* argv[])
+{
+    std::string output_path;
+    uint32_t    max_thread_count = std::max(1u, std::thread::hardware_concurrency());
+    size_t      key_count        = 256;
+    size_t      request_count    = 1000000;
+    uint32_t    repetitions      = 5;
+
+    for (int i = 1; i < argc; i++)
+    {
+        std::string argument = argv[i];
+
+        if (argument == "-j" && i + 1 < argc)
+        {
+            max_thread_count = static_cast<uint32_t>(std::max(1ul, std::strtoul(argv[++i], nullptr, 10)));
+        }
+        else if (argument == "-k" && i + 1 < argc)
+        {
+            key_count = static_cast<size_t>(std::max(1ull, std::strtoull(argv[++i], nullptr, 10)));
+        }
+        else if (argument == "-n" && i + 1 < argc)
+        {
+            request_count = static_cast<size_t>(std::max(1ull, std::strtoull(argv[++i], nullptr, 10)));
+        }
+        else if (argument == "-r" && i + 1 < argc)
+        {
+            repetitions = static_cast<uint32_t>(std::max(1ul, std::strtoul(argv[++i], nullptr, 10)));
+        }
+        else if (argument == "-o" && i + 1 < argc)
+        {
+            output_path = argv[++i];
+        }
+        else
+        {
+            print_usage();
+            return 1;
+        }
+    }
+
+    try
+    {
+        auto requests = make_requests(key_count);
+
+        vkb::common::HPPShardedCache<CachedObject> cache;
+
+        auto build = [](size_t index) {
+            return [index]() {
+                auto object   = std::make_unique<CachedObject>();
+                object->value = index;
+                return object;
+            };
+        };
+
+        // Summed by the threads, so the lookups are not optimized away
+        std::atomic<uint64_t> checksum{ 0 };
+
+        // Threads walk the keys from different offsets, hot keys are still shared by all of them
+        auto request = [&](uint32_t thread_index, size_t i) {
+            size_t index = (i + thread_index * 7) % requests.size();
+            auto&  args  = requests[index];
+
+            RenderPassKey key{ args.attachments, args.desc };
+
+            return cache.find_or_build(key, build(index)).value;
+        };
+
+        auto hit_run = [&](uint32_t thread_index) {
+            uint64_t sum = 0;
+            for (size_t i = 0; i < request_count; i++)
+            {
+                sum += request(thread_index, i);
+            }
+            checksum += sum;
+        };
+
+        auto build_run = [&](uint32_t thread_index) {
+            uint64_t sum = 0;
+            for (size_t i = 0; i < requests.size(); i++)
+            {
+                sum += request(thread_index, i);
+            }
+            checksum += sum;
+        };
+
+        auto warm_cache  = [&]() { build_run(0); };
+        auto clear_cache = [&]() { cache.clear(); };
+
+        std::vector<uint32_t> thread_counts;
+        for (uint32_t thread_count = 1; thread_count < max_thread_count; thread_count *= 2)
+        {
+            thread_counts.push_back(thread_count);
+        }
+        thread_counts.push_back(max_thread_count);
+
+        std::vector<Result> results;
+
+        for (auto thread_count : thread_counts)
+        {
+            Result result{ thread_count };
+
+            result.hit   = measure(thread_count, repetitions, warm_cache, hit_run);
+            result.build = measure(thread_count, repetitions, clear_cache, build_run);
+
+            results.push_back(result);
+        }
+
+        if (cache.size() != requests.size())
+        {
+            throw std::runtime_error("Cached " + std::to_string(cache.size()) + " objects for " + std::to_string(requests.size()) + " keys");
+        }
+
+        double single_thread_hits = get_throughput(static_cast<double>(request_count), results.front().hit);
+
+        std::ostringstream json;
+        json << std::fixed << std::setprecision(3);
+
+        json << "{\n"
+             << "  \"keys\": " << requests.size() << ",\n"
+             << "  \"requests_per_thread\": " << request_count << ",\n"
+             << "  \"repetitions\": " << repetitions << ",\n"
+             << "  \"shards\": " << vkb::common::HPPShardedCache<CachedObject>::SHARD_COUNT << ",\n"
+             << "  \"checksum\": " << checksum.load() << ",\n"
+             << "  \"runs\": [\n";
+
+        for (size_t i = 0; i < results.size(); i++)
+        {
+            auto& result = results[i];
+
+            double hits   = get_throughput(static_cast<double>(request_count) * result.thread_count, result.hit);
+            double builds = get_throughput(static_cast<double>(requests.size()) * result.thread_count, result.build);
+
+            json << "    {\n"
+                 << "      \"threads\": " << result.thread_count << ",\n"
+                 << "      \"warm\": { \"min_ms\": " << result.hit.min_ms << ", \"median_ms\": " << result.hit.median_ms << ", \"requests_per_s\": " << hits << " },\n"
+                 << "      \"cold\": { \"min_ms\": " << result.build.min_ms << ", \"median_ms\": " << result.build.median_ms << ", \"requests_per_s\": " << builds << " },\n"
+                 << "      \"warm_scaling\": " << (single_thread_hits > 0.0 ? hits / single_thread_hits : 0.0) << "\n"
+                 << "    }" << (i + 1 < results.size() ? "," : "") << "\n";
+        }
+
+        json << "  ]\n"
+             << "}\n";
+
+        if (output_path.empty())
+        {
+            std::fputs(json.str().c_str(), stdout);
+        }
+        else
+        {
+            std::ofstream file(output_path, std::ios::binary);
+            if (!(file << json.str()))
+            {
+                throw std::runtime_error("Cannot write " + output_path);
+            }
+        }
+    }
+    catch (const std::exception& e)
+    {
+        std::fprintf(stderr, "%s\n", e.what());
+        return 1;
+    }
+
+    return 0;
+}
\ No newline at end of file
@@ -0,0 +1,159 @@
+#pragma once
+
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <type_traits>
+
+#if defined(_MSC_VER)
+#   include <intrin.h>
+#endif
+
+namespace vkb::common
+{
+    /**
+     * @brief A 128-bit hash value
+     */
+    struct HPPHash128
+    {
+        uint64_t low  = 0;
+        uint64_t high = 0;
+
+        bool operator==(const HPPHash128& other) const = default;
+    };
+
+    /**
+     * @brief Streaming 128-bit hasher for cache keys, in the spirit of XXH3.
+     *
+     * Input is consumed in 16 byte stripes, each folded into two independent lanes through a 64x64->128 bit
+     * multiply. Bytes not filling a stripe are kept in a small inline buffer, so feeding a key field by field
+     * gives the same result as feeding it at once, and hashing never allocates.
+     */
+    class HPPHasher
+    {
+    public:
+        explicit HPPHasher(uint64_t seed = 0) :
+            lanes{ seed ^ SECRET[0], seed ^ SECRET[1] }
+        { }
+
+        void write(const void* data, size_t size)
+        {
+            auto bytes = static_cast<const uint8_t*>(data);
+
+            length += size;
+
+            if (buffered > 0)
+            {
+                size_t count = std::min(size, sizeof(buffer) - buffered);
+                std::memcpy(buffer + buffered, bytes, count);
+
+                buffered += count;
+                bytes    += count;
+                size     -= count;
+
+                if (buffered < sizeof(buffer))
+                {
+                    return;
+                }
+
+                consume(buffer);
+                buffered = 0;
+            }
+
+            for (; size >= sizeof(buffer); bytes += sizeof(buffer), size -= sizeof(buffer))
+            {
+                consume(bytes);
+            }
+
+            std::memcpy(buffer, bytes, size);
+            buffered = size;
+        }
+
+        template <class T>
+        void write(const T& value)
+        {
+            static_assert(std::is_trivially_copyable_v<T>, "Only trivially copyable values can be hashed as bytes");
+
+            write(&value, sizeof(T));
+        }
+
+        /**
+         * @brief Returns the hash of the bytes written so far, further writes can follow
+         */
+        HPPHash128 digest() const
+        {
+            uint8_t tail[sizeof(buffer)] = {};
+            std::memcpy(tail, buffer, buffered);
+
+            uint64_t a = read64(tail);
+            uint64_t b = read64(tail + 8);
+
+            uint64_t low  = mum(a ^ lanes[0] ^ SECRET[2], b ^ SECRET[3] ^ length);
+            uint64_t high = mum(b ^ lanes[1] ^ SECRET[4], a ^ SECRET[5] ^ (length << 1));
+
+            // Cross the lanes, so each half of the result depends on all the input
+            return { avalanche(low + rotl(high, 31)), avalanche(high ^ rotl(low, 17)) };
+        }
+
+    private:
+        static constexpr uint64_t SECRET[6] = {
+            0xbe4ba423396cfeb8ULL, 0x1cad21f72c81017cULL, 0xdb979083e96dd4deULL,
+            0x1f67b3b7a4a44072ULL, 0x78e5c0cc4ee679cbULL, 0x2172ffcc7dd05a82ULL
+        };
+
+        void consume(const uint8_t* stripe)
+        {
+            uint64_t a = read64(stripe);
+            uint64_t b = read64(stripe + 8);
+
+            lanes[0] = rotl(lanes[0], 23) ^ mum(a ^ SECRET[0], b ^ lanes[0]);
+            lanes[1] = rotl(lanes[1], 41) + mum(b ^ SECRET[1], a ^ lanes[1]);
+        }
+
+        static uint64_t read64(const uint8_t* bytes)
+        {
+            uint64_t value;
+            std::memcpy(&value, bytes, sizeof(value));
+            return value;
+        }
+
+        static uint64_t rotl(uint64_t value, int shift)
+        {
+            return (value << shift) | (value >> (64 - shift));
+        }
+
+        // Multiplies to 128 bits and folds the halves together
+        static uint64_t mum(uint64_t lhs, uint64_t rhs)
+        {
+#if defined(_MSC_VER) && defined(_M_X64)
+            uint64_t high;
+            uint64_t low = _umul128(lhs, rhs, &high);
+            return low ^ high;
+#elif defined(__SIZEOF_INT128__)
+            unsigned __int128 product = static_cast<unsigned __int128>(lhs) * rhs;
+            return static_cast<uint64_t>(product) ^ static_cast<uint64_t>(product >> 64);
+#else
+            uint64_t lo_lo = (lhs & 0xffffffff) * (rhs & 0xffffffff);
+            uint64_t hi_lo = (lhs >> 32) * (rhs & 0xffffffff);
+            uint64_t lo_hi = (lhs & 0xffffffff) * (rhs >> 32);
+            uint64_t hi_hi = (lhs >> 32) * (rhs >> 32);
+            uint64_t cross = (lo_lo >> 32) + (hi_lo & 0xffffffff) + lo_hi;
+            return ((cross << 32) | (lo_lo & 0xffffffff)) ^ (hi_hi + (hi_lo >> 32) + (cross >> 32));
+#endif
+        }
+
+        static uint64_t avalanche(uint64_t value)
+        {
+            value ^= value >> 37;
+            value *= 0x165667919e3779f9ULL;
+            value ^= value >> 32;
+            return value;
+        }
+
+        uint64_t lanes[2];
+        uint64_t length = 0;
+
+        uint8_t buffer[16];
+        size_t  buffered = 0;
+    };
+}
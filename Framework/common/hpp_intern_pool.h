@@ -0,0 +1,101 @@
+#pragma once
+
+#include <algorithm>
+#include <cstdint>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <utility>
+
+#include "hpp_hasher.h"
+
+namespace vkb::common
+{
+    /**
+     * @brief Usage counters of an intern pool
+     */
+    struct HPPInternPoolStats
+    {
+        uint64_t interned_count = 0;        // Values stored by the pool
+        uint64_t shared_count   = 0;        // Values replaced by an equal one already stored
+        uint64_t saved_bytes    = 0;        // Size of the values replaced
+        uint64_t live_bytes     = 0;        // Size of the stored values still in use, each counted once however many users share it
+    };
+
+    /**
+     * @brief Shares immutable values by content, interning a value equal to a live one returns the live one.
+     *
+     * Values are looked up by their 128-bit hash, and compared before being shared. The pool only keeps weak
+     * references, a value is released with its last user, and its entry is dropped once the pool has doubled
+     * in size since it last swept. Interning is thread safe.
+     */
+    template <class T>
+    class HPPInternPool
+    {
+    public:
+        /**
+         * @param hash The hash of the value
+         * @param size The size of the value in bytes, only used by the statistics
+         */
+        std::shared_ptr<const T> intern(T&& value, const HPPHash128& hash, size_t size)
+        {
+            std::lock_guard<std::mutex> guard(mutex);
+
+            auto& entry = entries[std::make_pair(hash.low, hash.high)];
+
+            if (auto shared = entry.value.lock(); shared && *shared == value)
+            {
+                stats.shared_count++;
+                stats.saved_bytes += size;
+
+                return shared;
+            }
+
+            auto shared = std::make_shared<const T>(std::move(value));
+            entry       = { shared, size };
+
+            stats.interned_count++;
+
+            if (entries.size() >= sweep_threshold)
+            {
+                std::erase_if(entries, [](const auto& item) { return item.second.value.expired(); });
+
+                sweep_threshold = std::max<size_t>(64, entries.size() * 2);
+            }
+
+            return shared;
+        }
+
+        HPPInternPoolStats get_stats() const
+        {
+            std::lock_guard<std::mutex> guard(mutex);
+
+            HPPInternPoolStats current = stats;
+
+            for (auto& [hash, entry] : entries)
+            {
+                if (!entry.value.expired())
+                {
+                    current.live_bytes += entry.size;
+                }
+            }
+
+            return current;
+        }
+
+    private:
+        struct Entry
+        {
+            std::weak_ptr<const T> value;
+            size_t                 size = 0;
+        };
+
+        mutable std::mutex mutex;
+
+        std::map<std::pair<uint64_t, uint64_t>, Entry> entries;
+
+        size_t sweep_threshold = 64;
+
+        HPPInternPoolStats stats;
+    };
+}
\ No newline at end of file
@@ -1,6 +1,10 @@
 #pragma once
 
+#include <tuple>
+#include <type_traits>
+
 #include "helpers.h"
+#include "hpp_sharded_cache.h"
 
 namespace std
 {
@@ -102,17 +106,7 @@ namespace std
     {
         size_t operator()(const vkb::core::HPPImage& image) const
         {
-            size_t result = 0;
-            vkb::hash_combine(result, image.get_memory());
-            vkb::hash_combine(result, image.get_type());
-            vkb::hash_combine(result, image.get_extent());
-            vkb::hash_combine(result, image.get_format());
-            vkb::hash_combine(result, image.get_usage());
-            vkb::hash_combine(result, image.get_sample_count());
-            vkb::hash_combine(result, image.get_tiling());
-            vkb::hash_combine(result, image.get_subresource());
-            vkb::hash_combine(result, image.get_array_layer_count());
-            return result;
+            return std::hash<uint64_t>()(image.get_generation());
         }
     };
 
@@ -121,11 +115,7 @@ namespace std
     {
         size_t operator()(const vkb::core::HPPImageView& image_view) const
         {
-            size_t result = std::hash<vkb::core::VulkanResource<vk::ImageView>>()(image_view);
-            vkb::hash_combine(result, image_view.get_image());
-            vkb::hash_combine(result, image_view.get_format());
-            vkb::hash_combine(result, image_view.get_subresource_range());
-            return result;
+            return std::hash<uint64_t>()(image_view.get_generation());
         }
     };
 
@@ -134,77 +124,397 @@ namespace std
     {
         size_t operator()(const vkb::rendering::HPPRenderTarget& render_target) const
         {
-            size_t result = 0;
-            
-            for (auto& view : render_target.get_views())
-            {
-                vkb::hash_combine(result, view.get_handle());
-                vkb::hash_combine(result, view.get_image().get_handle());
-            }
-
-            return result;
+            return std::hash<uint64_t>()(render_target.get_generation());
         }
     };
 }
 
 namespace vkb::common
 {
+    /**
+     * @brief Appends the bytes of a key to a vector, done once for every object added to a cache
+     */
+    class HPPKeyWriter
+    {
+    public:
+        explicit HPPKeyWriter(std::vector<uint8_t>& data) :
+            data{ data }
+        { }
+
+        void write(const void* bytes, size_t size)
+        {
+            data.insert(data.end(), static_cast<const uint8_t*>(bytes), static_cast<const uint8_t*>(bytes) + size);
+        }
+
+        template <class T>
+        void write(const T& value)
+        {
+            write(&value, sizeof(T));
+        }
+
+    private:
+        std::vector<uint8_t>& data;
+    };
+
+    /**
+     * @brief Compares the bytes of a key with the ones stored next to a cached object, without serializing the key
+     */
+    class HPPKeyComparer
+    {
+    public:
+        explicit HPPKeyComparer(const std::vector<uint8_t>& stored) :
+            stored{ stored }
+        { }
+
+        void write(const void* bytes, size_t size)
+        {
+            equal  = equal && offset + size <= stored.size() && std::memcmp(stored.data() + offset, bytes, size) == 0;
+            offset += size;
+        }
+
+        template <class T>
+        void write(const T& value)
+        {
+            write(&value, sizeof(T));
+        }
+
+        bool matches() const
+        {
+            return equal && offset == stored.size();
+        }
+
+    private:
+        const std::vector<uint8_t>& stored;
+
+        size_t offset = 0;
+        bool   equal  = true;
+    };
+
     namespace
     {
-        template <typename T>
-        inline void hash_param(size_t& seed, const T& value)
+        /**
+         * @brief Feeds the bytes identifying a request parameter to a sink: HPPHasher, HPPKeyWriter or HPPKeyComparer.
+         *        Values are written field by field, so padding bytes never end up in a key.
+         */
+        template <class Sink, class T>
+            requires std::is_arithmetic_v<T> || std::is_enum_v<T> || std::has_unique_object_representations_v<T>
+        inline void key_param(Sink& sink, const T& value)
+        {
+            sink.write(value);
+        }
+
+        template <class Sink, class T>
+        inline void key_param(Sink& sink, const std::vector<T>& value);
+
+        template <class Sink>
+        inline void key_param(Sink& sink, const std::string& value)
+        {
+            sink.write(value.size());
+            sink.write(value.data(), value.size());
+        }
+
+        template <class Sink>
+        inline void key_param(Sink& sink, const HPPLoadStoreInfo& value)
+        {
+            sink.write(value.load_op);
+            sink.write(value.store_op);
+        }
+
+        template <class Sink>
+        inline void key_param(Sink& sink, const rendering::HPPAttachment& value)
         {
-            hash_combine(seed, value);
+            sink.write(value.format);
+            sink.write(value.samples);
+            sink.write(value.usage);
+            sink.write(value.initial_layout);
         }
 
-        template <typename T, typename... Args>
-        inline void hash_param(size_t& seed, const T& first_arg, const Args&... args)
+        template <class Sink>
+        inline void key_param(Sink& sink, const core::HPPRenderPass& value)
         {
-            hash_param(seed, first_arg);
-            hash_param(seed, args...);
+            sink.write(value.get_handle());
         }
 
-        template <>
-        inline void hash_param<std::vector<vkb::core::HPPSubpassInfo>>(
-            size_t& seed,
-            const std::vector<vkb::core::HPPSubpassInfo>& value)
+        // Objects holding a generation id are identified by it alone, unlike their handles it is never reused
+        template <class Sink>
+        inline void key_param(Sink& sink, const core::HPPImage& value)
         {
-            for (auto& subpass_info : value)
+            sink.write(value.get_generation());
+        }
+
+        template <class Sink>
+        inline void key_param(Sink& sink, const core::HPPImageView& value)
+        {
+            sink.write(value.get_generation());
+        }
+
+        template <class Sink>
+        inline void key_param(Sink& sink, const rendering::HPPRenderTarget& value)
+        {
+            sink.write(value.get_generation());
+        }
+
+        template <class Sink>
+        inline void key_param(Sink& sink, const core::HPPSubpassInfo& value)
+        {
+            key_param(sink, value.input_attachments);
+            key_param(sink, value.output_attachments);
+            key_param(sink, value.color_resolve_attachments);
+            sink.write(value.disable_depth_stencil_attachment);
+            sink.write(value.depth_stencil_resolve_attachment);
+            sink.write(value.depth_stencil_resolve_mode);
+        }
+
+        template <class Sink>
+        inline void key_param(Sink& sink, const core::HPPRenderPassDesc& value)
+        {
+            sink.write(value.get_key().data(), value.get_key().size());
+        }
+
+        // The description carries the hash of its key, hashing it again would be wasted work
+        inline void key_param(HPPHasher& hasher, const core::HPPRenderPassDesc& value)
+        {
+            hasher.write(value.get_hash());
+        }
+
+        // The text is the key, its 64-bit id alone could match a different source
+        template <class Sink>
+        inline void key_param(Sink& sink, const core::HPPShaderSource& value)
+        {
+            key_param(sink, value.get_source());
+        }
+
+        // The id is computed with the source, the comparison of the text settles collisions
+        inline void key_param(HPPHasher& hasher, const core::HPPShaderSource& value)
+        {
+            hasher.write(value.get_id());
+        }
+
+        // Runtime array sizes are not part of the preamble but change the reflected resources.
+        // The same sizes inserted in another order may land in another order, costing a miss at worst.
+        template <class Sink>
+        inline void key_runtime_array_sizes(Sink& sink, const core::HPPShaderVariant& value)
+        {
+            sink.write(value.get_runtime_array_sizes().size());
+            for (auto& runtime_array_size : value.get_runtime_array_sizes())
             {
-                hash_combine(seed, subpass_info);
+                key_param(sink, runtime_array_size.first);
+                sink.write(runtime_array_size.second);
             }
         }
 
-        template <>
-        inline void hash_param<std::vector<HPPLoadStoreInfo>>(
-            size_t& seed,
-            const std::vector<HPPLoadStoreInfo>& value)
+        // The id is a sum of hashes which different sets of directives can share, the key is the canonical list itself
+        template <class Sink>
+        inline void key_param(Sink& sink, const core::HPPShaderVariant& value)
         {
-            for (auto& load_store_info : value)
+            key_param(sink, value.get_base_preamble());
+            key_param(sink, value.get_base_processes());
+
+            sink.write(value.get_directives().size());
+            for (auto& [name, directive] : value.get_directives())
             {
-                hash_combine(seed, load_store_info);
+                sink.write(name.size());
+                sink.write(name.data(), name.size());
+                sink.write(directive.undefine);
+                key_param(sink, directive.definition);
             }
+
+            key_runtime_array_sizes(sink, value);
+        }
+
+        // The variant keeps its id up to date as directives are added, the comparison of the list settles collisions
+        inline void key_param(HPPHasher& hasher, const core::HPPShaderVariant& value)
+        {
+            hasher.write(value.get_id());
+
+            key_runtime_array_sizes(hasher, value);
+        }
+
+        template <class Sink>
+        inline void key_param(Sink& sink, const core::HPPShaderResource& value)
+        {
+            sink.write(value.stages);
+            sink.write(value.type);
+            sink.write(value.mode);
+            sink.write(value.set);
+            sink.write(value.binding);
+            sink.write(value.location);
+            sink.write(value.input_attachment_index);
+            sink.write(value.vec_size);
+            sink.write(value.columns);
+            sink.write(value.array_size);
+            sink.write(value.offset);
+            sink.write(value.size);
+            sink.write(value.constant_id);
+            sink.write(value.qualifiers);
+            key_param(sink, value.name);
         }
 
-        template <>
-        inline void hash_param<std::vector<rendering::HPPAttachment>>(
-            size_t& seed,
-            const std::vector<rendering::HPPAttachment>& value)
+        template <class Sink>
+        inline void key_param(Sink& sink, const vk::DescriptorSetLayoutBinding& value)
         {
-            for (auto& attachment : value)
+            sink.write(value.binding);
+            sink.write(value.descriptorType);
+            sink.write(value.descriptorCount);
+            sink.write(value.stageFlags);
+        }
+
+        template <class Sink>
+        inline void key_param(Sink& sink, const core::HPPDescriptorSetLayoutSignature& value)
+        {
+            key_param(sink, value.bindings);
+            key_param(sink, value.binding_flags);
+        }
+
+        // Shader modules are identified by their code rather than their address, so modules compiled to the same
+        // binary share layouts. The code is written as the full 128-bit hash of the binary and its size, rather than
+        // the binary itself, which every layout request would otherwise compare. The resource modes are included as
+        // they can be changed after the module is built.
+        template <class Sink>
+        inline void key_param(Sink& sink, const core::HPPShaderModule& value)
+        {
+            sink.write(value.get_binary_hash().low);
+            sink.write(value.get_binary_hash().high);
+            sink.write(value.get_binary().size_bytes());
+            sink.write(value.get_stage());
+            key_param(sink, value.get_entry_point());
+
+            for (auto& resource : value.get_resources())
             {
-                hash_combine(seed, attachment);
+                sink.write(resource.mode);
             }
         }
 
-        template <>
-        inline void hash_param<std::vector<uint8_t>>(
-            size_t& seed,
-            const std::vector<uint8_t>& value)
+        template <class Sink>
+        inline void key_param(Sink& sink, const std::vector<core::HPPShaderModule*>& value)
         {
-            hash_combine(seed, std::string{ value.begin(), value.end() });
+            sink.write(value.size());
+            for (auto* shader_module : value)
+            {
+                key_param(sink, *shader_module);
+            }
         }
 
+        template <class Sink>
+        inline void key_param(Sink& sink, const core::HPPPipelineLayout& value)
+        {
+            sink.write(value.get_handle());
+        }
+
+        template <class Sink>
+        inline void key_param(Sink& sink, const vk::VertexInputBindingDescription& value)
+        {
+            sink.write(value.binding);
+            sink.write(value.stride);
+            sink.write(value.inputRate);
+        }
+
+        template <class Sink>
+        inline void key_param(Sink& sink, const vk::VertexInputAttributeDescription& value)
+        {
+            sink.write(value.location);
+            sink.write(value.binding);
+            sink.write(value.format);
+            sink.write(value.offset);
+        }
+
+        template <class Sink>
+        inline void key_param(Sink& sink, const rendering::HPPColorBlendAttachmentState& value)
+        {
+            sink.write(value.blend_enable);
+            sink.write(value.src_color_blend_factor);
+            sink.write(value.dst_color_blend_factor);
+            sink.write(value.color_blend_op);
+            sink.write(value.src_alpha_blend_factor);
+            sink.write(value.dst_alpha_blend_factor);
+            sink.write(value.alpha_blend_op);
+            sink.write(value.color_write_mask);
+        }
+
+        // The packed state holds the handles of the layout and render pass, cached objects whose handles stay unique for
+        // as long as the pipelines built from them. The remaining sub-states are variable sized and written as vectors.
+        template <class Sink>
+        inline void key_param(Sink& sink, const rendering::HPPPipelineState& value)
+        {
+            sink.write(value.get_packed_state());
+
+            key_param(sink, value.get_vertex_input_state().bindings);
+            key_param(sink, value.get_vertex_input_state().attributes);
+            key_param(sink, value.get_color_blend_state().attachments);
+        }
+
+        // The state caches its hash until a sub-state changes
+        inline void key_param(HPPHasher& hasher, const rendering::HPPPipelineState& value)
+        {
+            hasher.write(value.get_hash());
+        }
+
+        template <class Sink, class T>
+        inline void key_param(Sink& sink, const std::vector<T>& value)
+        {
+            sink.write(value.size());
+
+            if constexpr (std::has_unique_object_representations_v<T>)
+            {
+                // Contiguous and padding free, e.g. attachment indices or SPIR-V bytes
+                sink.write(value.data(), value.size() * sizeof(T));
+            }
+            else
+            {
+                for (auto& item : value)
+                {
+                    key_param(sink, item);
+                }
+            }
+        }
+
+        /**
+         * @brief Key of a cache request, a view over its parameters: nothing is copied unless the object gets built
+         */
+        template <class... A>
+        class HPPCacheKey
+        {
+        public:
+            explicit HPPCacheKey(const A&... args) :
+                args{ args... }
+            {
+                HPPHasher hasher;
+                visit(hasher);
+                hash = hasher.digest();
+            }
+
+            const HPPHash128& get_hash() const
+            {
+                return hash;
+            }
+
+            bool matches(const std::vector<uint8_t>& stored) const
+            {
+                HPPKeyComparer comparer{ stored };
+                visit(comparer);
+                return comparer.matches();
+            }
+
+            std::vector<uint8_t> serialize() const
+            {
+                std::vector<uint8_t> data;
+                HPPKeyWriter         writer{ data };
+                visit(writer);
+                return data;
+            }
+
+        private:
+            template <class Sink>
+            void visit(Sink& sink) const
+            {
+                std::apply([&sink](const A&... params) { (key_param(sink, params), ...); }, args);
+            }
+
+            std::tuple<const A&...> args;
+
+            HPPHash128 hash;
+        };
+
         template<class T, class... A>
         struct HPPRecordHelper
         {
@@ -230,20 +540,62 @@ namespace vkb::common
                 return recorder.set_render_pass(index, render_pass);
             }
         };
+
+        template <class... A>
+        struct HPPRecordHelper<vkb::core::HPPShaderModule, A...>
+        {
+            size_t record(HPPResourceRecord& recorder, A&... args)
+            {
+                return recorder.register_shader_module(args...);
+            }
+
+            void index(HPPResourceRecord& recorder, size_t index, vkb::core::HPPShaderModule& shader_module)
+            {
+                recorder.set_shader_module(index, shader_module);
+            }
+        };
+
+        template <class... A>
+        struct HPPRecordHelper<vkb::core::HPPPipelineLayout, A...>
+        {
+            size_t record(HPPResourceRecord& recorder, A&... args)
+            {
+                return recorder.register_pipeline_layout(args...);
+            }
+
+            void index(HPPResourceRecord& recorder, size_t index, vkb::core::HPPPipelineLayout& pipeline_layout)
+            {
+                recorder.set_pipeline_layout(index, pipeline_layout);
+            }
+        };
+
+        template <class... A>
+        struct HPPRecordHelper<vkb::core::HPPGraphicsPipeline, A...>
+        {
+            size_t record(HPPResourceRecord& recorder, A&... args)
+            {
+                return recorder.register_graphics_pipeline(args...);
+            }
+
+            void index(HPPResourceRecord&, size_t, vkb::core::HPPGraphicsPipeline&)
+            { }
+        };
     }
 
-    template <class T, class... A>
-    T& request_resource(vkb::core::HPPDevice& device, vkb::HPPResourceRecord* recorder, std::unordered_map<size_t, T>& resources, A&... args)
+    /**
+     * @brief Same as request_resource, with a callable creating the object on a miss, for objects taking more than their key
+     */
+    template <class T, class Builder, class... A>
+    T& request_resource_with(Builder&& build, vkb::HPPResourceRecord* recorder, HPPShardedCache<T>& resources, A&... args)
     {
         HPPRecordHelper<T, A...> record_helper;
 
-        size_t hash{ 0U };
-        hash_param(hash, args...);
+        HPPCacheKey<A...> key{ args... };
 
-        auto res_it = resources.find(hash);
-        if (res_it != resources.end())
+        // Cache hits never take a lock
+        if (T* resource = resources.find(key))
         {
-            return res_it->second;
+            return *resource;
         }
 
         // If we do not have it already, create and cache it
@@ -255,28 +607,30 @@ namespace vkb::common
         try
         {
 #endif
-            T resource(device, args...);
+            // Creation runs outside of the cache locks, concurrent requests for this hash wait for it
+            return resources.find_or_build(key, [&]() {
+                std::unique_ptr<T> resource = build(args...);
 
-            auto res_ins_it = resources.emplace(hash, std::move(resource));
-            if (!res_ins_it.second)
-            {
-                throw std::runtime_error{ std::string{"Insertion error for #"} + std::to_string(res_id) + "cache object (" + res_type + ")" };
-            }
+                if (recorder)
+                {
+                    size_t index = record_helper.record(*recorder, args...);
+                    record_helper.index(*recorder, index, *resource);
+                }
 
-            res_it = res_ins_it.first;
-
-            if (recorder)
-            {
-                size_t index = record_helper.record(*recorder, args...);
-                record_helper.index(*recorder, index, res_it->second);
-            }
+                return resource;
+            });
 #ifndef DEBUG
         }
         catch (const std::exception& e)
         {
-            throw e;
+            throw std::runtime_error{ std::string{"Creation error for #"} + std::to_string(res_id) + " cache object (" + res_type + "): " + e.what() };
         }
 #endif
-        return res_it->second;
+    }
+
+    template <class T, class... A>
+    T& request_resource(vkb::core::HPPDevice& device, vkb::HPPResourceRecord* recorder, HPPShardedCache<T>& resources, A&... args)
+    {
+        return request_resource_with([&device](A&... build_args) { return std::make_unique<T>(device, build_args...); }, recorder, resources, args...);
     }
 }
\ No newline at end of file
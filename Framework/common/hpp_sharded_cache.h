@@ -0,0 +1,541 @@
+#pragma once
+
+#include <array>
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <exception>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <unordered_map>
+#include <vector>
+
+#include "hpp_hasher.h"
+
+namespace vkb::common
+{
+    /**
+     * @brief Usage counters of a cache, build times are in microseconds
+     */
+    struct HPPCacheStats
+    {
+        uint64_t hits              = 0;
+        uint64_t misses            = 0;        // Objects built, successfully or not
+        uint64_t build_time_us     = 0;
+        uint64_t max_build_time_us = 0;
+        size_t   live_count        = 0;
+        size_t   live_bytes        = 0;        // Host memory held by the cached objects, see get_footprint
+    };
+
+    /**
+     * @brief Host memory held by a cached object, overload it next to types owning more than their own storage
+     */
+    template <class T>
+    size_t get_footprint(const T&)
+    {
+        return sizeof(T);
+    }
+
+    /**
+     * @brief Hash indexed storage for cached Vulkan objects, tuned for a read-mostly access pattern.
+     *
+     * Objects are looked up by key. A key provides its 128-bit hash through get_hash(), compares itself to
+     * the bytes of a stored key through matches(), and serializes itself through serialize(). The bytes are
+     * stored next to each object, so two keys sharing a hash never return each other's object.
+     *
+     * Entries are spread over a fixed number of shards. Each shard publishes an immutable snapshot of its
+     * index through an atomic pointer, so a lookup of an already cached object never takes a lock.
+     * Insertions take the lock of a single shard, copy its index, and publish the new snapshot.
+     * Superseded snapshots are kept alive until reclaim() is called, as a reader may still be walking them.
+     *
+     * Objects are built outside of any lock. Each shard tracks the keys being built, so threads requesting
+     * the same key wait for a single builder, while distinct keys are built in parallel.
+     *
+     * Every lookup stamps the entry it finds with the current stamp (e.g. a frame number), which lets
+     * the owner erase the entries not used for a while. Erased objects stay owned by the cache, which
+     * destroys them in reclaim() once the GPU is done with the stamp they were erased at.
+     *
+     * Objects are heap allocated, so the references handed out stay valid until erased or cleared.
+     */
+    template <class T>
+    class HPPShardedCache
+    {
+    public:
+        static constexpr size_t SHARD_COUNT = 16;
+
+        HPPShardedCache() = default;
+
+        HPPShardedCache(const HPPShardedCache&)            = delete;
+        HPPShardedCache(HPPShardedCache&&)                 = delete;
+        HPPShardedCache& operator=(const HPPShardedCache&) = delete;
+        HPPShardedCache& operator=(HPPShardedCache&&)      = delete;
+
+        /**
+         * @brief Lock-free lookup, safe to call concurrently with insertions
+         * @param key The key of the requested object
+         * @return The cached object, or nullptr if there is none for the given key
+         */
+        template <class Key>
+        T* find(const Key& key) const
+        {
+            const HPPHash128& hash  = key.get_hash();
+            const Shard&      shard = get_shard(hash);
+            const Index*      index = shard.index.load(std::memory_order_acquire);
+
+            if (index)
+            {
+                auto [begin, end] = index->equal_range(hash.low);
+                for (auto it = begin; it != end; ++it)
+                {
+                    Entry& entry = *it->second;
+
+                    if (entry.hash != hash || !key.matches(entry.key))
+                    {
+                        continue;
+                    }
+
+                    count_hit();
+
+                    // Only write when the stamp changes, so hot entries are not bounced between cores every lookup
+                    uint64_t current = stamp.load(std::memory_order_relaxed);
+                    if (entry.last_used.load(std::memory_order_relaxed) != current)
+                    {
+                        entry.last_used.store(current, std::memory_order_relaxed);
+                    }
+
+                    return entry.resource.get();
+                }
+            }
+
+            return nullptr;
+        }
+
+        /**
+         * @brief Returns the object cached for a key, building and caching it first if there is none.
+         *        If another thread is already building an object for this key, waits for it instead.
+         *        If the build throws, the exception is propagated to the builder and all waiting threads.
+         * @param key The key of the requested object
+         * @param build Callable returning a std::unique_ptr<T> to the newly created object
+         * @return A reference to the cached object
+         */
+        template <class Key, class Builder>
+        T& find_or_build(const Key& key, Builder&& build)
+        {
+            if (T* resource = find(key))
+            {
+                return *resource;
+            }
+
+            const HPPHash128& hash  = key.get_hash();
+            auto&             shard = get_shard(hash);
+            std::promise<T*>  promise;
+
+            typename InFlightMap::iterator in_flight;
+
+            {
+                std::unique_lock<std::mutex> lock(shard.mutex);
+
+                // Another thread may have created it while we were waiting for the shard
+                if (T* resource = find(key))
+                {
+                    return *resource;
+                }
+
+                auto [begin, end] = shard.in_flight.equal_range(hash.low);
+                for (auto it = begin; it != end; ++it)
+                {
+                    if (it->second.hash == hash && key.matches(it->second.key))
+                    {
+                        auto future = it->second.future;
+                        lock.unlock();
+
+                        count_hit();
+
+                        return *future.get();
+                    }
+                }
+
+                in_flight = shard.in_flight.emplace(hash.low, InFlight{ hash, key.serialize(), promise.get_future().share() });
+            }
+
+            shard.counters.misses.fetch_add(1, std::memory_order_relaxed);
+
+            auto start = std::chrono::steady_clock::now();
+
+            try
+            {
+                std::unique_ptr<T> resource = build();
+
+                record_build_time(shard, start);
+
+                T* res = nullptr;
+                {
+                    std::lock_guard<std::mutex> guard(shard.mutex);
+
+                    res = &emplace(shard, hash, std::move(in_flight->second.key), std::move(resource));
+                    shard.in_flight.erase(in_flight);
+                }
+
+                promise.set_value(res);
+
+                return *res;
+            }
+            catch (...)
+            {
+                record_build_time(shard, start);
+
+                {
+                    std::lock_guard<std::mutex> guard(shard.mutex);
+
+                    shard.in_flight.erase(in_flight);
+                }
+
+                promise.set_exception(std::current_exception());
+                throw;
+            }
+        }
+
+        size_t size() const
+        {
+            return count.load(std::memory_order_relaxed);
+        }
+
+        /**
+         * @brief Sums the counters of all the shards, values are not a consistent snapshot under concurrent requests
+         */
+        HPPCacheStats get_stats() const
+        {
+            HPPCacheStats stats;
+
+            for (auto& slot : hit_slots)
+            {
+                stats.hits += slot.hits.load(std::memory_order_relaxed);
+            }
+
+            for (auto& shard : shards)
+            {
+                stats.misses            += shard.counters.misses.load(std::memory_order_relaxed);
+                stats.build_time_us     += shard.counters.build_time_us.load(std::memory_order_relaxed);
+                stats.max_build_time_us  = std::max(stats.max_build_time_us, shard.counters.max_build_time_us.load(std::memory_order_relaxed));
+                stats.live_bytes        += shard.counters.live_bytes.load(std::memory_order_relaxed);
+            }
+
+            stats.live_count = size();
+
+            return stats;
+        }
+
+        /**
+         * @brief Sets the stamp of the entries looked up or inserted from now on
+         */
+        void set_stamp(uint64_t value)
+        {
+            stamp.store(value, std::memory_order_relaxed);
+        }
+
+        /**
+         * @brief Removes the entries matching a predicate from the cache.
+         *        Readers walking an older snapshot may still find them, so the objects are only destroyed by reclaim().
+         * @param pred Callable taking the object and the stamp of its last use, returning true to remove it
+         * @return The removed objects, valid until destroyed by reclaim()
+         */
+        template <class Pred>
+        std::vector<T*> erase_if(Pred&& pred)
+        {
+            std::vector<T*> erased;
+            uint64_t        current_stamp = stamp.load(std::memory_order_relaxed);
+
+            for (auto& shard : shards)
+            {
+                std::lock_guard<std::mutex> guard(shard.mutex);
+
+                const Index* current = shard.index.load(std::memory_order_relaxed);
+                if (!current)
+                {
+                    continue;
+                }
+
+                std::unique_ptr<Index> next;
+
+                for (auto& item : *current)
+                {
+                    Entry& entry = *item.second;
+
+                    if (!pred(static_cast<const T&>(*entry.resource), entry.last_used.load(std::memory_order_relaxed)))
+                    {
+                        continue;
+                    }
+
+                    // Only copy the index of shards losing entries
+                    if (!next)
+                    {
+                        next = std::make_unique<Index>(*current);
+                    }
+
+                    auto [begin, end] = next->equal_range(item.first);
+                    next->erase(std::find_if(begin, end, [&entry](const auto& other) { return other.second == &entry; }));
+
+                    shard.counters.live_bytes.fetch_sub(entry.bytes, std::memory_order_relaxed);
+                    erased.push_back(entry.resource.get());
+
+                    // The entry keeps its object, a lookup through an older snapshot may still return it
+                    auto owner = shard.entries.find(&entry);
+                    shard.retired.emplace_back(current_stamp, std::move(owner->second));
+                    shard.entries.erase(owner);
+
+                    count.fetch_sub(1, std::memory_order_relaxed);
+                }
+
+                if (next)
+                {
+                    shard.index.store(next.get(), std::memory_order_release);
+                    shard.indices.push_back(std::move(next));
+                }
+            }
+
+            return erased;
+        }
+
+        /**
+         * @brief Moves a cached object under another key, for an object whose inputs were replaced in place.
+         *        Not safe to call while other threads are requesting objects from the cache.
+         * @param object An object of the cache
+         * @param key The key requests for the object are now made with
+         * @return False if the object is not cached, or if another object is cached for the key
+         */
+        template <class Key>
+        bool rekey(const T& object, const Key& key)
+        {
+            if (const T* cached = find(key))
+            {
+                return cached == &object;
+            }
+
+            std::unique_ptr<T> resource;
+
+            for (auto& shard : shards)
+            {
+                std::lock_guard<std::mutex> guard(shard.mutex);
+
+                auto owner = std::ranges::find_if(shard.entries, [&object](const auto& item) { return item.second->resource.get() == &object; });
+                if (owner == shard.entries.end())
+                {
+                    continue;
+                }
+
+                Entry& entry = *owner->second;
+
+                auto next         = std::make_unique<Index>(*shard.index.load(std::memory_order_relaxed));
+                auto [begin, end] = next->equal_range(entry.hash.low);
+                next->erase(std::find_if(begin, end, [&entry](const auto& other) { return other.second == &entry; }));
+
+                shard.index.store(next.get(), std::memory_order_release);
+                shard.indices.push_back(std::move(next));
+
+                shard.counters.live_bytes.fetch_sub(entry.bytes, std::memory_order_relaxed);
+
+                // The emptied entry is retired, as the superseded snapshots still point to it
+                resource = std::move(entry.resource);
+                shard.retired.emplace_back(stamp.load(std::memory_order_relaxed), std::move(owner->second));
+                shard.entries.erase(owner);
+
+                count.fetch_sub(1, std::memory_order_relaxed);
+                break;
+            }
+
+            if (!resource)
+            {
+                return false;
+            }
+
+            // The object keeps its address, so the references handed out stay valid
+            auto& shard = get_shard(key.get_hash());
+
+            std::lock_guard<std::mutex> guard(shard.mutex);
+
+            emplace(shard, key.get_hash(), key.serialize(), std::move(resource));
+
+            return true;
+        }
+
+        /**
+         * @brief Calls a function with every cached object.
+         *        Not safe to call while other threads are requesting objects from the cache.
+         */
+        template <class F>
+        void for_each(F&& func)
+        {
+            for (auto& shard : shards)
+            {
+                std::lock_guard<std::mutex> guard(shard.mutex);
+
+                for (auto& item : shard.entries)
+                {
+                    func(*item.second->resource);
+                }
+            }
+        }
+
+        /**
+         * @brief Frees the superseded snapshots, and the entries erased at a stamp up to the given one.
+         *        Not safe to call while other threads are requesting objects from the cache.
+         * @param completed The last stamp whose uses of the objects are over, e.g. the last frame the GPU completed
+         */
+        void reclaim(uint64_t completed)
+        {
+            for (auto& shard : shards)
+            {
+                std::lock_guard<std::mutex> guard(shard.mutex);
+
+                // The current snapshot is always the last one published
+                if (shard.indices.size() > 1)
+                {
+                    shard.indices.erase(shard.indices.begin(), shard.indices.end() - 1);
+                }
+
+                std::erase_if(shard.retired, [completed](const auto& retired) { return retired.first <= completed; });
+            }
+        }
+
+        /**
+         * @brief Destroys all the cached objects.
+         *        Not safe to call while other threads are requesting objects from the cache.
+         */
+        void clear()
+        {
+            for (auto& shard : shards)
+            {
+                std::lock_guard<std::mutex> guard(shard.mutex);
+
+                shard.index.store(nullptr, std::memory_order_release);
+                shard.indices.clear();
+                shard.entries.clear();
+                shard.retired.clear();
+                shard.in_flight.clear();
+                shard.counters.live_bytes.store(0, std::memory_order_relaxed);
+            }
+
+            count.store(0, std::memory_order_relaxed);
+        }
+
+    private:
+        struct Entry
+        {
+            HPPHash128            hash;
+            std::vector<uint8_t>  key;
+            std::unique_ptr<T>    resource;
+            std::atomic<uint64_t> last_used{ 0 };
+            size_t                bytes = 0;
+        };
+
+        struct InFlight
+        {
+            HPPHash128             hash;
+            std::vector<uint8_t>   key;
+            std::shared_future<T*> future;
+        };
+
+        // Kept on a cache line of their own, as every build writes them while readers load the index pointer
+        struct alignas(64) Counters
+        {
+            std::atomic<uint64_t> misses{ 0 };
+            std::atomic<uint64_t> build_time_us{ 0 };
+            std::atomic<uint64_t> max_build_time_us{ 0 };
+            std::atomic<size_t>   live_bytes{ 0 };
+        };
+
+        // Indexed by the low half of the hash, entries sharing it are told apart by the full hash and key
+        using Index       = std::unordered_multimap<uint64_t, Entry*>;
+        using InFlightMap = std::unordered_multimap<uint64_t, InFlight>;
+
+        // Aligned to keep shards written by different threads on separate cache lines
+        struct alignas(64) Shard
+        {
+            std::mutex                                               mutex;
+            std::atomic<const Index*>                                index{ nullptr };
+            std::vector<std::unique_ptr<const Index>>                indices;          // Current and superseded index snapshots
+            std::unordered_map<const Entry*, std::unique_ptr<Entry>> entries;
+            std::vector<std::pair<uint64_t, std::unique_ptr<Entry>>> retired;          // Erased entries along with the stamp they were erased at
+            InFlightMap                                              in_flight;        // Keys being built, guarded by mutex
+            mutable Counters                                         counters;
+        };
+
+        // Stores a new object and publishes it to readers, the shard mutex must be held
+        T& emplace(Shard& shard, const HPPHash128& hash, std::vector<uint8_t>&& key, std::unique_ptr<T>&& resource)
+        {
+            const Index* current = shard.index.load(std::memory_order_relaxed);
+            auto         next    = current ? std::make_unique<Index>(*current) : std::make_unique<Index>();
+            auto         entry   = std::make_unique<Entry>();
+
+            entry->hash     = hash;
+            entry->key      = std::move(key);
+            entry->resource = std::move(resource);
+            entry->last_used.store(stamp.load(std::memory_order_relaxed), std::memory_order_relaxed);
+            entry->bytes = get_footprint(*entry->resource) + entry->key.capacity();
+
+            next->emplace(hash.low, entry.get());
+
+            T* res = entry->resource.get();
+            shard.counters.live_bytes.fetch_add(entry->bytes, std::memory_order_relaxed);
+            shard.entries.emplace(entry.get(), std::move(entry));
+
+            shard.index.store(next.get(), std::memory_order_release);
+            shard.indices.push_back(std::move(next));
+
+            count.fetch_add(1, std::memory_order_relaxed);
+
+            return *res;
+        }
+
+        static void record_build_time(Shard& shard, std::chrono::steady_clock::time_point start)
+        {
+            auto elapsed = static_cast<uint64_t>(
+                std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - start).count());
+
+            shard.counters.build_time_us.fetch_add(elapsed, std::memory_order_relaxed);
+
+            uint64_t max = shard.counters.max_build_time_us.load(std::memory_order_relaxed);
+            while (max < elapsed && !shard.counters.max_build_time_us.compare_exchange_weak(max, elapsed, std::memory_order_relaxed))
+            {
+            }
+        }
+
+        // Hits are counted in slots picked per thread rather than in the shards, so concurrent lookups of the same hot keys
+        // do not bounce a shared line between cores. Threads beyond the slot count share slots, their counts stay exact.
+        static constexpr size_t HIT_SLOT_COUNT = 64;
+
+        struct alignas(64) HitSlot
+        {
+            std::atomic<uint64_t> hits{ 0 };
+        };
+
+        void count_hit() const
+        {
+            static std::atomic<size_t> next_slot{ 0 };
+            thread_local size_t        slot = next_slot.fetch_add(1, std::memory_order_relaxed) % HIT_SLOT_COUNT;
+
+            hit_slots[slot].hits.fetch_add(1, std::memory_order_relaxed);
+        }
+
+        // Shards are picked from the high half of the hash, independent from the index buckets
+        Shard& get_shard(const HPPHash128& hash)
+        {
+            return shards[hash.high % SHARD_COUNT];
+        }
+
+        const Shard& get_shard(const HPPHash128& hash) const
+        {
+            return shards[hash.high % SHARD_COUNT];
+        }
+
+        std::array<Shard, SHARD_COUNT> shards;
+
+        mutable std::array<HitSlot, HIT_SLOT_COUNT> hit_slots;
+
+        std::atomic<size_t> count{ 0 };
+
+        std::atomic<uint64_t> stamp{ 0 };
+    };
+}
@@ -95,9 +95,9 @@ namespace vkb::allocated
 
         /**
          * @brief Retrieves the raw Vulkan memory object.
-         * @return The Vulkan memory object.
+         * @return The Vulkan memory object, null for wrapped handles the VMA did not allocate.
          */
-        vk::DeviceMemory get_memory() const;
+        vk::DeviceMemory get_memory() const { return memory; }
 
         /**
          * @brief Maps Vulkan memory if it isn't already mapped to a host visible address. Does nothing if the
@@ -162,6 +162,14 @@ namespace vkb::allocated
          */
         uint8_t* mapped_data = nullptr;
 
+        /**
+         * @brief The memory object the allocation lives in.
+         *
+         * @note This is initialized at allocation time, as hashing images asks for it and querying the VMA
+         * every time is wasted work: allocations are never defragmented, so it won't change.
+         */
+        vk::DeviceMemory memory = nullptr;
+
         /**
          * @brief This flag is set to true if the memory is coherent and doesn't need to be flushed after writes.
          *
@@ -186,6 +194,7 @@ namespace vkb::allocated
         allocation_create_info(std::exchange(other.allocation_create_info, {})),
         allocation(std::exchange(other.allocation, {})),
         mapped_data(std::exchange(other.mapped_data, {})),
+        memory(std::exchange(other.memory, {})),
         coherent(std::exchange(other.coherent, {})),
         persistent(std::exchange(other.persistent, {}))
     { }
@@ -202,14 +211,6 @@ namespace vkb::allocated
         ParentType(handle, device_)
     { }
 
-    template <typename HandleType>
-    inline vk::DeviceMemory Allocated<HandleType>::get_memory() const
-    {
-        VmaAllocationInfo alloc_info;
-        vmaGetAllocationInfo(get_memory_allocator(), allocation, &alloc_info);
-        return static_cast<vk::DeviceMemory>(alloc_info.deviceMemory);
-    }
-
     template <typename HandleType>
     inline uint8_t* Allocated<HandleType>::map()
     {
@@ -278,6 +279,7 @@ namespace vkb::allocated
         coherent    = (memory_properties & VK_MEMORY_PROPERTY_HOST_COHERENT_BIT) == VK_MEMORY_PROPERTY_HOST_COHERENT_BIT;
         mapped_data = static_cast<uint8_t*>(allocation_info.pMappedData);
         persistent  = mapped();
+        memory      = static_cast<vk::DeviceMemory>(allocation_info.deviceMemory);
     }
 
     template <typename HandleType>
@@ -295,6 +297,7 @@ namespace vkb::allocated
     inline void Allocated<HandleType>::clear()
     {
         mapped_data            = nullptr;
+        memory                 = nullptr;
         persistent             = false;
         allocation_create_info = {};
     }
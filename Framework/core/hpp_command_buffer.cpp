@@ -2,6 +2,38 @@
 
 namespace vkb::core
 {
+    namespace
+    {
+        // Dynamic state values are plain floats and integers, equal bytes mean an equal state
+        template <class T>
+        inline bool same_value(const std::optional<T>& recorded, const T& value)
+        {
+            return recorded && std::memcmp(&*recorded, &value, sizeof(T)) == 0;
+        }
+
+        // Records the values for the slots starting at first, returns false if they were all recorded already
+        template <class T>
+        inline bool update_slots(std::vector<std::optional<T>>& recorded, uint32_t first, const std::vector<T>& values)
+        {
+            if (recorded.size() < first + values.size())
+            {
+                recorded.resize(first + values.size());
+            }
+
+            bool changed = false;
+            for (size_t i = 0; i < values.size(); i++)
+            {
+                if (!same_value(recorded[first + i], values[i]))
+                {
+                    recorded[first + i] = values[i];
+                    changed             = true;
+                }
+            }
+
+            return changed;
+        }
+    }
+
     HPPCommandBuffer::HPPCommandBuffer(HPPCommandPool& command_pool, vk::CommandBufferLevel level) :
         VulkanResource<vk::CommandBuffer>(nullptr, &command_pool.get_device()),
         command_pool{ command_pool },
@@ -58,18 +90,51 @@ namespace vkb::core
         begin_render_pass(render_target, render_pass, framebuffer, clear_values, contents);
     }
 
+    void HPPCommandBuffer::begin_render_pass(const vkb::rendering::HPPRenderTarget& render_target,
+                                             const HPPRenderPassDesc&               render_pass_desc,
+                                             const std::vector<vk::ClearValue>&     clear_values,
+                                             vk::SubpassContents                    contents)
+    {
+        auto& render_pass = get_render_pass(render_target, render_pass_desc);
+        auto& framebuffer = this->get_device().get_resource_cache().request_framebuffer(render_target, render_pass);
+
+        begin_render_pass(render_target, render_pass, framebuffer, clear_values, contents);
+    }
+
     void HPPCommandBuffer::begin_render_pass(const vkb::rendering::HPPRenderTarget& render_target,
                                              const HPPRenderPass&                   render_pass,
                                              const HPPFramebuffer&                  framebuffer,
                                              const std::vector<vk::ClearValue>&     clear_values,
                                              vk::SubpassContents                    contents)
     {
-        // TODO
+        current_render_pass = &render_pass;
+        current_framebuffer = &framebuffer;
+
+        vk::RenderPassBeginInfo begin_info{ current_render_pass->get_handle(),
+                                            current_framebuffer->get_handle(),
+                                            { {}, render_target.get_extent() },
+                                            clear_values };
+
+        this->get_handle().beginRenderPass(begin_info, contents);
+
+        pipeline_state.set_render_pass(render_pass);
+        pipeline_state.set_subpass_index(0);
+
+        update_color_blend_attachments();
     }
 
     void HPPCommandBuffer::next_subpass()
     {
-        // TODO
+        pipeline_state.set_subpass_index(pipeline_state.get_subpass_index() + 1);
+
+        update_color_blend_attachments();
+
+        this->get_handle().nextSubpass(vk::SubpassContents::eInline);
+    }
+
+    void HPPCommandBuffer::end_render_pass()
+    {
+        this->get_handle().endRenderPass();
     }
 
     const HPPRenderPass& HPPCommandBuffer::get_render_pass(const vkb::rendering::HPPRenderTarget&                          render_target,
@@ -97,6 +162,13 @@ namespace vkb::core
         return this->get_device().get_resource_cache().request_render_pass(render_target.get_attachments(), load_store_infos, subpass_infos);
     }
 
+    const HPPRenderPass& HPPCommandBuffer::get_render_pass(const vkb::rendering::HPPRenderTarget& render_target, const HPPRenderPassDesc& render_pass_desc)
+    {
+        assert(!render_pass_desc.get_subpasses().empty() && "Cannot create a render pass without any subpass");
+
+        return this->get_device().get_resource_cache().request_render_pass(render_target.get_attachments(), render_pass_desc);
+    }
+
     void HPPCommandBuffer::end()
     {
         this->get_handle().end();
@@ -111,6 +183,8 @@ namespace vkb::core
             this->get_handle().reset(vk::CommandBufferResetFlagBits::eReleaseResources);
         }
 
+        reset_bindings();
+
         return vk::Result::eSuccess;
     }
 
@@ -147,10 +221,225 @@ namespace vkb::core
         this->get_handle().pipelineBarrier(src_stage_mask, dst_stage_mask, {}, {}, {}, image_memory_barrier);
     }
 
+    void HPPCommandBuffer::bind_pipeline_layout(HPPPipelineLayout& pipeline_layout)
+    {
+        pipeline_state.set_pipeline_layout(pipeline_layout);
+    }
+
+    void HPPCommandBuffer::set_vertex_input_state(const vkb::rendering::HPPVertexInputState& state_info)
+    {
+        pipeline_state.set_vertex_input_state(state_info);
+    }
+
+    void HPPCommandBuffer::set_input_assembly_state(const vkb::rendering::HPPInputAssemblyState& state_info)
+    {
+        pipeline_state.set_input_assembly_state(state_info);
+    }
+
+    void HPPCommandBuffer::set_viewport_state(const vkb::rendering::HPPViewportState& state_info)
+    {
+        pipeline_state.set_viewport_state(state_info);
+    }
+
+    void HPPCommandBuffer::set_rasterization_state(const vkb::rendering::HPPRasterizationState& state_info)
+    {
+        pipeline_state.set_rasterization_state(state_info);
+    }
+
+    void HPPCommandBuffer::set_multisample_state(const vkb::rendering::HPPMultisampleState& state_info)
+    {
+        pipeline_state.set_multisample_state(state_info);
+    }
+
+    void HPPCommandBuffer::set_depth_stencil_state(const vkb::rendering::HPPDepthStencilState& state_info)
+    {
+        pipeline_state.set_depth_stencil_state(state_info);
+    }
+
+    void HPPCommandBuffer::set_color_blend_state(const vkb::rendering::HPPColorBlendState& state_info)
+    {
+        pipeline_state.set_color_blend_state(state_info);
+    }
+
+    void HPPCommandBuffer::bind_descriptor_set(uint32_t set_index, vk::DescriptorSet descriptor_set, const std::vector<uint32_t>& dynamic_offsets)
+    {
+        auto& pipeline_layout = pipeline_state.get_pipeline_layout();
+
+        // Sets bound with an incompatible layout are disturbed by the change of layout
+        if (bound_pipeline_layout != &pipeline_layout)
+        {
+            uint32_t compatible_count = bound_pipeline_layout ? bound_pipeline_layout->get_compatible_set_count(pipeline_layout) : 0;
+
+            if (bound_descriptor_sets.size() > compatible_count)
+            {
+                bound_descriptor_sets.resize(compatible_count);
+            }
+
+            bound_pipeline_layout = &pipeline_layout;
+        }
+
+        if (set_index < bound_descriptor_sets.size() && bound_descriptor_sets[set_index].handle == descriptor_set &&
+            bound_descriptor_sets[set_index].dynamic_offsets == dynamic_offsets)
+        {
+            stats.descriptor_set_binds_elided++;
+            return;
+        }
+
+        this->get_handle().bindDescriptorSets(vk::PipelineBindPoint::eGraphics, pipeline_layout.get_handle(), set_index, descriptor_set, dynamic_offsets);
+
+        if (bound_descriptor_sets.size() <= set_index)
+        {
+            bound_descriptor_sets.resize(set_index + 1);
+        }
+
+        bound_descriptor_sets[set_index] = { descriptor_set, dynamic_offsets };
+
+        stats.descriptor_set_binds++;
+    }
+
+    void HPPCommandBuffer::set_viewport(uint32_t first_viewport, const std::vector<vk::Viewport>& new_viewports)
+    {
+        if (!update_slots(viewports, first_viewport, new_viewports))
+        {
+            stats.dynamic_states_elided++;
+            return;
+        }
+
+        this->get_handle().setViewport(first_viewport, new_viewports);
+        stats.dynamic_states++;
+    }
+
+    void HPPCommandBuffer::set_scissor(uint32_t first_scissor, const std::vector<vk::Rect2D>& new_scissors)
+    {
+        if (!update_slots(scissors, first_scissor, new_scissors))
+        {
+            stats.dynamic_states_elided++;
+            return;
+        }
+
+        this->get_handle().setScissor(first_scissor, new_scissors);
+        stats.dynamic_states++;
+    }
+
+    void HPPCommandBuffer::set_line_width(float new_line_width)
+    {
+        if (same_value(line_width, new_line_width))
+        {
+            stats.dynamic_states_elided++;
+            return;
+        }
+
+        line_width = new_line_width;
+
+        this->get_handle().setLineWidth(new_line_width);
+        stats.dynamic_states++;
+    }
+
+    void HPPCommandBuffer::set_depth_bias(float depth_bias_constant_factor, float depth_bias_clamp, float depth_bias_slope_factor)
+    {
+        std::array<float, 3> new_depth_bias{ depth_bias_constant_factor, depth_bias_clamp, depth_bias_slope_factor };
+
+        if (same_value(depth_bias, new_depth_bias))
+        {
+            stats.dynamic_states_elided++;
+            return;
+        }
+
+        depth_bias = new_depth_bias;
+
+        this->get_handle().setDepthBias(depth_bias_constant_factor, depth_bias_clamp, depth_bias_slope_factor);
+        stats.dynamic_states++;
+    }
+
+    void HPPCommandBuffer::set_blend_constants(const std::array<float, 4>& new_blend_constants)
+    {
+        if (same_value(blend_constants, new_blend_constants))
+        {
+            stats.dynamic_states_elided++;
+            return;
+        }
+
+        blend_constants = new_blend_constants;
+
+        this->get_handle().setBlendConstants(new_blend_constants.data());
+        stats.dynamic_states++;
+    }
+
+    void HPPCommandBuffer::set_depth_bounds(float min_depth_bounds, float max_depth_bounds)
+    {
+        std::array<float, 2> new_depth_bounds{ min_depth_bounds, max_depth_bounds };
+
+        if (same_value(depth_bounds, new_depth_bounds))
+        {
+            stats.dynamic_states_elided++;
+            return;
+        }
+
+        depth_bounds = new_depth_bounds;
+
+        this->get_handle().setDepthBounds(min_depth_bounds, max_depth_bounds);
+        stats.dynamic_states++;
+    }
+
+    void HPPCommandBuffer::set_stencil_compare_mask(vk::StencilFaceFlags face_mask, uint32_t compare_mask)
+    {
+        if (update_stencil_values(stencil_compare_masks, face_mask, compare_mask))
+        {
+            this->get_handle().setStencilCompareMask(face_mask, compare_mask);
+        }
+    }
+
+    void HPPCommandBuffer::set_stencil_write_mask(vk::StencilFaceFlags face_mask, uint32_t write_mask)
+    {
+        if (update_stencil_values(stencil_write_masks, face_mask, write_mask))
+        {
+            this->get_handle().setStencilWriteMask(face_mask, write_mask);
+        }
+    }
+
+    void HPPCommandBuffer::set_stencil_reference(vk::StencilFaceFlags face_mask, uint32_t reference)
+    {
+        if (update_stencil_values(stencil_references, face_mask, reference))
+        {
+            this->get_handle().setStencilReference(face_mask, reference);
+        }
+    }
+
+    void HPPCommandBuffer::set_async_pipeline_compile(bool enable, const HPPGraphicsPipeline* new_fallback_pipeline)
+    {
+        async_pipeline_compile = enable;
+        fallback_pipeline      = new_fallback_pipeline;
+    }
+
+    void HPPCommandBuffer::draw(uint32_t vertex_count, uint32_t instance_count, uint32_t first_vertex, uint32_t first_instance)
+    {
+        if (!flush_pipeline_state())
+        {
+            return;
+        }
+
+        this->get_handle().draw(vertex_count, instance_count, first_vertex, first_instance);
+    }
+
+    void HPPCommandBuffer::draw_indexed(uint32_t index_count, uint32_t instance_count, uint32_t first_index, int32_t vertex_offset, uint32_t first_instance)
+    {
+        if (!flush_pipeline_state())
+        {
+            return;
+        }
+
+        this->get_handle().drawIndexed(index_count, instance_count, first_index, vertex_offset, first_instance);
+    }
+
     void HPPCommandBuffer::begin_impl(vk::CommandBufferUsageFlags flags, const HPPRenderPass* render_pass, const HPPFramebuffer* framebuffer, uint32_t subpass_index)
     {
         // TODO
 
+        pipeline_state.reset();
+        reset_bindings();
+
+        stats = {};
+
         vk::CommandBufferBeginInfo begin_info{ flags };
         vk::CommandBufferInheritanceInfo inheritance;
 
@@ -166,8 +455,112 @@ namespace vkb::core
             inheritance.subpass = subpass_index;
 
             begin_info.pInheritanceInfo = &inheritance;
+
+            pipeline_state.set_render_pass(*current_render_pass);
+            pipeline_state.set_subpass_index(subpass_index);
+
+            update_color_blend_attachments();
         }
 
         this->get_handle().begin(begin_info);
     }
+
+    void HPPCommandBuffer::reset_bindings()
+    {
+        pipeline_pending      = false;
+        bound_pipeline        = nullptr;
+        bound_pipeline_layout = nullptr;
+        bound_descriptor_sets.clear();
+
+        viewports.clear();
+        scissors.clear();
+        line_width.reset();
+        depth_bias.reset();
+        blend_constants.reset();
+        depth_bounds.reset();
+        stencil_compare_masks = {};
+        stencil_write_masks   = {};
+        stencil_references    = {};
+    }
+
+    void HPPCommandBuffer::update_color_blend_attachments()
+    {
+        auto color_blend_state = pipeline_state.get_color_blend_state();
+        color_blend_state.attachments.resize(current_render_pass->get_color_output_count(pipeline_state.get_subpass_index()));
+
+        pipeline_state.set_color_blend_state(color_blend_state);
+    }
+
+    bool HPPCommandBuffer::flush_pipeline_state()
+    {
+        // Nothing is bound at the start of the command buffer, even if the state is still the default one
+        if (!pipeline_state.is_dirty() && bound_pipeline && !pipeline_pending)
+        {
+            return true;
+        }
+
+        auto& resource_cache = this->get_device().get_resource_cache();
+
+        const HPPGraphicsPipeline* pipeline = async_pipeline_compile ? resource_cache.request_graphics_pipeline_async(pipeline_state).get() :
+                                                                       &resource_cache.request_graphics_pipeline(pipeline_state);
+
+        pipeline_state.clear_dirty();
+
+        // Checked again by every draw until it is ready
+        pipeline_pending = !pipeline;
+
+        if (!pipeline)
+        {
+            if (!fallback_pipeline)
+            {
+                stats.draws_skipped++;
+                return false;
+            }
+
+            pipeline = fallback_pipeline;
+            stats.fallback_draws++;
+        }
+
+        // A state changed back to the one of the bound pipeline resolves to the same handle
+        if (pipeline->get_handle() != bound_pipeline)
+        {
+            this->get_handle().bindPipeline(vk::PipelineBindPoint::eGraphics, pipeline->get_handle());
+
+            bound_pipeline = pipeline->get_handle();
+            stats.pipeline_binds++;
+        }
+        else
+        {
+            stats.pipeline_binds_elided++;
+        }
+
+        return true;
+    }
+
+    bool HPPCommandBuffer::update_stencil_values(StencilValues& values, vk::StencilFaceFlags face_mask, uint32_t value)
+    {
+        bool changed = false;
+
+        if ((face_mask & vk::StencilFaceFlagBits::eFront) && !same_value(values.front, value))
+        {
+            values.front = value;
+            changed      = true;
+        }
+        if ((face_mask & vk::StencilFaceFlagBits::eBack) && !same_value(values.back, value))
+        {
+            values.back = value;
+            changed     = true;
+        }
+
+        if (changed)
+        {
+            stats.dynamic_states++;
+        }
+        else
+        {
+            stats.dynamic_states_elided++;
+        }
+
+        return changed;
+    }
 }
\ No newline at end of file
@@ -9,6 +9,21 @@ namespace vkb::rendering
 
 namespace vkb::core
 {
+    /**
+     * @brief Counters of the commands recorded, and of those skipped as they would not have changed any state
+     */
+    struct HPPCommandBufferStats
+    {
+        uint32_t pipeline_binds              = 0;
+        uint32_t pipeline_binds_elided       = 0;        // The state changed but resolved to the bound pipeline
+        uint32_t descriptor_set_binds        = 0;
+        uint32_t descriptor_set_binds_elided = 0;
+        uint32_t dynamic_states              = 0;
+        uint32_t dynamic_states_elided       = 0;
+        uint32_t draws_skipped               = 0;        // Their pipeline was compiling and there was no fallback
+        uint32_t fallback_draws              = 0;        // Drawn with the fallback while their pipeline was compiling
+    };
+
     /**
      * @brief Helper class to manage and record a command buffer, building and
      *        keeping track of pipeline state and resource bindings
@@ -51,6 +66,11 @@ namespace vkb::core
                                                const std::vector<std::unique_ptr<vkb::rendering::HPPSubpass>>& subpasses,
                                                vk::SubpassContents                                             contents = vk::SubpassContents::eInline);
 
+        void                 begin_render_pass(const vkb::rendering::HPPRenderTarget& render_target,
+                                               const HPPRenderPassDesc&               render_pass_desc,
+                                               const std::vector<vk::ClearValue>&     clear_values,
+                                               vk::SubpassContents                    contents = vk::SubpassContents::eInline);
+
         void                 begin_render_pass(const vkb::rendering::HPPRenderTarget& render_target,
                                                const HPPRenderPass&                   render_pass,
                                                const HPPFramebuffer&                  framebuffer,
@@ -58,9 +78,11 @@ namespace vkb::core
                                                vk::SubpassContents                    contents = vk::SubpassContents::eInline);
 
         void                 next_subpass();
+        void                 end_render_pass();
         const HPPRenderPass& get_render_pass(const vkb::rendering::HPPRenderTarget&                          render_target,
                                              const std::vector<HPPLoadStoreInfo>&                            load_store_infos,
                                              const std::vector<std::unique_ptr<vkb::rendering::HPPSubpass>>& subpasses);
+        const HPPRenderPass& get_render_pass(const vkb::rendering::HPPRenderTarget& render_target, const HPPRenderPassDesc& render_pass_desc);
 
         void                 end();
 
@@ -72,14 +94,103 @@ namespace vkb::core
 
         void image_memory_barrier(const HPPImageView& image_view, const vkb::HPPImageMemoryBarrier& memory_barrier) const;
 
+        /**
+         * @brief The pipeline state setters only record the state, the pipeline is resolved and bound by the next draw,
+         *        and only if a sub-state changed since the previous one
+         */
+        void bind_pipeline_layout(HPPPipelineLayout& pipeline_layout);
+        void set_vertex_input_state(const vkb::rendering::HPPVertexInputState& state_info);
+        void set_input_assembly_state(const vkb::rendering::HPPInputAssemblyState& state_info);
+        void set_viewport_state(const vkb::rendering::HPPViewportState& state_info);
+        void set_rasterization_state(const vkb::rendering::HPPRasterizationState& state_info);
+        void set_multisample_state(const vkb::rendering::HPPMultisampleState& state_info);
+        void set_depth_stencil_state(const vkb::rendering::HPPDepthStencilState& state_info);
+        void set_color_blend_state(const vkb::rendering::HPPColorBlendState& state_info);
+
+        /**
+         * @brief Binds a descriptor set with the current pipeline layout, skipped if the same set and offsets are still bound.
+         *        Sets bound with a previous layout stay bound as far as the layouts are compatible.
+         */
+        void bind_descriptor_set(uint32_t set_index, vk::DescriptorSet descriptor_set, const std::vector<uint32_t>& dynamic_offsets = {});
+
+        /**
+         * @brief The dynamic state setters are skipped when the value recorded last is set again
+         */
+        void set_viewport(uint32_t first_viewport, const std::vector<vk::Viewport>& viewports);
+        void set_scissor(uint32_t first_scissor, const std::vector<vk::Rect2D>& scissors);
+        void set_line_width(float line_width);
+        void set_depth_bias(float depth_bias_constant_factor, float depth_bias_clamp, float depth_bias_slope_factor);
+        void set_blend_constants(const std::array<float, 4>& blend_constants);
+        void set_depth_bounds(float min_depth_bounds, float max_depth_bounds);
+        void set_stencil_compare_mask(vk::StencilFaceFlags face_mask, uint32_t compare_mask);
+        void set_stencil_write_mask(vk::StencilFaceFlags face_mask, uint32_t write_mask);
+        void set_stencil_reference(vk::StencilFaceFlags face_mask, uint32_t reference);
+
+        /**
+         * @brief Sets whether draws wait for their pipeline to compile, or are recorded while it compiles in the background.
+         *        Such draws are drawn with the fallback pipeline if there is one, and skipped otherwise. The fallback must
+         *        be compatible with the current subpass and with the layout of the bound descriptor sets.
+         */
+        void set_async_pipeline_compile(bool enable, const HPPGraphicsPipeline* fallback_pipeline = nullptr);
+
+        void draw(uint32_t vertex_count, uint32_t instance_count, uint32_t first_vertex, uint32_t first_instance);
+        void draw_indexed(uint32_t index_count, uint32_t instance_count, uint32_t first_index, int32_t vertex_offset, uint32_t first_instance);
+
+        const HPPCommandBufferStats& get_stats() const { return stats; }
+
     private:
+        // The values last recorded, per stencil face
+        struct StencilValues
+        {
+            std::optional<uint32_t> front;
+            std::optional<uint32_t> back;
+        };
+
+        struct BoundDescriptorSet
+        {
+            vk::DescriptorSet     handle;
+            std::vector<uint32_t> dynamic_offsets;
+        };
+
         void begin_impl(vk::CommandBufferUsageFlags flags, const HPPRenderPass* render_pass, const HPPFramebuffer* framebuffer, uint32_t subpass_index);
 
+        // Forgets all the bindings and dynamic states, as at the start of a command buffer
+        void reset_bindings();
+
+        void update_color_blend_attachments();
+
+        // Resolves and binds the pipeline for the current state, if it changed since the last draw.
+        // Returns false if the draw has no pipeline to use.
+        bool flush_pipeline_state();
+
+        // Returns true if the values differ from the ones last recorded for the faces, and records them
+        bool update_stencil_values(StencilValues& values, vk::StencilFaceFlags face_mask, uint32_t value);
+
     private:
         HPPCommandPool&                  command_pool;
         const HPPRenderPass*             current_render_pass = nullptr;
         const HPPFramebuffer*            current_framebuffer = nullptr;
         const vk::CommandBufferLevel     level = {};
         vkb::rendering::HPPPipelineState pipeline_state = {};
+
+        bool                       async_pipeline_compile = false;
+        const HPPGraphicsPipeline* fallback_pipeline      = nullptr;
+        bool                       pipeline_pending       = false;        // The pipeline of the state was compiling at the last draw
+
+        vk::Pipeline                    bound_pipeline;
+        const HPPPipelineLayout*        bound_pipeline_layout = nullptr;
+        std::vector<BoundDescriptorSet> bound_descriptor_sets;
+
+        std::vector<std::optional<vk::Viewport>> viewports;
+        std::vector<std::optional<vk::Rect2D>>   scissors;
+        std::optional<float>                     line_width;
+        std::optional<std::array<float, 3>>      depth_bias;
+        std::optional<std::array<float, 4>>      blend_constants;
+        std::optional<std::array<float, 2>>      depth_bounds;
+        StencilValues                            stencil_compare_masks;
+        StencilValues                            stencil_write_masks;
+        StencilValues                            stencil_references;
+
+        HPPCommandBufferStats stats;
     };
 }
\ No newline at end of file
@@ -0,0 +1,147 @@
+#include "stdafx.h"
+
+namespace vkb::core
+{
+    namespace
+    {
+        inline vk::DescriptorType find_descriptor_type(HPPShaderResourceType resource_type, bool dynamic)
+        {
+            switch (resource_type)
+            {
+            case HPPShaderResourceType::InputAttachment:
+                return vk::DescriptorType::eInputAttachment;
+            case HPPShaderResourceType::Image:
+                return vk::DescriptorType::eSampledImage;
+            case HPPShaderResourceType::ImageSampler:
+                return vk::DescriptorType::eCombinedImageSampler;
+            case HPPShaderResourceType::ImageStorage:
+                return vk::DescriptorType::eStorageImage;
+            case HPPShaderResourceType::Sampler:
+                return vk::DescriptorType::eSampler;
+            case HPPShaderResourceType::BufferUniform:
+                return dynamic ? vk::DescriptorType::eUniformBufferDynamic : vk::DescriptorType::eUniformBuffer;
+            case HPPShaderResourceType::BufferStorage:
+                return dynamic ? vk::DescriptorType::eStorageBufferDynamic : vk::DescriptorType::eStorageBuffer;
+            default:
+                throw std::runtime_error("No conversion possible for the shader resource type.");
+            }
+        }
+
+        inline bool binding_less(const vk::DescriptorSetLayoutBinding& binding, uint32_t binding_index)
+        {
+            return binding.binding < binding_index;
+        }
+    }
+
+    HPPDescriptorSetLayoutSignature::HPPDescriptorSetLayoutSignature(const std::vector<HPPShaderResource>& resource_set)
+    {
+        std::vector<std::pair<vk::DescriptorSetLayoutBinding, vk::DescriptorBindingFlagsEXT>> entries;
+        entries.reserve(resource_set.size());
+
+        for (auto& resource : resource_set)
+        {
+            // Skip shader resources without a binding point
+            if (resource.type == HPPShaderResourceType::Input ||
+                resource.type == HPPShaderResourceType::Output ||
+                resource.type == HPPShaderResourceType::PushConstant ||
+                resource.type == HPPShaderResourceType::SpecializationConstant)
+            {
+                continue;
+            }
+
+            // When creating a descriptor set layout with update after bind, all its bindings need a flag
+            vk::DescriptorBindingFlagsEXT flags;
+            if (resource.mode == HPPShaderResourceMode::UpdateAfterBind)
+            {
+                flags = vk::DescriptorBindingFlagBitsEXT::eUpdateAfterBind;
+            }
+
+            auto descriptor_type = find_descriptor_type(resource.type, resource.mode == HPPShaderResourceMode::Dynamic);
+
+            entries.emplace_back(vk::DescriptorSetLayoutBinding{ resource.binding, descriptor_type, resource.array_size, resource.stages }, flags);
+        }
+
+        // The resources of a set come in no particular order, sort them so equal sets get equal signatures
+        std::ranges::sort(entries, [](const auto& a, const auto& b) { return a.first.binding < b.first.binding; });
+
+        for (auto& [binding, flags] : entries)
+        {
+            // Resources of other names sharing a binding, e.g. a block named differently in two stages
+            if (!bindings.empty() && bindings.back().binding == binding.binding)
+            {
+                if (bindings.back().descriptorType != binding.descriptorType)
+                {
+                    throw std::runtime_error("Cannot create descriptor set layout, binding " + std::to_string(binding.binding) + " is used by resources of different types.");
+                }
+
+                auto& merged = bindings.back();
+
+                merged.stageFlags      |= binding.stageFlags;
+                merged.descriptorCount = std::max(merged.descriptorCount, binding.descriptorCount);
+                binding_flags.back()   |= flags;
+                continue;
+            }
+
+            bindings.push_back(binding);
+            binding_flags.push_back(flags);
+        }
+    }
+
+    HPPDescriptorSetLayout::HPPDescriptorSetLayout(HPPDevice& device, const HPPDescriptorSetLayoutSignature& signature) :
+        device{ device },
+        bindings{ signature.bindings },
+        binding_flags{ signature.binding_flags }
+    {
+        bool update_after_bind = std::ranges::any_of(binding_flags, [](vk::DescriptorBindingFlagsEXT flags) { return !!(flags & vk::DescriptorBindingFlagBitsEXT::eUpdateAfterBind); });
+
+        vk::DescriptorSetLayoutCreateInfo create_info{ {}, bindings };
+
+        vk::DescriptorSetLayoutBindingFlagsCreateInfoEXT binding_flags_create_info{ binding_flags };
+
+        if (update_after_bind)
+        {
+            if (std::ranges::find_if(bindings, [](const vk::DescriptorSetLayoutBinding& binding) {
+                    return binding.descriptorType == vk::DescriptorType::eUniformBufferDynamic || binding.descriptorType == vk::DescriptorType::eStorageBufferDynamic;
+                }) != bindings.end())
+            {
+                throw std::runtime_error("Cannot create descriptor set layout, dynamic resources are not allowed if at least one resource is update-after-bind.");
+            }
+
+            create_info.flags |= vk::DescriptorSetLayoutCreateFlagBits::eUpdateAfterBindPoolEXT;
+            create_info.pNext = &binding_flags_create_info;
+        }
+
+        handle = device.get_handle().createDescriptorSetLayout(create_info);
+    }
+
+    HPPDescriptorSetLayout::HPPDescriptorSetLayout(HPPDescriptorSetLayout&& other) :
+        device{ other.device },
+        handle{ other.handle },
+        bindings{ std::move(other.bindings) },
+        binding_flags{ std::move(other.binding_flags) }
+    {
+        other.handle = nullptr;
+    }
+
+    HPPDescriptorSetLayout::~HPPDescriptorSetLayout()
+    {
+        if (handle)
+        {
+            device.get_handle().destroyDescriptorSetLayout(handle);
+        }
+    }
+
+    const vk::DescriptorSetLayoutBinding* HPPDescriptorSetLayout::get_layout_binding(uint32_t binding_index) const
+    {
+        auto it = std::lower_bound(bindings.begin(), bindings.end(), binding_index, binding_less);
+
+        return it != bindings.end() && it->binding == binding_index ? &*it : nullptr;
+    }
+
+    vk::DescriptorBindingFlagsEXT HPPDescriptorSetLayout::get_layout_binding_flag(uint32_t binding_index) const
+    {
+        auto it = std::lower_bound(bindings.begin(), bindings.end(), binding_index, binding_less);
+
+        return it != bindings.end() && it->binding == binding_index ? binding_flags[it - bindings.begin()] : vk::DescriptorBindingFlagsEXT{};
+    }
+}
\ No newline at end of file
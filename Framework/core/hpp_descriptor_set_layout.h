@@ -0,0 +1,66 @@
+#pragma once
+
+#include "hpp_shader_module.h"
+
+namespace vkb::core
+{
+    class HPPDevice;
+
+    /**
+     * @brief The bindings of a descriptor set layout, all that identifies it to Vulkan.
+     *        Sets holding resources of other names, used by other shader modules or bound at another index
+     *        share a layout if their signatures are equal.
+     */
+    struct HPPDescriptorSetLayoutSignature
+    {
+        HPPDescriptorSetLayoutSignature() = default;
+
+        /**
+         * @brief Builds the signature of a set from its reflected resources, resources without a binding point are skipped
+         * @throws std::runtime_error if two resources of different types share a binding
+         */
+        explicit HPPDescriptorSetLayoutSignature(const std::vector<HPPShaderResource>& resource_set);
+
+        std::vector<vk::DescriptorSetLayoutBinding> bindings;             // Sorted by binding index
+        std::vector<vk::DescriptorBindingFlagsEXT>  binding_flags;        // The flags of each binding
+    };
+
+    /**
+     * @brief A descriptor set layout, shared by all the sets of the same signature
+     */
+    class HPPDescriptorSetLayout
+    {
+    public:
+        /**
+         * @brief Creates a descriptor set layout from its bindings
+         * @param device A valid Vulkan device
+         * @param signature The bindings of the layout
+         * @throws std::runtime_error if dynamic resources are mixed with update-after-bind ones
+         */
+        HPPDescriptorSetLayout(HPPDevice& device, const HPPDescriptorSetLayoutSignature& signature);
+        ~HPPDescriptorSetLayout();
+
+        HPPDescriptorSetLayout(const HPPDescriptorSetLayout&) = delete;
+        HPPDescriptorSetLayout(HPPDescriptorSetLayout&& other);
+
+        HPPDescriptorSetLayout& operator=(const HPPDescriptorSetLayout&) = delete;
+        HPPDescriptorSetLayout& operator=(HPPDescriptorSetLayout&&) = delete;
+
+        vk::DescriptorSetLayout                            get_handle() const        { return handle; }
+        const std::vector<vk::DescriptorSetLayoutBinding>& get_bindings() const      { return bindings; }
+        const std::vector<vk::DescriptorBindingFlagsEXT>&  get_binding_flags() const { return binding_flags; }
+
+        /**
+         * @brief Returns the layout binding of a binding index, or nullptr if the set does not use it
+         */
+        const vk::DescriptorSetLayoutBinding* get_layout_binding(uint32_t binding_index) const;
+
+        vk::DescriptorBindingFlagsEXT get_layout_binding_flag(uint32_t binding_index) const;
+
+    private:
+        HPPDevice&                                  device;
+        vk::DescriptorSetLayout                     handle;
+        std::vector<vk::DescriptorSetLayoutBinding> bindings;
+        std::vector<vk::DescriptorBindingFlagsEXT>  binding_flags;
+    };
+}
\ No newline at end of file
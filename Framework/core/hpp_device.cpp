@@ -120,11 +120,16 @@ namespace vkb::core
 
         vkb::allocated::init(*this);
 
+        resource_cache.create_pipeline_cache();
+
         // TODO
     }
 
     HPPDevice::~HPPDevice()
     {
+        resource_cache.destroy_pipeline_cache();
+        resource_cache.clear();
+
         vkb::allocated::shutdown();
 
         if (get_handle())
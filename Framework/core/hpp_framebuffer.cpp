@@ -6,7 +6,8 @@ namespace vkb::core
                                    const vkb::rendering::HPPRenderTarget& render_target,
                                    const HPPRenderPass& render_pass) :
         device{ device },
-        extent{ render_target.get_extent() }
+        extent{ render_target.get_extent() },
+        render_target_generation{ render_target.get_generation() }
     {
         std::vector<vk::ImageView> attachments;
 
@@ -39,7 +40,8 @@ namespace vkb::core
     HPPFramebuffer::HPPFramebuffer(HPPFramebuffer&& other) :
         device{ other.device },
         handle{ other.handle },
-        extent{ other.extent }
+        extent{ other.extent },
+        render_target_generation{ other.render_target_generation }
     {
         other.handle = nullptr;
     }
@@ -21,8 +21,9 @@ namespace vkb::core
         HPPFramebuffer& operator=(const HPPFramebuffer&) = delete;
         HPPFramebuffer& operator=(HPPFramebuffer&&) = delete;
 
-        vk::Framebuffer     get_handle() const { return handle; }
-        const vk::Extent2D& get_extent() const { return extent; }
+        vk::Framebuffer     get_handle() const                   { return handle; }
+        const vk::Extent2D& get_extent() const                   { return extent; }
+        uint64_t            get_render_target_generation() const { return render_target_generation; }
 
     private:
         HPPDevice& device;
@@ -30,5 +31,8 @@ namespace vkb::core
         vk::Framebuffer handle{ nullptr };
         
         vk::Extent2D extent{};
+
+        // Generation of the render target the framebuffer was created with, to release it along with it
+        uint64_t render_target_generation = 0;
     };
 }
\ No newline at end of file
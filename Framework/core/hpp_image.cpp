@@ -94,7 +94,8 @@ namespace vkb::core
         vkb::allocated::Allocated<vk::Image>{ std::move(other) },
         create_info(std::exchange(other.create_info, {})),
         subresource(std::exchange(other.subresource, {})),
-        views(std::exchange(other.views, {}))
+        views(std::exchange(other.views, {})),
+        generation(other.generation)
     {
         // Update image views reference to this image to avoid dangling pointers
         for (auto& view : views)
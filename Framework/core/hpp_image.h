@@ -129,10 +129,12 @@ namespace vkb::core
         vk::ImageSubresource               get_subresource() const       { return subresource; }
         uint32_t                           get_array_layer_count() const { return create_info.arrayLayers; }
         std::unordered_set<HPPImageView*>& get_views()                   { return views; }
+        uint64_t                           get_generation() const        { return generation; }
 
     private:
         vk::ImageCreateInfo               create_info;
         vk::ImageSubresource              subresource;
         std::unordered_set<HPPImageView*> views;        /// HPPImage views referring to this image
+        uint64_t                          generation = next_generation_id();
     };
 }
\ No newline at end of file
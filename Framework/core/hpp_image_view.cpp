@@ -49,7 +49,7 @@ namespace vkb::core
     }
 
     HPPImageView::HPPImageView(HPPImageView&& other) :
-        VulkanResource{ std::move(other) }, image{ other.image }, format{ other.format }, subresource_range{ other.subresource_range }
+        VulkanResource{ std::move(other) }, image{ other.image }, format{ other.format }, subresource_range{ other.subresource_range }, generation{ other.generation }
     {
         // Remove old view from image set and add this new one
         auto& views = image->get_views();
@@ -22,6 +22,7 @@ namespace vkb::core
         HPPImageView& operator=(HPPImageView&&)      = delete;
 
         vk::Format                 get_format() const            { return format; }
+        uint64_t                   get_generation() const        { return generation; }
         const HPPImage&            get_image() const             { return *image; }
         void                       set_image(HPPImage& img)      { image = &img; }
         vk::ImageSubresourceRange  get_subresource_range() const { return subresource_range; }
@@ -36,5 +37,6 @@ namespace vkb::core
         HPPImage*                 image = nullptr;
         vk::Format                format;
         vk::ImageSubresourceRange subresource_range;
+        uint64_t                  generation = next_generation_id();
     };
 }
\ No newline at end of file
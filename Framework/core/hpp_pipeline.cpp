@@ -0,0 +1,158 @@
+#include "stdafx.h"
+
+namespace vkb::core
+{
+    HPPPipeline::HPPPipeline(HPPDevice& device) :
+        device{ device }
+    { }
+
+    HPPPipeline::HPPPipeline(HPPPipeline&& other) :
+        device{ other.device },
+        handle{ other.handle },
+        state{ other.state }
+    {
+        other.handle = nullptr;
+    }
+
+    HPPPipeline::~HPPPipeline()
+    {
+        // Destroy pipeline
+        if (handle)
+        {
+            device.get_handle().destroyPipeline(handle);
+        }
+    }
+
+    HPPGraphicsPipeline::HPPGraphicsPipeline(HPPDevice& device, const vkb::rendering::HPPPipelineState& pipeline_state) :
+        HPPPipeline{ device }
+    {
+        state = pipeline_state;
+
+        auto& pipeline_layout = pipeline_state.get_pipeline_layout();
+
+        std::vector<vk::ShaderModule>                  shader_modules;
+        std::vector<vk::PipelineShaderStageCreateInfo> stage_create_infos;
+
+        // Create the shader modules, they are only needed until the pipeline is created
+        for (const HPPShaderModule* shader_module : pipeline_layout.get_shader_modules())
+        {
+            auto spirv = shader_module->get_binary();
+
+            vk::ShaderModuleCreateInfo module_create_info{ {}, spirv.size() * sizeof(uint32_t), spirv.data() };
+
+            shader_modules.push_back(device.get_handle().createShaderModule(module_create_info));
+
+            stage_create_infos.push_back({ {}, shader_module->get_stage(), shader_modules.back(), shader_module->get_entry_point().c_str() });
+        }
+
+        auto& vertex_input = pipeline_state.get_vertex_input_state();
+
+        vk::PipelineVertexInputStateCreateInfo vertex_input_state{ {}, vertex_input.bindings, vertex_input.attributes };
+
+        auto& input_assembly = pipeline_state.get_input_assembly_state();
+
+        vk::PipelineInputAssemblyStateCreateInfo input_assembly_state{ {}, input_assembly.topology, input_assembly.primitive_restart_enable };
+
+        // Viewports and scissors are dynamic, only their count is part of the pipeline
+        auto& viewport = pipeline_state.get_viewport_state();
+
+        vk::PipelineViewportStateCreateInfo viewport_state{ {}, viewport.viewport_count, nullptr, viewport.scissor_count, nullptr };
+
+        auto& rasterization = pipeline_state.get_rasterization_state();
+
+        vk::PipelineRasterizationStateCreateInfo rasterization_state{ {},
+                                                                      rasterization.depth_clamp_enable,
+                                                                      rasterization.rasterizer_discard_enable,
+                                                                      rasterization.polygon_mode,
+                                                                      rasterization.cull_mode,
+                                                                      rasterization.front_face,
+                                                                      rasterization.depth_bias_enable,
+                                                                      {},
+                                                                      {},
+                                                                      {},
+                                                                      1.0f };
+
+        auto& multisample = pipeline_state.get_multisample_state();
+
+        vk::PipelineMultisampleStateCreateInfo multisample_state{ {},
+                                                                  multisample.rasterization_samples,
+                                                                  multisample.sample_shading_enable,
+                                                                  multisample.min_sample_shading,
+                                                                  multisample.sample_mask ? &multisample.sample_mask : nullptr,
+                                                                  multisample.alpha_to_coverage_enable,
+                                                                  multisample.alpha_to_one_enable };
+
+        auto& depth_stencil = pipeline_state.get_depth_stencil_state();
+
+        // Stencil masks and reference are dynamic
+        vk::PipelineDepthStencilStateCreateInfo depth_stencil_state{ {},
+                                                                     depth_stencil.depth_test_enable,
+                                                                     depth_stencil.depth_write_enable,
+                                                                     depth_stencil.depth_compare_op,
+                                                                     depth_stencil.depth_bounds_test_enable,
+                                                                     depth_stencil.stencil_test_enable,
+                                                                     { depth_stencil.front.fail_op, depth_stencil.front.pass_op, depth_stencil.front.depth_fail_op, depth_stencil.front.compare_op },
+                                                                     { depth_stencil.back.fail_op, depth_stencil.back.pass_op, depth_stencil.back.depth_fail_op, depth_stencil.back.compare_op } };
+
+        auto& color_blend = pipeline_state.get_color_blend_state();
+
+        std::vector<vk::PipelineColorBlendAttachmentState> color_blend_attachments;
+        color_blend_attachments.reserve(color_blend.attachments.size());
+
+        for (auto& attachment : color_blend.attachments)
+        {
+            color_blend_attachments.push_back({ attachment.blend_enable,
+                                                attachment.src_color_blend_factor,
+                                                attachment.dst_color_blend_factor,
+                                                attachment.color_blend_op,
+                                                attachment.src_alpha_blend_factor,
+                                                attachment.dst_alpha_blend_factor,
+                                                attachment.alpha_blend_op,
+                                                attachment.color_write_mask });
+        }
+
+        vk::PipelineColorBlendStateCreateInfo color_blend_state{ {}, color_blend.logic_op_enable, color_blend.logic_op, color_blend_attachments, { 1.0f, 1.0f, 1.0f, 1.0f } };
+
+        std::array<vk::DynamicState, 9> dynamic_states{ vk::DynamicState::eViewport,
+                                                        vk::DynamicState::eScissor,
+                                                        vk::DynamicState::eLineWidth,
+                                                        vk::DynamicState::eDepthBias,
+                                                        vk::DynamicState::eBlendConstants,
+                                                        vk::DynamicState::eDepthBounds,
+                                                        vk::DynamicState::eStencilCompareMask,
+                                                        vk::DynamicState::eStencilWriteMask,
+                                                        vk::DynamicState::eStencilReference };
+
+        vk::PipelineDynamicStateCreateInfo dynamic_state{ {}, dynamic_states };
+
+        vk::GraphicsPipelineCreateInfo create_info{ {},
+                                                    stage_create_infos,
+                                                    &vertex_input_state,
+                                                    &input_assembly_state,
+                                                    nullptr,
+                                                    &viewport_state,
+                                                    &rasterization_state,
+                                                    &multisample_state,
+                                                    &depth_stencil_state,
+                                                    &color_blend_state,
+                                                    &dynamic_state,
+                                                    pipeline_layout.get_handle(),
+                                                    pipeline_state.get_render_pass()->get_handle(),
+                                                    pipeline_state.get_subpass_index() };
+
+        // Each thread compiles through its own pipeline cache, so concurrent builds do not serialize on it
+        auto result = device.get_handle().createGraphicsPipeline(device.get_resource_cache().request_pipeline_cache(), create_info);
+
+        for (auto shader_module : shader_modules)
+        {
+            device.get_handle().destroyShaderModule(shader_module);
+        }
+
+        if (result.result != vk::Result::eSuccess)
+        {
+            throw std::runtime_error("Cannot create graphics pipeline: " + vk::to_string(result.result));
+        }
+
+        handle = result.value;
+    }
+}
\ No newline at end of file
@@ -0,0 +1,45 @@
+#pragma once
+
+#include "rendering/hpp_pipeline_state.h"
+
+namespace vkb::core
+{
+    class HPPDevice;
+
+    class HPPPipeline
+    {
+    public:
+        HPPPipeline(HPPDevice& device);
+        virtual ~HPPPipeline();
+
+        HPPPipeline(const HPPPipeline&) = delete;
+        HPPPipeline(HPPPipeline&& other);
+
+        HPPPipeline& operator=(const HPPPipeline&) = delete;
+        HPPPipeline& operator=(HPPPipeline&&) = delete;
+
+        vk::Pipeline                            get_handle() const { return handle; }
+        const vkb::rendering::HPPPipelineState& get_state() const  { return state; }
+
+    protected:
+        HPPDevice& device;
+
+        vk::Pipeline handle = nullptr;
+
+        // The state the pipeline was created with
+        vkb::rendering::HPPPipelineState state;
+    };
+
+    /**
+     * @brief A graphics pipeline built from a pipeline state, through the pipeline cache of the calling thread
+     */
+    class HPPGraphicsPipeline : public HPPPipeline
+    {
+    public:
+        HPPGraphicsPipeline(HPPDevice& device, const vkb::rendering::HPPPipelineState& pipeline_state);
+
+        HPPGraphicsPipeline(HPPGraphicsPipeline&&) = default;
+
+        virtual ~HPPGraphicsPipeline() = default;
+    };
+}
\ No newline at end of file
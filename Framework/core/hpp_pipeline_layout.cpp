@@ -7,7 +7,10 @@ namespace vkb::core
         shader_modules{ shader_modules }
     {
         // Collect and combine all the shader resources from each of the shader modules
-        // Collate them all into a map that is indexed by the name of the resource
+        // Collate them all into a map that is indexed by the name of the resource.
+        // Only the sets are kept, the resources of the modules are not copied into every layout using them.
+        std::unordered_map<std::string, HPPShaderResource> shader_resources;
+
         for (auto* shader_module : shader_modules)
         {
             for (const auto& shader_resource : shader_module->get_resources())
@@ -56,9 +59,68 @@ namespace vkb::core
             }
         }
 
-        // TODO
+        // Request the descriptor set layouts from the cache, sets the shaders do not use get an empty layout
+        // as the layouts are indexed by set in the create info
+        uint32_t set_count = 0;
+        for (auto& shader_set_it : shader_sets)
+        {
+            set_count = std::max(set_count, shader_set_it.first + 1);
+        }
+
+        const std::vector<HPPShaderResource> empty_set;
+
+        std::vector<vk::DescriptorSetLayout> descriptor_set_layout_handles;
+        descriptor_set_layout_handles.reserve(set_count);
+
+        for (uint32_t set_index = 0; set_index < set_count; ++set_index)
+        {
+            auto  it           = shader_sets.find(set_index);
+            auto& resource_set = it != shader_sets.end() ? it->second : empty_set;
+
+            descriptor_set_layouts.push_back(&device.get_resource_cache().request_descriptor_set_layout(HPPDescriptorSetLayoutSignature{ resource_set }));
+            descriptor_set_layout_handles.push_back(descriptor_set_layouts.back()->get_handle());
+        }
+
+        // Each stage gets the range covering all the push constants it reads, from its own module as the merged
+        // resources only keep the offset and size of the first module using a block. Stages with equal ranges share one.
+        std::map<vk::ShaderStageFlagBits, std::pair<uint32_t, uint32_t>> stage_ranges;
+
+        for (auto* shader_module : shader_modules)
+        {
+            for (const auto& shader_resource : shader_module->get_resources())
+            {
+                if (shader_resource.type != HPPShaderResourceType::PushConstant)
+                {
+                    continue;
+                }
+
+                auto [it, inserted] = stage_ranges.try_emplace(shader_module->get_stage(), shader_resource.offset, shader_resource.offset + shader_resource.size);
+
+                if (!inserted)
+                {
+                    it->second.first  = std::min(it->second.first, shader_resource.offset);
+                    it->second.second = std::max(it->second.second, shader_resource.offset + shader_resource.size);
+                }
+            }
+        }
+
+        for (auto& [stage, range] : stage_ranges)
+        {
+            auto it = std::ranges::find_if(push_constant_ranges, [&range](const vk::PushConstantRange& push_constant_range) {
+                return push_constant_range.offset == range.first && push_constant_range.size == range.second - range.first;
+            });
+
+            if (it != push_constant_ranges.end())
+            {
+                it->stageFlags |= stage;
+            }
+            else
+            {
+                push_constant_ranges.emplace_back(stage, range.first, range.second - range.first);
+            }
+        }
 
-        vk::PipelineLayoutCreateInfo create_info = {};
+        vk::PipelineLayoutCreateInfo create_info{ {}, descriptor_set_layout_handles, push_constant_ranges };
 
         // Create the Vulkan pipeline layout handle
         handle = device.get_handle().createPipelineLayout(create_info);
@@ -68,12 +130,51 @@ namespace vkb::core
         device{ other.device },
         handle{ other.handle },
         shader_modules{ std::move(other.shader_modules) },
-        shader_resources{ std::move(other.shader_resources) },
-        shader_sets{ std::move(other.shader_sets) }
+        shader_sets{ std::move(other.shader_sets) },
+        descriptor_set_layouts{ std::move(other.descriptor_set_layouts) },
+        push_constant_ranges{ std::move(other.push_constant_ranges) }
     {
         other.handle = nullptr;
     }
 
+    const HPPDescriptorSetLayout& HPPPipelineLayout::get_descriptor_set_layout(uint32_t set_index) const
+    {
+        if (!has_descriptor_set_layout(set_index))
+        {
+            throw std::runtime_error("Couldn't find descriptor set layout at set index " + std::to_string(set_index));
+        }
+
+        return *descriptor_set_layouts[set_index];
+    }
+
+    vk::ShaderStageFlags HPPPipelineLayout::get_push_constant_range_stage(uint32_t size, uint32_t offset) const
+    {
+        vk::ShaderStageFlags stages;
+
+        for (auto& push_constant_range : push_constant_ranges)
+        {
+            if (offset < push_constant_range.offset + push_constant_range.size && push_constant_range.offset < offset + size)
+            {
+                stages |= push_constant_range.stageFlags;
+            }
+        }
+
+        return stages;
+    }
+
+    uint32_t HPPPipelineLayout::get_compatible_set_count(const HPPPipelineLayout& other) const
+    {
+        if (push_constant_ranges != other.push_constant_ranges)
+        {
+            return 0;
+        }
+
+        // Set layouts are shared by signature, equal layouts are the same object
+        auto mismatch = std::ranges::mismatch(descriptor_set_layouts, other.descriptor_set_layouts);
+
+        return static_cast<uint32_t>(mismatch.in1 - descriptor_set_layouts.begin());
+    }
+
     HPPPipelineLayout::~HPPPipelineLayout()
     {
         // Destroy pipeline layout
@@ -1,6 +1,7 @@
 #pragma once
 
 #include "hpp_shader_module.h"
+#include "hpp_descriptor_set_layout.h"
 
 namespace vkb::core
 {
@@ -18,15 +19,33 @@ namespace vkb::core
         HPPPipelineLayout& operator=(const HPPPipelineLayout&) = delete;
         HPPPipelineLayout& operator=(HPPPipelineLayout&&) = delete;
 
-        vk::PipelineLayout                                                  get_handle() const         { return handle; }
-        const std::vector<HPPShaderModule*>&                                get_shader_modules() const { return shader_modules; }
-        const std::unordered_map<uint32_t, std::vector<HPPShaderResource>>& get_shader_sets() const    { return shader_sets; }
+        vk::PipelineLayout                                                  get_handle() const                 { return handle; }
+        const std::vector<HPPShaderModule*>&                                get_shader_modules() const         { return shader_modules; }
+        const std::unordered_map<uint32_t, std::vector<HPPShaderResource>>& get_shader_sets() const            { return shader_sets; }
+        const std::vector<HPPDescriptorSetLayout*>&                         get_descriptor_set_layouts() const { return descriptor_set_layouts; }
+        const std::vector<vk::PushConstantRange>&                           get_push_constant_ranges() const   { return push_constant_ranges; }
+
+        bool                          has_descriptor_set_layout(uint32_t set_index) const { return set_index < descriptor_set_layouts.size(); }
+        const HPPDescriptorSetLayout& get_descriptor_set_layout(uint32_t set_index) const;
+
+        /**
+         * @brief Returns the stages to push constants to, those whose range overlaps the given bytes as vkCmdPushConstants requires
+         */
+        vk::ShaderStageFlags get_push_constant_range_stage(uint32_t size, uint32_t offset = 0) const;
+
+        /**
+         * @brief Returns the number of leading sets for which this layout is compatible with another one.
+         *        Descriptor sets bound at those indices while a pipeline of the other layout was bound stay bound
+         *        when binding a pipeline of this one, so they do not need to be bound again.
+         */
+        uint32_t get_compatible_set_count(const HPPPipelineLayout& other) const;
 
     private:
         HPPDevice&                                                   device;
         vk::PipelineLayout                                           handle;
         std::vector<HPPShaderModule*>                                shader_modules;        // The shader modules that this pipeline layout uses
-        std::unordered_map<std::string, HPPShaderResource>           shader_resources;      // The shader resources that this pipeline layout uses, indexed by their name
         std::unordered_map<uint32_t, std::vector<HPPShaderResource>> shader_sets;           // A map of each set and the resources it owns used by the pipeline layout
+        std::vector<HPPDescriptorSetLayout*>                         descriptor_set_layouts; // The descriptor set layouts of this pipeline layout, indexed by set
+        std::vector<vk::PushConstantRange>                           push_constant_ranges;   // One range for each group of stages reading the same push constant bytes
     };
 }
\ No newline at end of file
@@ -1,4 +1,5 @@
 #include "stdafx.h"
+#include "common/hpp_resource_caching.h"
 
 namespace vkb::core
 {
@@ -24,6 +25,26 @@ namespace vkb::core
         }
     }
 
+    HPPRenderPassDesc::HPPRenderPassDesc(const std::vector<vkb::HPPLoadStoreInfo>& load_store_infos_,
+                                         const std::vector<HPPSubpassInfo>&        subpasses_) :
+        load_store_infos{ load_store_infos_ },
+        subpasses{ subpasses_ }
+    {
+        common::HPPKeyWriter writer{ key };
+        common::key_param(writer, load_store_infos);
+        common::key_param(writer, subpasses);
+
+        common::HPPHasher hasher;
+        hasher.write(key.data(), key.size());
+        hash = hasher.digest();
+    }
+
+    HPPRenderPass::HPPRenderPass(HPPDevice&                                        device,
+                                 const std::vector<vkb::rendering::HPPAttachment>& attachments,
+                                 const HPPRenderPassDesc&                          desc) :
+        HPPRenderPass{ device, attachments, desc.get_load_store_infos(), desc.get_subpasses() }
+    { }
+
     HPPRenderPass::~HPPRenderPass()
     {
         // Destroy render pass
@@ -1,5 +1,7 @@
 #pragma once
 
+#include "common/hpp_hasher.h"
+
 namespace vkb::rendering
 {
     struct HPPAttachment;
@@ -17,6 +19,31 @@ namespace vkb::core
         vk::ResolveModeFlagBits depth_stencil_resolve_mode;
     };
 
+    /**
+     * @brief The load/store ops and subpasses of a render pass, along with their precomputed cache key.
+     *        Built once by the owner of the subpasses, so requesting the render pass every frame
+     *        neither copies the subpass info nor hashes it again.
+     */
+    class HPPRenderPassDesc
+    {
+    public:
+        HPPRenderPassDesc() = default;
+        HPPRenderPassDesc(const std::vector<vkb::HPPLoadStoreInfo>& load_store_infos, const std::vector<HPPSubpassInfo>& subpasses);
+
+        const std::vector<vkb::HPPLoadStoreInfo>& get_load_store_infos() const { return load_store_infos; }
+        const std::vector<HPPSubpassInfo>&        get_subpasses() const        { return subpasses; }
+        const common::HPPHash128&                 get_hash() const             { return hash; }
+        const std::vector<uint8_t>&               get_key() const              { return key; }
+
+    private:
+        std::vector<vkb::HPPLoadStoreInfo> load_store_infos;
+        std::vector<HPPSubpassInfo>        subpasses;
+
+        // Serialized load/store ops and subpasses, and their hash
+        std::vector<uint8_t> key;
+        common::HPPHash128   hash;
+    };
+
     /**
      * @brief facade class around vkb::RenderPass, providing a vulkan.hpp-based interface
      *
@@ -29,6 +56,9 @@ namespace vkb::core
                       const std::vector<vkb::rendering::HPPAttachment>& attachments,
                       const std::vector<vkb::HPPLoadStoreInfo>&         load_store_infos,
                       const std::vector<HPPSubpassInfo>&                subpasses);
+        HPPRenderPass(HPPDevice&                                        device,
+                      const std::vector<vkb::rendering::HPPAttachment>& attachments,
+                      const HPPRenderPassDesc&                          desc);
         ~HPPRenderPass();
 
         HPPRenderPass(const HPPRenderPass&) = delete;
@@ -1,138 +1,271 @@
 #include "stdafx.h"
+#include "common/hpp_hasher.h"
 #include "glsl_compiler.h"
+#include "shader_archive.h"
+#include "spirv_cache.h"
 #include "spirv_reflection.h"
-#include "common/string_util.h"
+#include "shader_preprocessor.h"
 
 namespace vkb::core
 {
-    /**
-     * @brief Pre-compiles project shader files to include header code
-     * @param source The shader file
-     * @returns A byte array of the final shader
-     */
-    inline std::vector<std::string> precompile_shader(const std::string& source)
+    namespace
     {
-        std::vector<std::string> final_file;
+        // Macro names are shared by all the variants, each one is stored once for the lifetime of the process
+        std::string_view intern_macro_name(std::string_view name)
+        {
+            static std::mutex                      mutex;
+            static std::unordered_set<std::string> names;
 
-        auto lines = split(source, '\n');
+            std::lock_guard<std::mutex> guard(mutex);
 
-        for (auto& line : lines)
-        {
-            if (line.find("#include \"") == 0)
-            {
-                // Include paths are relative to the base shader directory
-                std::string include_path = line.substr(10);
-                size_t last_quote = include_path.find("\"");
-                if (!include_path.empty() && last_quote != std::string::npos)
-                {
-                    include_path = include_path.substr(0, last_quote);
-                }
+            return *names.emplace(name).first;
+        }
 
-                auto include_file = precompile_shader(fs::read_shader(include_path));
-                for (auto& include_file_line : include_file)
-                {
-                    final_file.push_back(include_file_line);
-                }
-            }
-            else
-            {
-                final_file.push_back(line);
-            }
+        inline void write_string(common::HPPHasher& hasher, std::string_view value)
+        {
+            hasher.write(value.size());
+            hasher.write(value.data(), value.size());
         }
 
-        return final_file;
-    }
+        common::HPPInternPool<std::vector<uint32_t>>& get_spirv_pool()
+        {
+            static common::HPPInternPool<std::vector<uint32_t>> pool;
 
-    inline std::vector<uint8_t> convert_to_bytes(std::vector<std::string>& lines)
-    {
-        std::vector<uint8_t> bytes;
+            return pool;
+        }
 
-        for (auto& line : lines)
+        common::HPPInternPool<std::vector<HPPShaderResource>>& get_resource_pool()
         {
-            line += "\n";
-            std::vector<uint8_t> line_bytes(line.begin(), line.end());
-            bytes.insert(bytes.end(), line_bytes.begin(), line_bytes.end());
+            static common::HPPInternPool<std::vector<HPPShaderResource>> pool;
+
+            return pool;
         }
 
-        return bytes;
+        std::shared_ptr<const std::vector<HPPShaderResource>> intern_resources(std::vector<HPPShaderResource>&& resources)
+        {
+            common::HPPHasher hasher;
+
+            size_t size = resources.size() * sizeof(HPPShaderResource);
+
+            hasher.write(resources.size());
+            for (auto& resource : resources)
+            {
+                hasher.write(resource.stages);
+                hasher.write(resource.type);
+                hasher.write(resource.mode);
+                hasher.write(resource.set);
+                hasher.write(resource.binding);
+                hasher.write(resource.location);
+                hasher.write(resource.input_attachment_index);
+                hasher.write(resource.vec_size);
+                hasher.write(resource.columns);
+                hasher.write(resource.array_size);
+                hasher.write(resource.offset);
+                hasher.write(resource.size);
+                hasher.write(resource.constant_id);
+                hasher.write(resource.qualifiers);
+                write_string(hasher, resource.name);
+
+                size += resource.name.capacity();
+            }
+
+            return get_resource_pool().intern(std::move(resources), hasher.digest(), size);
+        }
     }
 
-    HPPShaderModule::HPPShaderModule(HPPDevice&              device,
-                                     vk::ShaderStageFlagBits stage,
-                                     const HPPShaderSource&  glsl_source,
-                                     const std::string&      entry_point,
-                                     const HPPShaderVariant& shader_variant) :
+    HPPShaderModule::HPPShaderModule(HPPDevice&                device,
+                                     vk::ShaderStageFlagBits   stage,
+                                     const HPPShaderSource&    glsl_source,
+                                     const std::string&        entry_point,
+                                     const HPPShaderVariant&   shader_variant,
+                                     const ShaderPreprocessor* preprocessor) :
         device{ device },
         stage{ stage },
-        entry_point{ entry_point }
+        entry_point{ entry_point },
+        glsl_source{ glsl_source },
+        shader_variant{ shader_variant }
     {
-        auto& source = glsl_source.get_source();
+        // Expand the includes of the source
+        auto preprocessed = preprocessor ? preprocessor->process(glsl_source.get_source()) : ShaderPreprocessor{}.process(glsl_source.get_source());
+
+        dependencies = std::move(preprocessed.dependencies);
 
-        // Precompile source into the final spirv bytecode
-        auto glsl_final_source = precompile_shader(source);
+        std::vector<uint32_t>          compiled;
+        std::vector<HPPShaderResource> reflected_resources;
 
-        // Compile the GLSL source
-        GLSLCompiler glsl_compiler;
+        // Use the binary precompiled by the shader compiler tool if the archive has it, the source is then never compiled
+        auto archived = ShaderArchive::get().find(ShaderArchive::get_key(stage, preprocessed.source, entry_point, shader_variant));
 
-        if (!glsl_compiler.compile_to_spirv(stage, convert_to_bytes(glsl_final_source), entry_point, shader_variant, spirv))
+        bool from_archive = archived && deserialize_shader_resources(archived->reflection.data(), archived->reflection.size(), reflected_resources);
+
+        if (from_archive)
         {
-            throw std::runtime_error("GLSL compile to spirv failed");
+            binary = archived->spirv;
         }
+        else
+        {
+            // Compile the GLSL source, unless the same source was compiled by a previous run
+            GLSLCompiler glsl_compiler;
+
+            std::string info_log;
+
+            if (!SPIRVCache::get().compile_to_spirv(glsl_compiler, stage, std::vector<uint8_t>{ preprocessed.source.begin(), preprocessed.source.end() }, entry_point, shader_variant, compiled, info_log))
+            {
+                throw std::runtime_error("GLSL compile to spirv failed: " + info_log);
+            }
+
+            // Reflect all shader resources, unless the same binary was reflected by a previous run
+            if (!SPIRVCache::get().reflect_shader_resources(stage, compiled, reflected_resources, shader_variant))
+            {
+                throw std::runtime_error("Spiv reflect shader resources failed");
+            }
+
+            binary = compiled;
+        }
+
+        // Generate a unique id, determined by the binary
+        common::HPPHasher hasher;
+        hasher.write(binary.data(), binary.size_bytes());
 
-        SPIRVReflection spirv_reflection;
+        binary_hash = hasher.digest();
 
-        // Reflect all shader resources
-        if (!spirv_reflection.reflect_shader_resources(stage, spirv, resources, shader_variant))
+        id = static_cast<size_t>(binary_hash.low);
+
+        // Share the compiled binary with the modules compiled to the same one
+        if (!from_archive)
         {
-            throw std::runtime_error("Spiv reflect shader resources failed");
+            spirv  = get_spirv_pool().intern(std::move(compiled), binary_hash, binary.size_bytes());
+            binary = *spirv;
         }
 
-        // Generate a unique id, determined by source and variant
-        std::hash<std::string> hasher{};
-        id = hasher(std::string{ reinterpret_cast<const char*>(spirv.data()),
-                                 reinterpret_cast<const char*>(spirv.data() + spirv.size()) });
+        resources = intern_resources(std::move(reflected_resources));
     }
 
     HPPShaderModule::HPPShaderModule(HPPShaderModule&& other) :
         device{ other.device },
         id{ other.id },
+        binary_hash{ other.binary_hash },
         stage{ other.stage },
-        entry_point{ other.entry_point },
-        spirv{ other.spirv },
-        resources{ other.resources }
+        entry_point{ std::move(other.entry_point) },
+        spirv{ std::move(other.spirv) },
+        binary{ other.binary },
+        resources{ std::move(other.resources) },
+        dependencies{ std::move(other.dependencies) },
+        glsl_source{ std::move(other.glsl_source) },
+        shader_variant{ std::move(other.shader_variant) }
     {
         other.stage = {};
     }
 
+    common::HPPInternPoolStats HPPShaderModule::get_blob_stats()
+    {
+        auto spirv_stats    = get_spirv_pool().get_stats();
+        auto resource_stats = get_resource_pool().get_stats();
+
+        return { spirv_stats.interned_count + resource_stats.interned_count,
+                 spirv_stats.shared_count + resource_stats.shared_count,
+                 spirv_stats.saved_bytes + resource_stats.saved_bytes,
+                 spirv_stats.live_bytes + resource_stats.live_bytes };
+    }
+
+    void HPPShaderModule::reload(HPPShaderModule&& other)
+    {
+        assert(stage == other.stage && entry_point == other.entry_point && "A module can only be reloaded with the same stage and entry point");
+
+        for (auto& resource : *resources)
+        {
+            if (resource.mode != HPPShaderResourceMode::Static)
+            {
+                other.set_resource_mode(resource.name, resource.mode);
+            }
+        }
+
+        id           = other.id;
+        binary_hash  = other.binary_hash;
+        spirv        = std::move(other.spirv);
+        binary       = other.binary;
+        resources    = std::move(other.resources);
+        dependencies = std::move(other.dependencies);
+        glsl_source  = std::move(other.glsl_source);
+    }
+
     void HPPShaderModule::set_resource_mode(const std::string& resource_name, const HPPShaderResourceMode& resource_mode)
     {
-        auto it = std::ranges::find_if(resources, [&resource_name](const HPPShaderResource& resource) { return resource.name == resource_name; });
+        auto it = std::ranges::find_if(*resources, [&resource_name](const HPPShaderResource& resource) { return resource.name == resource_name; });
+
+        if (it == resources->end() || it->mode == resource_mode)
+        {
+            return;
+        }
+
+        if (resource_mode == HPPShaderResourceMode::Dynamic && it->type != HPPShaderResourceType::BufferUniform && it->type != HPPShaderResourceType::BufferStorage)
+        {
+            // Does not support dynamic
+            return;
+        }
+
+        // The resources may be shared with other modules, change a copy of them
+        auto modified = *resources;
+
+        modified[std::distance(resources->begin(), it)].mode = resource_mode;
+
+        resources = intern_resources(std::move(modified));
+    }
+
+    HPPShaderVariant::HPPShaderVariant(std::string&& preamble, std::vector<std::string>&& processes) :
+        base_preamble(std::move(preamble)),
+        base_processes(std::move(processes))
+    {
+        common::HPPHasher hasher;
 
-        if (it != resources.end())
+        write_string(hasher, base_preamble);
+        for (auto& process : base_processes)
         {
-            if (resource_mode == HPPShaderResourceMode::Dynamic)
+            write_string(hasher, process);
+        }
+
+        id = static_cast<size_t>(hasher.digest().low);
+    }
+
+    std::string HPPShaderVariant::get_preamble() const
+    {
+        std::string preamble = base_preamble;
+
+        for (auto& [name, directive] : directives)
+        {
+            if (directive.undefine)
             {
-                if (it->type == HPPShaderResourceType::BufferUniform || it->type == HPPShaderResourceType::BufferStorage)
-                {
-                    it->mode = resource_mode;
-                }
-                else
-                {
-                    // Does not support dynamic
-                }
+                preamble.append("#undef ").append(name).append("\n");
             }
             else
             {
-                it->mode = resource_mode;
+                // The "=" needs to turn into a space
+                size_t offset = preamble.size() + 8;
+
+                preamble.append("#define ").append(directive.definition).append("\n");
+
+                size_t pos_equal = directive.definition.find('=');
+                if (pos_equal != std::string::npos)
+                {
+                    preamble[offset + pos_equal] = ' ';
+                }
             }
         }
+
+        return preamble;
     }
 
-    HPPShaderVariant::HPPShaderVariant(std::string&& preamble, std::vector<std::string>&& processes) :
-        preamble(std::move(preamble)),
-        processes(std::move(processes))
+    std::vector<std::string> HPPShaderVariant::get_processes() const
     {
-        update_id();
+        std::vector<std::string> processes = base_processes;
+        processes.reserve(processes.size() + directives.size());
+
+        for (auto& [name, directive] : directives)
+        {
+            processes.push_back(directive.undefine ? "U" + std::string{ name } : "D" + directive.definition);
+        }
+
+        return processes;
     }
 
     void HPPShaderVariant::add_definitions(const std::vector<std::string>& definitions)
@@ -145,28 +278,15 @@ namespace vkb::core
 
     void HPPShaderVariant::add_define(const std::string& def)
     {
-        processes.push_back("D" + def);
+        // The macro name ends where its parameters or its value start
+        std::string_view name{ def.data(), std::min(def.find_first_of("(= \t"), def.size()) };
 
-        std::string tmp_def = def;
-
-        // The "=" needs to turn into a space
-        size_t pos_equal = tmp_def.find_first_of("=");
-        if (pos_equal != std::string::npos)
-        {
-            tmp_def[pos_equal] = ' ';
-        }
-
-        preamble.append("#define " + tmp_def + "\n");
-
-        update_id();
+        set_directive(name, Directive{ false, def });
     }
 
     void HPPShaderVariant::add_undefine(const std::string& undef)
     {
-        processes.push_back("U" + undef);
-        preamble.append("#undef " + undef + "\n");
-
-        update_id();
+        set_directive(undef, Directive{ true });
     }
 
     void HPPShaderVariant::add_runtime_array_size(const std::string& runtime_array_name, size_t size)
@@ -188,16 +308,35 @@ namespace vkb::core
 
     void HPPShaderVariant::clear()
     {
-        preamble.clear();
-        processes.clear();
+        base_preamble.clear();
+        base_processes.clear();
+        directives.clear();
         runtime_array_sizes.clear();
-        update_id();
+        id = 0;
     }
 
-    void HPPShaderVariant::update_id()
+    void HPPShaderVariant::set_directive(std::string_view name, Directive&& directive)
     {
-        std::hash<std::string> hasher{};
-        id = hasher(preamble);
+        name = intern_macro_name(name);
+
+        common::HPPHasher hasher;
+
+        write_string(hasher, name);
+        hasher.write(directive.undefine);
+        write_string(hasher, directive.definition);
+
+        directive.hash = static_cast<size_t>(hasher.digest().low);
+
+        // Wrapping sums do not depend on the order of their terms, and a term is taken out as easily as it is added
+        auto [it, inserted] = directives.try_emplace(name);
+        if (!inserted)
+        {
+            id -= it->second.hash;
+        }
+
+        id += directive.hash;
+
+        it->second = std::move(directive);
     }
 
     HPPShaderSource::HPPShaderSource(const std::string& filename) :
@@ -1,5 +1,12 @@
 #pragma once
 
+#include "common/hpp_intern_pool.h"
+
+namespace vkb
+{
+    class ShaderPreprocessor;
+}
+
 namespace vkb::core
 {
     class HPPDevice;
@@ -58,23 +65,52 @@ namespace vkb::core
         uint32_t              constant_id;
         uint32_t              qualifiers;
         std::string           name;
+
+        bool operator==(const HPPShaderResource& other) const = default;
     };
 
     /**
      * @brief Adds support for C style preprocessor macros to glsl shaders
      *        enabling you to define or undefine certain symbols
+     *
+     * A variant keeps the last directive added for each macro, sorted by macro name, so variants adding the same
+     * directives in another order are equal and share their cache entries. Its id is the sum of the hashes of the
+     * directives, updated as they are added, so building a variant is linear in its number of directives.
      */
     class HPPShaderVariant
     {
     public:
+        // The last directive added for a macro
+        struct Directive
+        {
+            bool        undefine = false;
+            std::string definition;        // What follows the define directive, empty for an undefine
+            size_t      hash = 0;
+        };
+
         HPPShaderVariant() = default;
         HPPShaderVariant(std::string&& preamble, std::vector<std::string>&& processes);
 
+        /**
+         * @brief Returns a sum of hashes, equal for equal variants but not proof of equality. The canonical identity
+         *        is the base preamble and processes followed by the directives, in the order of their macro names.
+         */
         size_t                                         get_id() const                  { return id; }
-        const std::string&                             get_preamble() const            { return preamble; }
-        const std::vector<std::string>&                get_processes() const           { return processes; }
+        const std::string&                             get_base_preamble() const       { return base_preamble; }
+        const std::vector<std::string>&                get_base_processes() const      { return base_processes; }
+        const std::map<std::string_view, Directive>&   get_directives() const          { return directives; }
         const std::unordered_map<std::string, size_t>& get_runtime_array_sizes() const { return runtime_array_sizes; }
 
+        /**
+         * @brief Returns the preamble given to the constructor, followed by the directives in the order of their macro names
+         */
+        std::string get_preamble() const;
+
+        /**
+         * @brief Returns the processes given to the constructor, followed by the directives in the order of their macro names
+         */
+        std::vector<std::string> get_processes() const;
+
         /**
          * @brief Add definitions to shader variant
          * @param definitions Vector of definitions to add to the variant
@@ -82,13 +118,13 @@ namespace vkb::core
         void add_definitions(const std::vector<std::string>& definitions);
 
         /**
-         * @brief Adds a define macro to the shader
+         * @brief Adds a define macro to the shader, replacing any directive added before for the same macro
          * @param def String which should go to the right of a define directive
          */
         void add_define(const std::string& def);
 
         /**
-         * @brief Adds an undef macro to the shader
+         * @brief Adds an undef macro to the shader, replacing any directive added before for the same macro
          * @param undef String which should go to the right of an undef directive
          */
         void add_undefine(const std::string& undef);
@@ -106,13 +142,18 @@ namespace vkb::core
         void clear();
 
     private:
-        size_t                                  id;
-        std::string                             preamble;
-        std::vector<std::string>                processes;
-        std::unordered_map<std::string, size_t> runtime_array_sizes;
+        void set_directive(std::string_view name, Directive&& directive);
+
+        size_t id = 0;
 
-        void update_id();
+        // Given as is to the constructor, ahead of the directives
+        std::string              base_preamble;
+        std::vector<std::string> base_processes;
 
+        // Keyed by interned macro names, which live as long as the process
+        std::map<std::string_view, Directive> directives;
+
+        std::unordered_map<std::string, size_t> runtime_array_sizes;
     };
 
     class HPPShaderSource
@@ -145,11 +186,16 @@ namespace vkb::core
     class HPPShaderModule
     {
     public:
-        HPPShaderModule(HPPDevice&              device,
-                        vk::ShaderStageFlagBits stage,
-                        const HPPShaderSource&  glsl_source,
-                        const std::string&      entry_point,
-                        const HPPShaderVariant& shader_variant);
+        /**
+         * @param preprocessor Expands the includes of the source, shared by the modules of a cache so common headers are
+         *                     read once for all of them. The module expands them on its own if null.
+         */
+        HPPShaderModule(HPPDevice&                device,
+                        vk::ShaderStageFlagBits   stage,
+                        const HPPShaderSource&    glsl_source,
+                        const std::string&        entry_point,
+                        const HPPShaderVariant&   shader_variant,
+                        const ShaderPreprocessor* preprocessor = nullptr);
 
         HPPShaderModule(const HPPShaderModule&) = delete;
         HPPShaderModule(HPPShaderModule&& other);
@@ -157,11 +203,15 @@ namespace vkb::core
         HPPShaderModule& operator=(const HPPShaderModule&) = delete;
         HPPShaderModule& operator=(HPPShaderModule&&) = delete;
 
-        size_t                                get_id() const          { return id; }
-        vk::ShaderStageFlagBits               get_stage() const       { return stage; }
-        const std::string&                    get_entry_point() const { return entry_point; }
-        const std::vector<HPPShaderResource>& get_resources() const   { return resources; }
-        const std::vector<uint32_t>&          get_binary() const      { return spirv; }
+        size_t                                get_id() const           { return id; }
+        const common::HPPHash128&             get_binary_hash() const  { return binary_hash; }
+        vk::ShaderStageFlagBits               get_stage() const        { return stage; }
+        const std::string&                    get_entry_point() const  { return entry_point; }
+        const std::vector<HPPShaderResource>& get_resources() const    { return *resources; }
+        std::span<const uint32_t>             get_binary() const       { return binary; }
+        const std::vector<std::string>&       get_dependencies() const { return dependencies; }
+        const HPPShaderSource&                get_source() const       { return glsl_source; }
+        const HPPShaderVariant&               get_variant() const      { return shader_variant; }
 
         /**
          * @brief Flags a resource to use a different method of being bound to the shader
@@ -170,21 +220,65 @@ namespace vkb::core
          */
         void set_resource_mode(const std::string& resource_name, const HPPShaderResourceMode& resource_mode);
 
+        /**
+         * @brief Returns how much the modules of the process share, and the memory held by the shared binaries and reflected resources
+         */
+        static common::HPPInternPoolStats get_blob_stats();
+
+        /**
+         * @brief Takes over the code of a module rebuilt from an edited source, keeping the resource modes set on this one.
+         *        Objects built from the previous code must not be used anymore.
+         * @param other A module with the same stage and entry point
+         */
+        void reload(HPPShaderModule&& other);
+
     private:
         HPPDevice& device;
 
         // Shader unique id
         size_t id;
 
+        // Full hash of the binary, of which the id is the low half
+        common::HPPHash128 binary_hash;
+
         // Stage of  the shader (vertex, fragment, etc)
         vk::ShaderStageFlagBits stage{};
 
         // Name of the main function
         std::string entry_point;
 
-        // Compiled source
-        std::vector<uint32_t> spirv;
+        // Compiled source, shared by the modules compiled to the same binary. Null when the binary is viewed in the shader archive.
+        std::shared_ptr<const std::vector<uint32_t>> spirv;
+
+        // The binary of the module, either spirv or a blob of the shader archive
+        std::span<const uint32_t> binary;
 
-        std::vector<HPPShaderResource> resources;
+        // Shared by the modules reflecting the same resources, copied when a resource mode is changed
+        std::shared_ptr<const std::vector<HPPShaderResource>> resources;
+
+        // The files included by the source, directly or not
+        std::vector<std::string> dependencies;
+
+        // What the module was built from, to rebuild it when one of its files changes
+        HPPShaderSource  glsl_source;
+        HPPShaderVariant shader_variant;
     };
+
+    /**
+     * @brief Host memory owned by a cached shader module, dominated by its copy of the source.
+     *        The binary and the resources are shared with other modules or viewed in the shader archive,
+     *        they are counted once by HPPShaderModule::get_blob_stats().
+     */
+    inline size_t get_footprint(const HPPShaderModule& shader_module)
+    {
+        size_t size = sizeof(HPPShaderModule) + shader_module.get_entry_point().capacity() +
+                      shader_module.get_source().get_filename().capacity() + shader_module.get_source().get_source().capacity();
+
+        for (auto& dependency : shader_module.get_dependencies())
+        {
+            size += sizeof(dependency) + dependency.capacity();
+        }
+
+        return size;
+    }
 }
\ No newline at end of file
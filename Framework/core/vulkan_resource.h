@@ -4,6 +4,16 @@ namespace vkb::core
 {
     class HPPDevice;
 
+    /// Returns a process-wide unique id, increasing with every call and never 0.
+    ///
+    /// Objects take one at creation and keep it when moved, so it identifies them in cache keys where
+    /// Vulkan handles would not: handles of destroyed objects get reused by the driver.
+    inline uint64_t next_generation_id()
+    {
+        static std::atomic<uint64_t> next{ 1 };
+        return next.fetch_add(1, std::memory_order_relaxed);
+    }
+
     /// Inherit this for any Vulkan object with a handle of type `Handle`.
     ///
     /// This allows the derived class to store a Vulkan handle, and also a pointer to the parent vkb::Device.
@@ -18,6 +18,8 @@
 #include "filesystem.h"
 #include "std_filesystem.h"
 
+#include <thread>
+
 namespace vkb::filesystem
 {
     static FileSystemPtr fs = nullptr;
@@ -47,6 +49,31 @@ namespace vkb::filesystem
         write_file(path, std::vector<uint8_t>(data.begin(), data.end()));
     }
 
+    void FileSystem::write_file_atomic(const Path& path, const std::vector<uint8_t>& data)
+    {
+        // Each thread writes its own temporary file, concurrent writers never interleave their data
+        auto temp_path = path;
+        temp_path += "." + std::to_string(std::hash<std::thread::id>()(std::this_thread::get_id())) + ".tmp";
+
+        try
+        {
+            write_file(temp_path, data);
+            rename(temp_path, path);
+        }
+        catch (const std::exception&)
+        {
+            // The destination is left untouched, only the partial temporary file is dropped
+            try
+            {
+                remove(temp_path);
+            }
+            catch (const std::exception&)
+            {
+            }
+            throw;
+        }
+    }
+
     std::string FileSystem::read_file_string(const Path& path)
     {
         auto bin = read_file_binary(path);
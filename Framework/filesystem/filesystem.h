@@ -49,6 +49,7 @@ namespace vkb::filesystem
         virtual std::vector<uint8_t> read_chunk(const Path& path, size_t offset, size_t count) = 0;
         virtual void                 write_file(const Path& path, const std::vector<uint8_t>& data) = 0;
         virtual void                 remove(const Path& path) = 0;
+        virtual void                 rename(const Path& from, const Path& to) = 0;        // Replaces the destination atomically
 
         virtual void        set_external_storage_directory(const std::string& dir) = 0;
         virtual const Path& external_storage_directory() const = 0;
@@ -56,6 +57,10 @@ namespace vkb::filesystem
 
         void write_file(const Path& path, const std::string& data);
 
+        // Write next to the destination and rename, so a crash mid-write never leaves a truncated file behind.
+        // Safe to call from several threads for the same path, the last rename wins.
+        void write_file_atomic(const Path& path, const std::vector<uint8_t>& data);
+
         // Read the entire file into a string
         std::string read_file_string(const Path& path);
 
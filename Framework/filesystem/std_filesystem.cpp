@@ -121,7 +121,18 @@ namespace vkb::filesystem
             throw std::runtime_error("Failed to open file for writing at path: " + path.string());
         }
 
-        file.write(reinterpret_cast<const char*>(data.data()), data.size());
+        // A short write must not pass for a complete one, write_file_atomic would rename it over a valid file
+        if (!file.write(reinterpret_cast<const char*>(data.data()), data.size()))
+        {
+            throw std::runtime_error("Failed to write file at path: " + path.string());
+        }
+
+        file.close();
+
+        if (file.fail())
+        {
+            throw std::runtime_error("Failed to close file at path: " + path.string());
+        }
     }
 
     void StdFileSystem::remove(const Path& path)
@@ -136,6 +147,18 @@ namespace vkb::filesystem
         }
     }
 
+    void StdFileSystem::rename(const Path& from, const Path& to)
+    {
+        std::error_code ec;
+
+        std::filesystem::rename(from, to, ec);
+
+        if (ec)
+        {
+            throw std::runtime_error("Failed to rename file at path: " + from.string() + " to: " + to.string());
+        }
+    }
+
     void StdFileSystem::set_external_storage_directory(const std::string& dir)
     {
         _external_storage_directory = dir;
@@ -48,6 +48,8 @@ namespace vkb::filesystem
 
         virtual void remove(const Path& path) override;
 
+        virtual void rename(const Path& from, const Path& to) override;
+
         virtual void set_external_storage_directory(const std::string& dir) override;
 
         const Path& external_storage_directory() const override;
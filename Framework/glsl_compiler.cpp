@@ -1,5 +1,15 @@
 #include "glsl_compiler.h"
 
+#include <algorithm>
+#include <atomic>
+#include <future>
+#include <map>
+#include <optional>
+#include <thread>
+
+#include <glslang/Public/ResourceLimits.h>
+#include <spirv-tools/optimizer.hpp>
+
 namespace vkb
 {
     namespace
@@ -54,49 +64,208 @@ namespace vkb
                 return EShLangVertex;
             }
         }
+
+        /**
+         * @brief Owns the process wide state of glslang, which is not safe to initialize or finalize
+         *        while other threads compile, and costly enough to do only once
+         */
+        struct GlslangProcess
+        {
+            GlslangProcess()
+            {
+                glslang::InitializeProcess();
+            }
+
+            ~GlslangProcess()
+            {
+                glslang::FinalizeProcess();
+            }
+        };
+
+        inline void initialize_glslang()
+        {
+            // Initialized once by the first thread getting there, the others wait for it
+            static GlslangProcess process;
+        }
+
+        // The environment the optimizer legalizes for, matching the SPIR-V version glslang targets
+        inline spv_target_env get_target_env(glslang::EShTargetLanguageVersion version)
+        {
+            switch (version)
+            {
+            case glslang::EShTargetSpv_1_1:
+            case glslang::EShTargetSpv_1_2:
+            case glslang::EShTargetSpv_1_3:
+                return SPV_ENV_VULKAN_1_1;
+
+            case glslang::EShTargetSpv_1_4:
+                return SPV_ENV_VULKAN_1_1_SPIRV_1_4;
+
+            case glslang::EShTargetSpv_1_5:
+                return SPV_ENV_VULKAN_1_2;
+
+            case glslang::EShTargetSpv_1_6:
+                return SPV_ENV_VULKAN_1_3;
+
+            default:
+                return SPV_ENV_VULKAN_1_0;
+            }
+        }
+
+        /**
+         * @brief Calls func for each index below count across a pool of threads.
+         *        Indices are handed out one at a time, so a few long calls do not leave the other workers idle.
+         */
+        template <class F>
+        void parallel_for(size_t count, uint32_t thread_count, F&& func)
+        {
+            std::atomic<size_t> next_index{ 0 };
+
+            auto worker = [count, &func, &next_index]() {
+                for (size_t i = next_index++; i < count; i = next_index++)
+                {
+                    func(i);
+                }
+            };
+
+            size_t worker_count = std::min<size_t>(thread_count, count);
+
+            std::vector<std::future<void>> workers;
+            for (size_t i = 1; i < worker_count; ++i)
+            {
+                workers.push_back(std::async(std::launch::async, worker));
+            }
+
+            worker();
+
+            for (auto& w : workers)
+            {
+                w.get();
+            }
+        }
+
+        /**
+         * @brief Removes the debug instructions carrying source text, file names and line numbers.
+         *        Unlike spirv-opt --strip-debug, OpName and OpMemberName are kept.
+         */
+        void strip_debug_info(std::vector<std::uint32_t>& spirv)
+        {
+            constexpr uint32_t HEADER_WORD_COUNT = 5;
+
+            constexpr uint16_t OP_SOURCE_CONTINUED = 2;
+            constexpr uint16_t OP_SOURCE           = 3;
+            constexpr uint16_t OP_SOURCE_EXTENSION = 4;
+            constexpr uint16_t OP_STRING           = 7;
+            constexpr uint16_t OP_LINE             = 8;
+            constexpr uint16_t OP_NO_LINE          = 317;
+            constexpr uint16_t OP_MODULE_PROCESSED = 330;
+
+            if (spirv.size() < HEADER_WORD_COUNT)
+            {
+                return;
+            }
+
+            // Compact the instructions in place
+            size_t write = HEADER_WORD_COUNT;
+
+            for (size_t read = HEADER_WORD_COUNT; read < spirv.size();)
+            {
+                uint32_t word_count = spirv[read] >> 16;
+                uint16_t opcode     = spirv[read] & 0xFFFF;
+
+                if (word_count == 0 || read + word_count > spirv.size())
+                {
+                    // Malformed, leave the rest of the binary to the driver to reject
+                    std::copy(spirv.begin() + read, spirv.end(), spirv.begin() + write);
+                    write += spirv.size() - read;
+                    break;
+                }
+
+                switch (opcode)
+                {
+                case OP_SOURCE_CONTINUED:
+                case OP_SOURCE:
+                case OP_SOURCE_EXTENSION:
+                case OP_STRING:
+                case OP_LINE:
+                case OP_NO_LINE:
+                case OP_MODULE_PROCESSED:
+                    break;
+
+                default:
+                    std::copy(spirv.begin() + read, spirv.begin() + read + word_count, spirv.begin() + write);
+                    write += word_count;
+                    break;
+                }
+
+                read += word_count;
+            }
+
+            spirv.resize(write);
+        }
     }
 
-    glslang::EShTargetLanguage GLSLCompiler::env_target_language                = glslang::EShTargetLanguage::EShTargetNone;
-    glslang::EShTargetLanguageVersion GLSLCompiler::env_target_language_version = static_cast<glslang::EShTargetLanguageVersion>(0);
+    GLSLCompiler::GLSLCompiler(glslang::EShTargetLanguage target_language, glslang::EShTargetLanguageVersion target_language_version) :
+        env_target_language{ target_language },
+        env_target_language_version{ target_language_version }
+    { }
 
     void GLSLCompiler::set_target_environment(glslang::EShTargetLanguage target_language, glslang::EShTargetLanguageVersion target_language_version)
     {
-        GLSLCompiler::env_target_language         = target_language;
-        GLSLCompiler::env_target_language_version = target_language_version;
+        env_target_language         = target_language;
+        env_target_language_version = target_language_version;
     }
 
     void GLSLCompiler::reset_target_environment()
     {
-        GLSLCompiler::env_target_language         = glslang::EShTargetLanguage::EShTargetNone;
-        GLSLCompiler::env_target_language_version = static_cast<glslang::EShTargetLanguageVersion>(0);
+        env_target_language         = glslang::EShTargetLanguage::EShTargetNone;
+        env_target_language_version = static_cast<glslang::EShTargetLanguageVersion>(0);
+    }
+
+    void GLSLCompiler::set_optimizer_options(const SPIRVOptimizerOptions& options)
+    {
+        optimizer_options = options;
     }
 
     bool GLSLCompiler::compile_to_spirv(vk::ShaderStageFlagBits       stage,
                                         const std::vector<uint8_t>&   glsl_source,
                                         const std::string&            entry_point,
                                         const core::HPPShaderVariant& shader_variant,
-                                        std::vector<std::uint32_t>&   spirv)
+                                        std::vector<std::uint32_t>&   spirv,
+                                        std::string&                  info_log) const
+    {
+        size_t unoptimized_word_count = 0;
+
+        return compile(stage, glsl_source, entry_point, shader_variant, spirv, info_log, unoptimized_word_count);
+    }
+
+    bool GLSLCompiler::compile(vk::ShaderStageFlagBits       stage,
+                               const std::vector<uint8_t>&   glsl_source,
+                               const std::string&            entry_point,
+                               const core::HPPShaderVariant& shader_variant,
+                               std::vector<std::uint32_t>&   spirv,
+                               std::string&                  info_log,
+                               size_t&                       unoptimized_word_count) const
     {
-        // Initialize glslang library
-        glslang::InitializeProcess();
+        initialize_glslang();
 
         EShMessages messages = static_cast<EShMessages>(EShMsgDefault | EShMsgVulkanRules | EShMsgSpvRules);
 
         EShLanguage language = FindShaderLanguage(stage);
         std::string source = std::string(glsl_source.begin(), glsl_source.end());
 
-        const char* file_name_list[1] = { "" };
         const char* shader_source = reinterpret_cast<const char*>(source.data());
 
+        // The shader keeps a pointer to the preamble until it is parsed
+        std::string preamble = shader_variant.get_preamble();
+
         glslang::TShader shader(language);
-        shader.setStringsWithLengthsAndNames(&shader_source, nullptr, file_name_list, 1);
-        shader.setEntryPoint(entry_point.c_str());
-        shader.setSourceEntryPoint(entry_point.c_str());
-        shader.setPreamble(shader_variant.get_preamble().c_str());
-        shader.addProcesses(shader_variant.get_processes());
-        if (GLSLCompiler::env_target_language != glslang::EShTargetLanguage::EShTargetNone)
+        set_up_shader(shader, &shader_source, entry_point, preamble, shader_variant);
+
+        if (!shader.parse(GetDefaultResources(), 100, false, messages))
         {
-            shader.setEnvTarget(GLSLCompiler::env_target_language, GLSLCompiler::env_target_language_version);
+            info_log = std::string(shader.getInfoLog()) + "\n" + std::string(shader.getInfoDebugLog());
+            return false;
         }
 
         // Add shader to new program object
@@ -106,22 +275,192 @@ namespace vkb
         // Link program
         if (!program.link(messages))
         {
+            info_log = std::string(program.getInfoLog()) + "\n" + std::string(program.getInfoDebugLog());
             return false;
         }
 
+        // Save any info log that was generated.
+        if (shader.getInfoLog())
+        {
+            info_log += std::string(shader.getInfoLog()) + "\n" + std::string(shader.getInfoDebugLog()) + "\n";
+        }
+
         glslang::TIntermediate* intermediate = program.getIntermediate(language);
 
         // Translate to SPIRV
         if (!intermediate)
         {
+            info_log += "Failed to get shared intermediate code.\n";
             return false;
         }
 
+        // GlslangToSpv appends to its output, a reused vector would hold several modules
+        spirv.clear();
         glslang::GlslangToSpv(*intermediate, spirv);
 
-        // Shutdown glslang library
-        glslang::FinalizeProcess();
+        unoptimized_word_count = spirv.size();
+
+        optimize(spirv, info_log);
 
         return true;
     }
+
+    bool GLSLCompiler::preprocess(vk::ShaderStageFlagBits       stage,
+                                  const std::vector<uint8_t>&   glsl_source,
+                                  const std::string&            entry_point,
+                                  const core::HPPShaderVariant& shader_variant,
+                                  std::string&                  output,
+                                  std::string&                  info_log) const
+    {
+        initialize_glslang();
+
+        EShMessages messages = static_cast<EShMessages>(EShMsgDefault | EShMsgVulkanRules | EShMsgSpvRules);
+
+        std::string source = std::string(glsl_source.begin(), glsl_source.end());
+
+        const char* shader_source = reinterpret_cast<const char*>(source.data());
+
+        std::string preamble = shader_variant.get_preamble();
+
+        glslang::TShader shader(FindShaderLanguage(stage));
+        set_up_shader(shader, &shader_source, entry_point, preamble, shader_variant);
+
+        // Sources reach the compiler with their includes expanded
+        glslang::TShader::ForbidIncluder includer;
+
+        if (!shader.preprocess(GetDefaultResources(), 100, ENoProfile, false, false, messages, &output, includer))
+        {
+            info_log = std::string(shader.getInfoLog()) + "\n" + std::string(shader.getInfoDebugLog());
+            return false;
+        }
+
+        return true;
+    }
+
+    void GLSLCompiler::set_up_shader(glslang::TShader&             shader,
+                                     const char* const*            shader_source,
+                                     const std::string&            entry_point,
+                                     const std::string&            preamble,
+                                     const core::HPPShaderVariant& shader_variant) const
+    {
+        static const char* const file_name_list[1] = { "" };
+
+        shader.setStringsWithLengthsAndNames(shader_source, nullptr, file_name_list, 1);
+        shader.setEntryPoint(entry_point.c_str());
+        shader.setSourceEntryPoint(entry_point.c_str());
+        shader.setPreamble(preamble.c_str());
+        shader.addProcesses(shader_variant.get_processes());
+        if (env_target_language != glslang::EShTargetLanguage::EShTargetNone)
+        {
+            shader.setEnvTarget(env_target_language, env_target_language_version);
+        }
+    }
+
+    void GLSLCompiler::optimize(std::vector<std::uint32_t>& spirv, std::string& info_log) const
+    {
+        if (optimizer_options.strip_debug_info)
+        {
+            strip_debug_info(spirv);
+        }
+
+        if (optimizer_options.optimization == SPIRVOptimization::None)
+        {
+            return;
+        }
+
+        spvtools::Optimizer optimizer(get_target_env(env_target_language_version));
+
+        optimizer.SetMessageConsumer([&info_log](spv_message_level_t level, const char*, const spv_position_t& position, const char* message) {
+            if (level <= SPV_MSG_ERROR)
+            {
+                info_log += "spirv-opt: " + std::to_string(position.index) + ": " + message + "\n";
+            }
+        });
+
+        if (optimizer_options.optimization == SPIRVOptimization::Performance)
+        {
+            optimizer.RegisterPerformancePasses();
+        }
+        else
+        {
+            optimizer.RegisterSizePasses();
+        }
+
+        std::vector<std::uint32_t> optimized;
+
+        // The unoptimized binary is valid as well, a failing pass only costs performance
+        if (optimizer.Run(spirv.data(), spirv.size(), &optimized))
+        {
+            spirv = std::move(optimized);
+        }
+        else
+        {
+            info_log += "SPIR-V optimization failed, using the unoptimized binary\n";
+        }
+    }
+
+    std::vector<GLSLCompileResult> GLSLCompiler::compile_batch(const std::vector<GLSLCompileJob>& jobs, uint32_t thread_count) const
+    {
+        std::vector<GLSLCompileResult> results(jobs.size());
+
+        if (thread_count == 0)
+        {
+            thread_count = std::max(1U, std::thread::hardware_concurrency());
+        }
+
+        // Variants differing only by defines the source never tests preprocess to the same output, each output is compiled once
+        std::vector<std::optional<std::pair<uint64_t, uint64_t>>> output_keys(jobs.size());
+
+        parallel_for(jobs.size(), thread_count, [this, &jobs, &output_keys](size_t i) {
+            auto& job = jobs[i];
+
+            std::string output;
+            std::string info_log;
+
+            // A job failing to preprocess is compiled on its own, to report the error
+            if (preprocess(job.stage, job.glsl_source, job.entry_point, job.shader_variant, output, info_log))
+            {
+                common::HPPHasher hasher;
+                hasher.write(job.stage);
+                hasher.write(job.entry_point.size());
+                hasher.write(job.entry_point.data(), job.entry_point.size());
+                hasher.write(output.data(), output.size());
+
+                auto key       = hasher.digest();
+                output_keys[i] = std::make_pair(key.low, key.high);
+            }
+        });
+
+        std::vector<size_t>                             sources(jobs.size());
+        std::vector<size_t>                             compiled;
+        std::map<std::pair<uint64_t, uint64_t>, size_t> first_jobs;
+
+        for (size_t i = 0; i < jobs.size(); i++)
+        {
+            sources[i] = output_keys[i] ? first_jobs.try_emplace(*output_keys[i], i).first->second : i;
+
+            if (sources[i] == i)
+            {
+                compiled.push_back(i);
+            }
+        }
+
+        parallel_for(compiled.size(), thread_count, [this, &jobs, &results, &compiled](size_t c) {
+            auto& job    = jobs[compiled[c]];
+            auto& result = results[compiled[c]];
+
+            result.success = compile(job.stage, job.glsl_source, job.entry_point, job.shader_variant, result.spirv, result.info_log, result.unoptimized_word_count);
+        });
+
+        for (size_t i = 0; i < jobs.size(); i++)
+        {
+            if (sources[i] != i)
+            {
+                results[i]              = results[sources[i]];
+                results[i].deduplicated = true;
+            }
+        }
+
+        return results;
+    }
 }
\ No newline at end of file
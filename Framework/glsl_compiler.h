@@ -1,5 +1,6 @@
 #pragma once
 
+#include <cstdint>
 #include <string>
 #include <vector>
 #include <unordered_map>
@@ -8,31 +9,96 @@
 #include <glslang/SPIRV/GlslangToSpv.h>
 #include <vulkan/vulkan.hpp>
 
+#include "common/hpp_hasher.h"
 #include "core/hpp_shader_module.h"
 
 namespace vkb
 {
+    /**
+     * @brief The spirv-opt passes run on the output of glslang
+     */
+    enum class SPIRVOptimization
+    {
+        None,
+        Performance,        // The passes of spirv-opt -O
+        Size                // The passes of spirv-opt -Os
+    };
+
+    /**
+     * @brief How GLSLCompiler post-processes the SPIR-V generated by glslang, the defaults depend on the build profile
+     */
+    struct SPIRVOptimizerOptions
+    {
+#ifdef NDEBUG
+        SPIRVOptimization optimization     = SPIRVOptimization::Performance;
+        bool              strip_debug_info = true;
+#else
+        SPIRVOptimization optimization     = SPIRVOptimization::None;
+        bool              strip_debug_info = false;
+#endif
+    };
+
+    /**
+     * @brief A shader to compile in a batch
+     */
+    struct GLSLCompileJob
+    {
+        vk::ShaderStageFlagBits stage{};
+        std::vector<uint8_t>    glsl_source;
+        std::string             entry_point = "main";
+        core::HPPShaderVariant  shader_variant;
+    };
+
+    /**
+     * @brief The outcome of a GLSLCompileJob
+     */
+    struct GLSLCompileResult
+    {
+        bool                       success = false;
+        std::vector<std::uint32_t> spirv;
+        std::string                info_log;
+        size_t                     unoptimized_word_count = 0;        // The size of the binary generated by glslang
+        bool                       deduplicated           = false;    // Copied from an earlier job preprocessing to the same output
+    };
+
     /// Helper class to generate SPIRV code from GLSL source
     /// A very simple version of the glslValidator application
+    /// glslang is initialized on first use and finalized at exit, compilers can be used from any number of threads at once
     class GLSLCompiler
     {
-    private:
-        static glslang::EShTargetLanguage        env_target_language;
-        static glslang::EShTargetLanguageVersion env_target_language_version;
-
     public:
+        GLSLCompiler() = default;
+
+        /**
+         * @brief Creates a compiler translating to a given target environment
+         * @param target_language The language to translate to
+         * @param target_language_version The version of the language to translate to
+         */
+        GLSLCompiler(glslang::EShTargetLanguage target_language, glslang::EShTargetLanguageVersion target_language_version);
+
         /**
          * @brief Set the glslang target environment to translate to when generating code
          * @param target_language The language to translate to
          * @param target_language_version The version of the language to translate to
          */
-        static void set_target_environment(glslang::EShTargetLanguage target_language,
-                                           glslang::EShTargetLanguageVersion target_language_version);
+        void set_target_environment(glslang::EShTargetLanguage        target_language,
+                                    glslang::EShTargetLanguageVersion target_language_version);
 
         /**
          * @brief Reset the glslang target environment to the default values
          */
-        static void reset_target_environment();
+        void reset_target_environment();
+
+        glslang::EShTargetLanguage        get_target_language() const         { return env_target_language; }
+        glslang::EShTargetLanguageVersion get_target_language_version() const { return env_target_language_version; }
+
+        /**
+         * @brief Sets the spirv-opt passes run after glslang, and whether debug instructions are stripped.
+         *        Names are always kept, shader resources are reflected and looked up by name.
+         */
+        void set_optimizer_options(const SPIRVOptimizerOptions& options);
+
+        const SPIRVOptimizerOptions& get_optimizer_options() const { return optimizer_options; }
 
         /**
          * @brief Compiles GLSL to SPIRV code
@@ -41,11 +107,61 @@ namespace vkb
          * @param entry_point The entrypoint function name of the shader stage
          * @param shader_variant The shader variant
          * @param[out] spirv The generated SPIRV code
+         * @param[out] info_log Stores any log messages during the compilation process
          */
-        bool compile_to_spirv(vk::ShaderStageFlagBits      stage,
-                             const std::vector<uint8_t>&   glsl_source,
-                             const std::string&            entry_point,
-                             const core::HPPShaderVariant& shader_variant,
-                             std::vector<std::uint32_t>&   spirv);
+        bool compile_to_spirv(vk::ShaderStageFlagBits       stage,
+                              const std::vector<uint8_t>&   glsl_source,
+                              const std::string&            entry_point,
+                              const core::HPPShaderVariant& shader_variant,
+                              std::vector<std::uint32_t>&   spirv,
+                              std::string&                  info_log) const;
+
+        /**
+         * @brief Runs the preprocessor of glslang alone, expanding the macros of the variant
+         * @param[out] output The preprocessed source, equal for variants compiling to the same code
+         * @param[out] info_log Stores any log messages if the source cannot be preprocessed
+         */
+        bool preprocess(vk::ShaderStageFlagBits       stage,
+                        const std::vector<uint8_t>&   glsl_source,
+                        const std::string&            entry_point,
+                        const core::HPPShaderVariant& shader_variant,
+                        std::string&                  output,
+                        std::string&                  info_log) const;
+
+        /**
+         * @brief Compiles shaders in parallel across a pool of worker threads.
+         *        Jobs preprocessing to the same output are compiled once, the others get a copy of the result.
+         * @param jobs The shaders to compile
+         * @param thread_count The number of threads to compile on, zero to use all the cores
+         * @return The result of each job, in the order of the jobs
+         */
+        std::vector<GLSLCompileResult> compile_batch(const std::vector<GLSLCompileJob>& jobs, uint32_t thread_count = 0) const;
+
+        /**
+         * @brief Runs the passes selected by the optimizer options on a binary generated by glslang.
+         *        Compiling already does it, this runs the stage alone.
+         * @param[out] info_log Stores any log messages if a pass fails, the binary is then left unoptimized
+         */
+        void optimize(std::vector<std::uint32_t>& spirv, std::string& info_log) const;
+
+    private:
+        bool compile(vk::ShaderStageFlagBits       stage,
+                     const std::vector<uint8_t>&   glsl_source,
+                     const std::string&            entry_point,
+                     const core::HPPShaderVariant& shader_variant,
+                     std::vector<std::uint32_t>&   spirv,
+                     std::string&                  info_log,
+                     size_t&                       unoptimized_word_count) const;
+
+        // The shader keeps pointers to the source and the preamble
+        void set_up_shader(glslang::TShader&             shader,
+                           const char* const*            shader_source,
+                           const std::string&            entry_point,
+                           const std::string&            preamble,
+                           const core::HPPShaderVariant& shader_variant) const;
+
+        glslang::EShTargetLanguage        env_target_language         = glslang::EShTargetLanguage::EShTargetNone;
+        glslang::EShTargetLanguageVersion env_target_language_version = static_cast<glslang::EShTargetLanguageVersion>(0);
+        SPIRVOptimizerOptions             optimizer_options;
     };
 }
\ No newline at end of file
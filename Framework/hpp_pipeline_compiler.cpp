@@ -0,0 +1,268 @@
+#include "stdafx.h"
+#include "hpp_pipeline_compiler.h"
+#include "common/hpp_resource_caching.h"
+
+namespace vkb
+{
+    namespace
+    {
+        float elapsed_ms(std::chrono::steady_clock::time_point start, std::chrono::steady_clock::time_point end)
+        {
+            return std::chrono::duration<float, std::milli>(end - start).count();
+        }
+    }
+
+    HPPPipelineRequest::HPPPipelineRequest(core::HPPGraphicsPipeline& pipeline) :
+        pipeline{ &pipeline }
+    { }
+
+    HPPPipelineRequest::HPPPipelineRequest(std::shared_future<core::HPPGraphicsPipeline*> future) :
+        future{ std::move(future) }
+    { }
+
+    bool HPPPipelineRequest::is_ready() const
+    {
+        return pipeline || (future.valid() && future.wait_for(std::chrono::seconds(0)) == std::future_status::ready);
+    }
+
+    core::HPPGraphicsPipeline* HPPPipelineRequest::get() const
+    {
+        if (pipeline || !is_ready())
+        {
+            return pipeline;
+        }
+
+        return future.get();
+    }
+
+    core::HPPGraphicsPipeline* HPPPipelineRequest::wait() const
+    {
+        if (pipeline || !future.valid())
+        {
+            return pipeline;
+        }
+
+        return future.get();
+    }
+
+    HPPPipelineCompiler::HPPPipelineCompiler(HPPResourceCache& resource_cache, uint32_t worker_count) :
+        resource_cache{ resource_cache }
+    {
+        // Leave half of the hardware threads to recording
+        if (worker_count == 0)
+        {
+            worker_count = std::max(1U, std::thread::hardware_concurrency() / 2);
+        }
+
+        stats.frame_budget_ms = std::chrono::duration<float, std::milli>(frame_budget).count();
+
+        for (uint32_t i = 0; i < worker_count; i++)
+        {
+            workers.emplace_back([this]() { run(); });
+        }
+    }
+
+    HPPPipelineCompiler::~HPPPipelineCompiler()
+    {
+        clear();
+
+        {
+            std::lock_guard<std::mutex> guard(mutex);
+
+            stopping = true;
+        }
+
+        wake.notify_all();
+
+        for (auto& worker : workers)
+        {
+            worker.join();
+        }
+    }
+
+    HPPPipelineRequest HPPPipelineCompiler::request(const rendering::HPPPipelineState& pipeline_state)
+    {
+        common::HPPCacheKey<rendering::HPPPipelineState> key{ pipeline_state };
+
+        auto& hash = key.get_hash();
+
+        std::lock_guard<std::mutex> guard(mutex);
+
+        stats.requests++;
+
+        auto [begin, end] = pending.equal_range(std::make_pair(hash.low, hash.high));
+        for (auto it = begin; it != end; ++it)
+        {
+            if (key.matches(it->second.key))
+            {
+                if (!it->second.failed)
+                {
+                    stats.deduplicated++;
+                }
+
+                return HPPPipelineRequest{ it->second.future };
+            }
+        }
+
+        Job job{ pipeline_state, {}, std::chrono::steady_clock::now(), hash, key.serialize() };
+
+        auto future = job.promise.get_future().share();
+
+        pending.emplace(std::make_pair(hash.low, hash.high), Pending{ job.key, future });
+        jobs.push_back(std::move(job));
+
+        stats.pending++;
+
+        wake.notify_one();
+
+        return HPPPipelineRequest{ future };
+    }
+
+    void HPPPipelineCompiler::clear()
+    {
+        auto paused = pause(true);
+
+        cancel();
+    }
+
+    void HPPPipelineCompiler::cancel()
+    {
+        std::lock_guard<std::mutex> guard(mutex);
+
+        for (auto& job : jobs)
+        {
+            job.promise.set_value(nullptr);
+        }
+
+        jobs.clear();
+        pending.clear();
+
+        stats.pending = 0;
+    }
+
+    std::unique_lock<std::shared_mutex> HPPPipelineCompiler::pause(bool wait)
+    {
+        if (wait)
+        {
+            return std::unique_lock<std::shared_mutex>{ compile_mutex };
+        }
+
+        return std::unique_lock<std::shared_mutex>{ compile_mutex, std::try_to_lock };
+    }
+
+    void HPPPipelineCompiler::set_hitch_budget(std::chrono::microseconds new_frame_budget, uint32_t warmup_frames)
+    {
+        std::lock_guard<std::mutex> guard(mutex);
+
+        frame_budget          = new_frame_budget;
+        warmup_length         = warmup_frames;
+        stats.frame_budget_ms = std::chrono::duration<float, std::milli>(frame_budget).count();
+    }
+
+    void HPPPipelineCompiler::end_frame(std::chrono::microseconds frame_time)
+    {
+        std::lock_guard<std::mutex> guard(mutex);
+
+        if (stats.warmup_frames >= warmup_length)
+        {
+            return;
+        }
+
+        stats.warmup_frames++;
+
+        if (frame_time > frame_budget)
+        {
+            stats.hitch_frames++;
+        }
+
+        stats.max_frame_time_ms = std::max(stats.max_frame_time_ms, std::chrono::duration<float, std::milli>(frame_time).count());
+    }
+
+    HPPPipelineCompileStats HPPPipelineCompiler::get_stats() const
+    {
+        std::lock_guard<std::mutex> guard(mutex);
+
+        return stats;
+    }
+
+    void HPPPipelineCompiler::run()
+    {
+        while (true)
+        {
+            {
+                std::unique_lock<std::mutex> lock(mutex);
+
+                wake.wait(lock, [this]() { return stopping || !jobs.empty(); });
+
+                if (stopping)
+                {
+                    return;
+                }
+            }
+
+            // Taken before the job, so a pause or clear never sees a job taken but not compiled yet
+            std::shared_lock<std::shared_mutex> compiling(compile_mutex);
+
+            Job job;
+            {
+                std::lock_guard<std::mutex> guard(mutex);
+
+                if (jobs.empty())
+                {
+                    continue;
+                }
+
+                job = std::move(jobs.front());
+                jobs.pop_front();
+            }
+
+            auto start = std::chrono::steady_clock::now();
+
+            core::HPPGraphicsPipeline* pipeline = nullptr;
+            std::string                error;
+
+            try
+            {
+                pipeline = &resource_cache.request_graphics_pipeline(job.pipeline_state);
+            }
+            catch (const std::exception& e)
+            {
+                error = e.what();
+            }
+
+            auto end = std::chrono::steady_clock::now();
+
+            {
+                std::lock_guard<std::mutex> guard(mutex);
+
+                stats.max_compile_time_ms = std::max(stats.max_compile_time_ms, elapsed_ms(start, end));
+                stats.max_wait_time_ms    = std::max(stats.max_wait_time_ms, elapsed_ms(job.requested_at, end));
+                stats.pending--;
+
+                auto it = find_pending(job);
+
+                if (pipeline)
+                {
+                    // Found in the cache from now on
+                    pending.erase(it);
+                    stats.compiled++;
+                }
+                else
+                {
+                    it->second.failed = true;
+                    stats.failed++;
+                    stats.last_error = std::move(error);
+                }
+            }
+
+            job.promise.set_value(pipeline);
+        }
+    }
+
+    HPPPipelineCompiler::PendingMap::iterator HPPPipelineCompiler::find_pending(const Job& job)
+    {
+        auto [begin, end] = pending.equal_range(std::make_pair(job.hash.low, job.hash.high));
+
+        return std::find_if(begin, end, [&job](const auto& item) { return item.second.key == job.key; });
+    }
+}
\ No newline at end of file
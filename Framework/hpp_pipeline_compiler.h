@@ -0,0 +1,179 @@
+#pragma once
+
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <future>
+#include <map>
+#include <mutex>
+#include <shared_mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "core/hpp_pipeline.h"
+#include "rendering/hpp_pipeline_state.h"
+
+namespace vkb
+{
+    class HPPResourceCache;
+
+    /**
+     * @brief Counters of the background pipeline compiles, and the frame hitches measured during warm-up
+     */
+    struct HPPPipelineCompileStats
+    {
+        uint64_t requests            = 0;        // Asynchronous requests missing the cache
+        uint64_t deduplicated        = 0;        // Requests joining a compile already queued
+        uint64_t compiled            = 0;
+        uint64_t failed              = 0;
+        size_t   pending             = 0;        // Queued or compiling
+        float    max_wait_time_ms    = 0.0f;     // Longest time from request to completion
+        float    max_compile_time_ms = 0.0f;
+
+        float    frame_budget_ms   = 0.0f;
+        uint32_t warmup_frames     = 0;        // Frames measured so far, up to the warm-up length
+        uint32_t hitch_frames      = 0;        // Frames of the warm-up over budget
+        float    max_frame_time_ms = 0.0f;
+
+        std::string last_error;        // Message of the latest failed compile
+    };
+
+    /**
+     * @brief Handle to a graphics pipeline being compiled in the background, never blocks unless asked to
+     */
+    class HPPPipelineRequest
+    {
+    public:
+        HPPPipelineRequest() = default;
+
+        explicit HPPPipelineRequest(core::HPPGraphicsPipeline& pipeline);
+
+        explicit HPPPipelineRequest(std::shared_future<core::HPPGraphicsPipeline*> future);
+
+        /**
+         * @brief Whether the compile is over, successfully or not
+         */
+        bool is_ready() const;
+
+        /**
+         * @brief Returns the pipeline, or nullptr while it is compiling or if it failed to compile
+         */
+        core::HPPGraphicsPipeline* get() const;
+
+        /**
+         * @brief Waits for the compile to be over, returns nullptr if it failed
+         */
+        core::HPPGraphicsPipeline* wait() const;
+
+    private:
+        core::HPPGraphicsPipeline*                     pipeline = nullptr;
+        std::shared_future<core::HPPGraphicsPipeline*> future;
+    };
+
+    /**
+     * @brief Compiles graphics pipelines on background threads, so recording never waits for the driver.
+     *
+     * A request missing the cache is queued and returns at once, requests for a state already queued share its
+     * compile. Workers build the pipelines through the resource cache, so they are recorded for the next warm-up
+     * and compiled through the per-thread pipeline caches saved to disk. A state failing to compile is remembered,
+     * and is not compiled again until clear().
+     *
+     * Compiles read the cached layouts and render passes, so the owner pauses the workers before any maintenance
+     * that would modify or free them.
+     */
+    class HPPPipelineCompiler
+    {
+    public:
+        /**
+         * @brief Starts the worker threads
+         * @param worker_count Number of threads, zero picks half of the hardware threads
+         */
+        HPPPipelineCompiler(HPPResourceCache& resource_cache, uint32_t worker_count = 0);
+
+        ~HPPPipelineCompiler();
+
+        HPPPipelineCompiler(const HPPPipelineCompiler&)            = delete;
+        HPPPipelineCompiler(HPPPipelineCompiler&&)                 = delete;
+        HPPPipelineCompiler& operator=(const HPPPipelineCompiler&) = delete;
+        HPPPipelineCompiler& operator=(HPPPipelineCompiler&&)      = delete;
+
+        /**
+         * @brief Queues the compile of a state missing the cache, or joins the compile already queued for it
+         */
+        HPPPipelineRequest request(const rendering::HPPPipelineState& pipeline_state);
+
+        /**
+         * @brief Waits for the running compiles, then cancels the others
+         */
+        void clear();
+
+        /**
+         * @brief Drops the queued compiles and forgets the failed states, to be called while paused.
+         *        The requests for the dropped compiles complete without a pipeline.
+         */
+        void cancel();
+
+        /**
+         * @brief Keeps the workers from starting a compile for as long as the returned lock is held
+         * @param wait Whether to wait for the running compiles, if false the lock is not acquired while any is running
+         */
+        std::unique_lock<std::shared_mutex> pause(bool wait);
+
+        /**
+         * @brief Sets the frame time budget and the number of frames the hitches are counted for
+         */
+        void set_hitch_budget(std::chrono::microseconds frame_budget, uint32_t warmup_frames);
+
+        /**
+         * @brief Counts a frame towards the hitch metric, called once per frame with its duration
+         */
+        void end_frame(std::chrono::microseconds frame_time);
+
+        HPPPipelineCompileStats get_stats() const;
+
+    private:
+        // A compile shared by the requests for the same state
+        struct Pending
+        {
+            std::vector<uint8_t>                           key;
+            std::shared_future<core::HPPGraphicsPipeline*> future;
+            bool                                           failed = false;
+        };
+
+        struct Job
+        {
+            rendering::HPPPipelineState              pipeline_state;
+            std::promise<core::HPPGraphicsPipeline*> promise;
+            std::chrono::steady_clock::time_point    requested_at;
+            common::HPPHash128                       hash;
+            std::vector<uint8_t>                     key;
+        };
+
+        // By hash, compiles of states sharing a hash are told apart by their key
+        using PendingMap = std::multimap<std::pair<uint64_t, uint64_t>, Pending>;
+
+        void run();
+
+        // Returns the compile of a job among the pending ones, the mutex must be held
+        PendingMap::iterator find_pending(const Job& job);
+
+        HPPResourceCache& resource_cache;
+
+        mutable std::mutex      mutex;
+        std::condition_variable wake;
+        bool                    stopping = false;
+
+        std::deque<Job> jobs;
+        PendingMap      pending;
+
+        // Held shared by the compiling workers
+        std::shared_mutex compile_mutex;
+
+        HPPPipelineCompileStats   stats;
+        std::chrono::microseconds frame_budget{ 16667 };
+        uint32_t                  warmup_length{ 600 };
+
+        std::vector<std::thread> workers;
+    };
+}
\ No newline at end of file
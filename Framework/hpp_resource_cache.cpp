@@ -1,27 +1,97 @@
 #include "stdafx.h"
 #include "common/hpp_resource_caching.h"
+#include "spirv_cache.h"
+#include "hpp_shader_reloader.h"
 
 namespace vkb
 {
     namespace
     {
-        template <class T, class... A>
-        T& request_resource(
-            core::HPPDevice& device, HPPResourceRecord& recorder, std::mutex& resource_mutex, std::unordered_map<std::size_t, T>& resources, A&... args)
+        vkb::filesystem::Path get_pipeline_cache_path()
         {
-            std::lock_guard<std::mutex> guard(resource_mutex);
+            return vkb::filesystem::Path{ fs::path::get(fs::path::Type::Temp) } / "pipeline_cache.data";
+        }
+
+        vkb::filesystem::Path get_resources_path()
+        {
+            return vkb::filesystem::Path{ fs::path::get(fs::path::Type::Temp) } / "resource_cache.data";
+        }
+
+        // Updates skipping their maintenance for running compiles before one waits for them
+        constexpr uint32_t MAX_DEFERRED_MAINTENANCE = 8;
+
+        // Bump when the layout of the recorded stream, or of a type written raw into it, changes
+        constexpr uint32_t RESOURCES_MAGIC   = 0x52424B56;        // "VKBR"
+        constexpr uint32_t RESOURCES_VERSION = 2;
+
+        struct HPPResourcesHeader
+        {
+            uint32_t magic   = RESOURCES_MAGIC;
+            uint32_t version = RESOURCES_VERSION;
+        };
+
+        float elapsed_ms(std::chrono::steady_clock::time_point start)
+        {
+            return std::chrono::duration<float, std::milli>(std::chrono::steady_clock::now() - start).count();
+        }
+
+        /**
+         * @brief Checks that pipeline cache data was written by the same driver and device,
+         *        as some drivers do not cope with data coming from elsewhere
+         */
+        bool is_pipeline_cache_compatible(const std::vector<uint8_t>& data, const vk::PhysicalDeviceProperties& properties)
+        {
+            VkPipelineCacheHeaderVersionOne header;
+
+            if (data.size() < sizeof(header))
+            {
+                return false;
+            }
 
-            return common::request_resource(device, &recorder, resources, args...);
+            std::memcpy(&header, data.data(), sizeof(header));
+
+            return header.headerSize >= sizeof(header) && header.headerSize <= data.size() &&
+                   header.headerVersion == VK_PIPELINE_CACHE_HEADER_VERSION_ONE &&
+                   header.vendorID == properties.vendorID &&
+                   header.deviceID == properties.deviceID &&
+                   std::memcmp(header.pipelineCacheUUID, properties.pipelineCacheUUID.data(), VK_UUID_SIZE) == 0;
         }
     }
 
     HPPResourceCache::HPPResourceCache(vkb::core::HPPDevice& device) :
         device{device}
-    { }
+    {
+        set_stamps();
+    }
+
+    HPPResourceCache::~HPPResourceCache()
+    {
+        assert(!pipeline_cache && "The pipeline cache must be destroyed before the device");
+    }
 
     void HPPResourceCache::clear()
     {
-        // TODO
+        if (pipeline_compiler)
+        {
+            pipeline_compiler->clear();
+        }
+
+        if (shader_reloader)
+        {
+            shader_reloader->clear();
+            tracked_shader_modules = 0;
+        }
+
+        // Objects are keyed by the handles of the ones they are built from, destroy the dependent ones first
+        state.graphics_pipelines.clear();
+        state.pipeline_layouts.clear();
+        state.descriptor_set_layouts.clear();
+        state.shader_modules.clear();
+        shader_preprocessor.clear();
+
+        clear_framebuffers();
+
+        state.render_passes.clear();
     }
 
     void HPPResourceCache::clear_framebuffers()
@@ -29,15 +99,615 @@ namespace vkb
         state.framebuffers.clear();
     }
 
+    void HPPResourceCache::release_framebuffers(const rendering::HPPRenderTarget& render_target)
+    {
+        // Such framebuffers can never be requested again, free them once the GPU is done with them rather than when they age out
+        state.framebuffers.erase_if([generation = render_target.get_generation()](const core::HPPFramebuffer& framebuffer, uint64_t) {
+            return framebuffer.get_render_target_generation() == generation;
+        });
+    }
+
+    core::HPPShaderModule& HPPResourceCache::request_shader_module(vk::ShaderStageFlagBits       stage,
+                                                                   const core::HPPShaderSource&  glsl_source,
+                                                                   const core::HPPShaderVariant& shader_variant,
+                                                                   const std::string&            entry_point)
+    {
+        auto build = [this](vk::ShaderStageFlagBits stage, const core::HPPShaderSource& glsl_source, const std::string& entry_point, const core::HPPShaderVariant& shader_variant) {
+            return std::make_unique<core::HPPShaderModule>(device, stage, glsl_source, entry_point, shader_variant, &shader_preprocessor);
+        };
+
+        return common::request_resource_with(build, &recorder, state.shader_modules, stage, glsl_source, entry_point, shader_variant);
+    }
+
+    core::HPPDescriptorSetLayout& HPPResourceCache::request_descriptor_set_layout(const core::HPPDescriptorSetLayoutSignature& signature)
+    {
+        // Not recorded, replaying the pipeline layouts requests them again
+        return common::request_resource(device, &recorder, state.descriptor_set_layouts, signature);
+    }
+
+    core::HPPPipelineLayout& HPPResourceCache::request_pipeline_layout(const std::vector<core::HPPShaderModule*>& shader_modules)
+    {
+        return common::request_resource(device, &recorder, state.pipeline_layouts, shader_modules);
+    }
+
+    core::HPPGraphicsPipeline& HPPResourceCache::request_graphics_pipeline(const rendering::HPPPipelineState& pipeline_state)
+    {
+        return common::request_resource(device, &recorder, state.graphics_pipelines, pipeline_state);
+    }
+
+    HPPPipelineRequest HPPResourceCache::request_graphics_pipeline_async(const rendering::HPPPipelineState& pipeline_state)
+    {
+        if (!pipeline_compiler)
+        {
+            return HPPPipelineRequest{ request_graphics_pipeline(pipeline_state) };
+        }
+
+        // Hits never take a lock, only misses are handed to the compiler
+        if (auto pipeline = state.graphics_pipelines.find(common::HPPCacheKey<rendering::HPPPipelineState>{ pipeline_state }))
+        {
+            return HPPPipelineRequest{ *pipeline };
+        }
+
+        return pipeline_compiler->request(pipeline_state);
+    }
+
     core::HPPRenderPass& HPPResourceCache::request_render_pass(const std::vector<rendering::HPPAttachment>& attachments,
                                                                const std::vector<HPPLoadStoreInfo>&         load_store_infos,
                                                                const std::vector<core::HPPSubpassInfo>&     subpasses)
     {
-        return request_resource(device, recorder, render_pass_mutex, state.render_passes, attachments, load_store_infos, subpasses);
+        return request_render_pass(attachments, core::HPPRenderPassDesc{ load_store_infos, subpasses });
+    }
+
+    core::HPPRenderPass& HPPResourceCache::request_render_pass(const std::vector<rendering::HPPAttachment>& attachments, const core::HPPRenderPassDesc& desc)
+    {
+        return common::request_resource(device, &recorder, state.render_passes, attachments, desc);
     }
 
     core::HPPFramebuffer& HPPResourceCache::request_framebuffer(const rendering::HPPRenderTarget& render_target, const core::HPPRenderPass& render_pass)
     {
-        return request_resource(device, recorder, framebuffer_mutex, state.framebuffers, render_target, render_pass);
+        return common::request_resource(device, &recorder, state.framebuffers, render_target, render_pass);
+    }
+
+    std::vector<uint8_t> HPPResourceCache::serialize()
+    {
+        HPPResourcesHeader   header;
+        std::vector<uint8_t> records = recorder.get_data();
+
+        std::vector<uint8_t> data(sizeof(header));
+        std::memcpy(data.data(), &header, sizeof(header));
+        data.insert(data.end(), records.begin(), records.end());
+
+        return data;
+    }
+
+    size_t HPPResourceCache::warmup(const std::vector<uint8_t>& data)
+    {
+        HPPResourcesHeader header;
+
+        if (data.size() < sizeof(header))
+        {
+            return 0;
+        }
+
+        std::memcpy(&header, data.data(), sizeof(header));
+
+        if (header.magic != RESOURCES_MAGIC || header.version != RESOURCES_VERSION)
+        {
+            return 0;
+        }
+
+        HPPResourceReplay replay;
+
+        return replay.play(*this, std::vector<uint8_t>{ data.begin() + sizeof(header), data.end() });
+    }
+
+    size_t HPPResourceCache::load_resources()
+    {
+        auto fs   = vkb::filesystem::get();
+        auto path = get_resources_path();
+
+        if (!fs->is_file(path))
+        {
+            return 0;
+        }
+
+        // A corrupt file only costs the warm-up, the objects are created on first request instead
+        try
+        {
+            return warmup(fs->read_file_binary(path));
+        }
+        catch (const std::exception&)
+        {
+            return 0;
+        }
+    }
+
+    void HPPResourceCache::save_resources()
+    {
+        auto fs   = vkb::filesystem::get();
+        auto path = get_resources_path();
+
+        // As for a corrupt file, a failed save only costs the warm-up of the next run
+        try
+        {
+            fs->write_file_atomic(path, serialize());
+        }
+        catch (const std::exception&)
+        {
+            try
+            {
+                fs->remove(path);
+            }
+            catch (const std::exception&)
+            {
+            }
+        }
+    }
+
+    void HPPResourceCache::create_pipeline_cache()
+    {
+        assert(!pipeline_cache && "The pipeline cache has already been created");
+
+        auto start = std::chrono::steady_clock::now();
+
+        auto fs   = vkb::filesystem::get();
+        auto path = get_pipeline_cache_path();
+
+        if (fs->is_file(path))
+        {
+            pipeline_cache_data = fs->read_file_binary(path);
+
+            if (!is_pipeline_cache_compatible(pipeline_cache_data, device.get_gpu().get_properties()))
+            {
+                pipeline_cache_data.clear();
+            }
+        }
+
+        pipeline_cache_stats.warm_start   = !pipeline_cache_data.empty();
+        pipeline_cache_stats.loaded_bytes = pipeline_cache_data.size();
+        pipeline_cache_stats.load_time_ms = elapsed_ms(start);
+
+        start = std::chrono::steady_clock::now();
+
+        vk::PipelineCacheCreateInfo create_info{ {}, pipeline_cache_data.size(), pipeline_cache_data.data() };
+        pipeline_cache = device.get_handle().createPipelineCache(create_info);
+
+        pipeline_cache_stats.create_time_ms = elapsed_ms(start);
+        pipeline_cache_saved_at             = std::chrono::steady_clock::now();
+    }
+
+    void HPPResourceCache::destroy_pipeline_cache()
+    {
+        // The compile threads own pipeline caches of their own
+        disable_async_pipeline_compile();
+
+        if (!pipeline_cache)
+        {
+            return;
+        }
+
+        save_pipeline_cache();
+
+        std::lock_guard<std::mutex> guard(pipeline_cache_mutex);
+
+        for (auto& thread_pipeline_cache : thread_pipeline_caches)
+        {
+            device.get_handle().destroyPipelineCache(thread_pipeline_cache.second);
+        }
+
+        thread_pipeline_caches.clear();
+
+        device.get_handle().destroyPipelineCache(pipeline_cache);
+        pipeline_cache = nullptr;
+    }
+
+    vk::PipelineCache HPPResourceCache::request_pipeline_cache()
+    {
+        assert(pipeline_cache && "The pipeline cache has not been created");
+
+        std::lock_guard<std::mutex> guard(pipeline_cache_mutex);
+
+        auto it = thread_pipeline_caches.find(std::this_thread::get_id());
+        if (it != thread_pipeline_caches.end())
+        {
+            return it->second;
+        }
+
+        // Threads own separate caches so pipeline creation does not contend on the driver's cache lock,
+        // the main cache is only ever used as the destination of merges
+        vk::PipelineCacheCreateInfo create_info{ {}, pipeline_cache_data.size(), pipeline_cache_data.data() };
+        auto thread_pipeline_cache = device.get_handle().createPipelineCache(create_info);
+
+        thread_pipeline_caches.emplace(std::this_thread::get_id(), thread_pipeline_cache);
+
+        return thread_pipeline_cache;
+    }
+
+    void HPPResourceCache::merge_pipeline_caches()
+    {
+        std::lock_guard<std::mutex> guard(pipeline_cache_mutex);
+
+        merge_pipeline_caches_impl();
+    }
+
+    void HPPResourceCache::save_pipeline_cache()
+    {
+        if (pipeline_cache_save.valid())
+        {
+            pipeline_cache_save.get();
+        }
+
+        write_pipeline_cache();
+    }
+
+    HPPPipelineCacheStats HPPResourceCache::get_pipeline_cache_stats() const
+    {
+        std::lock_guard<std::mutex> guard(pipeline_cache_mutex);
+
+        return pipeline_cache_stats;
+    }
+
+    HPPResourceCacheStats HPPResourceCache::get_stats() const
+    {
+        HPPResourceCacheStats stats;
+
+        stats.shader_modules         = state.shader_modules.get_stats();
+        stats.descriptor_set_layouts = state.descriptor_set_layouts.get_stats();
+        stats.pipeline_layouts       = state.pipeline_layouts.get_stats();
+        stats.graphics_pipelines     = state.graphics_pipelines.get_stats();
+        stats.render_passes          = state.render_passes.get_stats();
+        stats.framebuffers           = state.framebuffers.get_stats();
+        stats.pipeline_cache         = get_pipeline_cache_stats();
+
+        if (pipeline_compiler)
+        {
+            stats.pipeline_compiles = pipeline_compiler->get_stats();
+        }
+
+        if (shader_reloader)
+        {
+            stats.shader_reloads = shader_reloader->get_stats();
+        }
+
+        return stats;
+    }
+
+    void HPPResourceCache::dump_stats() const
+    {
+        auto stats = get_stats();
+
+        std::ostringstream os;
+
+        os << "type                   hits        misses      build_us    max_build_us  live     bytes\n";
+
+        auto dump = [&os](const char* name, const common::HPPCacheStats& type_stats) {
+            os << std::left << std::setw(23) << name
+               << std::setw(12) << type_stats.hits
+               << std::setw(12) << type_stats.misses
+               << std::setw(12) << type_stats.build_time_us
+               << std::setw(14) << type_stats.max_build_time_us
+               << std::setw(9) << type_stats.live_count
+               << type_stats.live_bytes << "\n";
+        };
+
+        dump("shader_module", stats.shader_modules);
+        dump("descriptor_set_layout", stats.descriptor_set_layouts);
+        dump("pipeline_layout", stats.pipeline_layouts);
+        dump("graphics_pipeline", stats.graphics_pipelines);
+        dump("render_pass", stats.render_passes);
+        dump("framebuffer", stats.framebuffers);
+
+        os << "\npipeline_cache warm_start " << stats.pipeline_cache.warm_start
+           << " loaded_bytes " << stats.pipeline_cache.loaded_bytes
+           << " saved_bytes " << stats.pipeline_cache.saved_bytes
+           << " save_count " << stats.pipeline_cache.save_count
+           << " save_failures " << stats.pipeline_cache.save_failures << "\n";
+
+        if (!stats.pipeline_cache.last_save_error.empty())
+        {
+            os << "pipeline_cache last_save_error " << stats.pipeline_cache.last_save_error << "\n";
+        }
+
+        os << "pipeline_compiles requests " << stats.pipeline_compiles.requests
+           << " deduplicated " << stats.pipeline_compiles.deduplicated
+           << " compiled " << stats.pipeline_compiles.compiled
+           << " failed " << stats.pipeline_compiles.failed
+           << " pending " << stats.pipeline_compiles.pending
+           << " max_wait_ms " << stats.pipeline_compiles.max_wait_time_ms
+           << " max_compile_ms " << stats.pipeline_compiles.max_compile_time_ms << "\n";
+
+        os << "warmup_hitches frames " << stats.pipeline_compiles.warmup_frames
+           << " over_budget " << stats.pipeline_compiles.hitch_frames
+           << " budget_ms " << stats.pipeline_compiles.frame_budget_ms
+           << " max_frame_ms " << stats.pipeline_compiles.max_frame_time_ms << "\n";
+
+        if (!stats.pipeline_compiles.last_error.empty())
+        {
+            os << "pipeline_compiles last_error " << stats.pipeline_compiles.last_error << "\n";
+        }
+
+        os << "shader_reloads reloaded " << stats.shader_reloads.reloaded
+           << " failed " << stats.shader_reloads.failed << "\n";
+
+        if (!stats.shader_reloads.last_error.empty())
+        {
+            os << "shader_reloads last_error " << stats.shader_reloads.last_error << "\n";
+        }
+
+        auto spirv_stats = SPIRVCache::get().get_stats();
+        auto lookups     = spirv_stats.hits + spirv_stats.misses;
+
+        os << "spirv_cache hits " << spirv_stats.hits
+           << " misses " << spirv_stats.misses
+           << " deduplicated " << spirv_stats.deduplicated
+           << " hit_ratio " << (lookups ? static_cast<float>(spirv_stats.hits) / lookups : 0.0f)
+           << " load_ms " << spirv_stats.load_time_ms
+           << " saved_ms " << spirv_stats.saved_time_ms
+           << " reflection_hits " << spirv_stats.reflection_hits
+           << " reflection_misses " << spirv_stats.reflection_misses << "\n";
+
+        auto blob_stats = core::HPPShaderModule::get_blob_stats();
+
+        os << "shader_blobs interned " << blob_stats.interned_count
+           << " shared " << blob_stats.shared_count
+           << " saved_bytes " << blob_stats.saved_bytes
+           << " live_bytes " << blob_stats.live_bytes << "\n";
+
+        std::string report = os.str();
+
+        vkb::filesystem::get()->write_file(fs::path::get(fs::path::Type::Logs, "resource_cache_stats.txt"),
+                                           std::vector<uint8_t>{ report.begin(), report.end() });
+    }
+
+    void HPPResourceCache::enable_shader_reload(std::chrono::milliseconds poll_interval)
+    {
+        shader_reloader        = std::make_unique<HPPShaderReloader>(device, shader_preprocessor, poll_interval);
+        tracked_shader_modules = 0;
+    }
+
+    void HPPResourceCache::disable_shader_reload()
+    {
+        shader_reloader.reset();
+    }
+
+    void HPPResourceCache::enable_async_pipeline_compile(uint32_t worker_count, std::chrono::microseconds frame_budget, uint32_t warmup_frames)
+    {
+        pipeline_compiler = std::make_unique<HPPPipelineCompiler>(*this, worker_count);
+        pipeline_compiler->set_hitch_budget(frame_budget, warmup_frames);
+
+        deferred_maintenance = 0;
+        updated_at           = {};
+    }
+
+    void HPPResourceCache::disable_async_pipeline_compile()
+    {
+        pipeline_compiler.reset();
+    }
+
+    void HPPResourceCache::update(uint64_t completed_frame)
+    {
+        auto now = std::chrono::steady_clock::now();
+
+        std::unique_lock<std::shared_mutex> compiles_paused;
+
+        if (pipeline_compiler)
+        {
+            if (updated_at != std::chrono::steady_clock::time_point{})
+            {
+                pipeline_compiler->end_frame(std::chrono::duration_cast<std::chrono::microseconds>(now - updated_at));
+            }
+
+            // Reloads and reclaims modify and free objects the compiles read, skip them while compiles run rather than
+            // waiting, unless they were skipped for too long
+            compiles_paused = pipeline_compiler->pause(deferred_maintenance >= MAX_DEFERRED_MAINTENANCE);
+        }
+
+        updated_at = now;
+
+        bool maintain = !pipeline_compiler || compiles_paused.owns_lock();
+
+        deferred_maintenance = maintain ? 0 : deferred_maintenance + 1;
+
+        if (shader_reloader && maintain)
+        {
+            apply_shader_reloads();
+        }
+
+        if (frame > framebuffer_max_age)
+        {
+            uint64_t oldest = frame - framebuffer_max_age;
+
+            state.framebuffers.erase_if([oldest](const core::HPPFramebuffer&, uint64_t last_used) {
+                return last_used < oldest;
+            });
+        }
+
+        // The frame is over, no request can be walking the superseded snapshots. The objects erased in a frame the GPU
+        // has completed are destroyed with them, as no pending command buffer can reference them. Dependent ones go first.
+        if (maintain)
+        {
+            state.graphics_pipelines.reclaim(completed_frame);
+            state.pipeline_layouts.reclaim(completed_frame);
+            state.descriptor_set_layouts.reclaim(completed_frame);
+            state.shader_modules.reclaim(completed_frame);
+            state.framebuffers.reclaim(completed_frame);
+            state.render_passes.reclaim(completed_frame);
+        }
+
+        // Resume the compiles
+        compiles_paused = {};
+
+        frame++;
+        set_stamps();
+
+        if (stats_dump_interval.count() > 0 && std::chrono::steady_clock::now() - stats_dumped_at >= stats_dump_interval)
+        {
+            stats_dumped_at = std::chrono::steady_clock::now();
+            dump_stats();
+        }
+
+        if (!pipeline_cache || std::chrono::steady_clock::now() - pipeline_cache_saved_at < pipeline_cache_save_interval)
+        {
+            return;
+        }
+
+        // Skip this period if the previous save is still being written
+        if (pipeline_cache_save.valid() &&
+            pipeline_cache_save.wait_for(std::chrono::seconds(0)) != std::future_status::ready)
+        {
+            return;
+        }
+
+        if (pipeline_cache_save.valid())
+        {
+            pipeline_cache_save.get();
+        }
+
+        pipeline_cache_saved_at = std::chrono::steady_clock::now();
+        pipeline_cache_save     = std::async(std::launch::async, [this]() { write_pipeline_cache(); });
+    }
+
+    void HPPResourceCache::set_stamps()
+    {
+        state.shader_modules.set_stamp(frame);
+        state.descriptor_set_layouts.set_stamp(frame);
+        state.pipeline_layouts.set_stamp(frame);
+        state.graphics_pipelines.set_stamp(frame);
+        state.render_passes.set_stamp(frame);
+        state.framebuffers.set_stamp(frame);
+    }
+
+    void HPPResourceCache::apply_shader_reloads()
+    {
+        // Modules are only added between clears, a new count means new modules to watch. The count is taken again
+        // below when reloaded duplicates are erased.
+        if (state.shader_modules.size() != tracked_shader_modules)
+        {
+            state.shader_modules.for_each([this](core::HPPShaderModule& shader_module) { shader_reloader->track(shader_module); });
+            tracked_shader_modules = state.shader_modules.size();
+        }
+
+        auto reloads = shader_reloader->take_reloads();
+
+        if (reloads.empty())
+        {
+            return;
+        }
+
+        // Modules are swapped in place, so the references handed out stay valid
+        std::unordered_set<const core::HPPShaderModule*> reloaded;
+        std::unordered_set<const core::HPPShaderModule*> duplicates;
+
+        for (auto& reload : reloads)
+        {
+            auto& target = *reload.target;
+
+            target.reload(std::move(*reload.module));
+            reloaded.insert(&target);
+
+            // The entry is keyed by the source the module was first built from, move it under the edited one so requests
+            // reading the file again find it. If one of them already built its own module, that module is kept instead.
+            auto stage = target.get_stage();
+
+            common::HPPCacheKey<vk::ShaderStageFlagBits, const core::HPPShaderSource, const std::string, const core::HPPShaderVariant> key{
+                stage, target.get_source(), target.get_entry_point(), target.get_variant() };
+
+            if (!state.shader_modules.rekey(target, key))
+            {
+                duplicates.insert(&target);
+            }
+        }
+
+        // Their layouts are evicted below as for any reloaded module, the modules are destroyed once the GPU is done with them
+        if (!duplicates.empty())
+        {
+            for (auto* shader_module : state.shader_modules.erase_if([&duplicates](const core::HPPShaderModule& shader_module, uint64_t) {
+                     return duplicates.contains(&shader_module);
+                 }))
+            {
+                shader_reloader->untrack(*shader_module);
+            }
+
+            tracked_shader_modules = state.shader_modules.size();
+        }
+
+        auto uses_reloaded = [&reloaded](const std::vector<core::HPPShaderModule*>& shader_modules) {
+            return std::ranges::any_of(shader_modules, [&reloaded](const core::HPPShaderModule* shader_module) { return reloaded.contains(shader_module); });
+        };
+
+        // Pipeline layouts are keyed by the ids of the modules, which changed with their code, so requests build new ones.
+        // Evict the ones built from the previous code along with their pipelines. Descriptor set layouts are keyed by
+        // their bindings alone, they stay cached for the new pipeline layouts to share.
+        auto pipeline_layouts = state.pipeline_layouts.erase_if([&uses_reloaded](const core::HPPPipelineLayout& pipeline_layout, uint64_t) {
+            return uses_reloaded(pipeline_layout.get_shader_modules());
+        });
+
+        std::unordered_set<const core::HPPPipelineLayout*> stale_layouts(pipeline_layouts.begin(), pipeline_layouts.end());
+
+        state.graphics_pipelines.erase_if([&stale_layouts](const core::HPPGraphicsPipeline& pipeline, uint64_t) {
+            return stale_layouts.contains(&pipeline.get_state().get_pipeline_layout());
+        });
+
+        // Queued compiles may be for the stale layouts, the draws waiting for them request them again
+        if (pipeline_compiler)
+        {
+            pipeline_compiler->cancel();
+        }
+    }
+
+    void HPPResourceCache::merge_pipeline_caches_impl()
+    {
+        std::vector<vk::PipelineCache> src_caches;
+        src_caches.reserve(thread_pipeline_caches.size());
+
+        for (auto& thread_pipeline_cache : thread_pipeline_caches)
+        {
+            src_caches.push_back(thread_pipeline_cache.second);
+        }
+
+        if (!src_caches.empty())
+        {
+            device.get_handle().mergePipelineCaches(pipeline_cache, src_caches);
+        }
+    }
+
+    void HPPResourceCache::write_pipeline_cache()
+    {
+        auto start = std::chrono::steady_clock::now();
+
+        std::vector<uint8_t> data;
+        std::string          error;
+        bool                 failed = false;
+
+        // Runs from the destructor of the device and from the frame loop, a failed save only costs the next warm start
+        try
+        {
+            {
+                std::lock_guard<std::mutex> guard(pipeline_cache_mutex);
+
+                merge_pipeline_caches_impl();
+                data = device.get_handle().getPipelineCacheData(pipeline_cache);
+            }
+
+            vkb::filesystem::get()->write_file_atomic(get_pipeline_cache_path(), data);
+        }
+        catch (const std::exception& e)
+        {
+            error  = e.what();
+            failed = true;
+        }
+
+        std::lock_guard<std::mutex> guard(pipeline_cache_mutex);
+
+        if (failed)
+        {
+            pipeline_cache_stats.save_failures++;
+            pipeline_cache_stats.last_save_error = std::move(error);
+            return;
+        }
+
+        pipeline_cache_stats.saved_bytes  = data.size();
+        pipeline_cache_stats.save_time_ms = elapsed_ms(start);
+        pipeline_cache_stats.save_count++;
     }
 }
\ No newline at end of file
@@ -2,7 +2,15 @@
 
 #include "core/hpp_render_pass.h"
 #include "core/hpp_framebuffer.h"
+#include "core/hpp_shader_module.h"
+#include "core/hpp_descriptor_set_layout.h"
+#include "core/hpp_pipeline_layout.h"
+#include "core/hpp_pipeline.h"
 #include "hpp_resource_record.h"
+#include "hpp_pipeline_compiler.h"
+#include "hpp_shader_reloader.h"
+#include "shader_preprocessor.h"
+#include "common/hpp_sharded_cache.h"
 
 namespace vkb
 {
@@ -11,8 +19,45 @@ namespace vkb
      */
     struct HPPResourceCacheState
     {
-        std::unordered_map<std::size_t, core::HPPRenderPass> render_passes;
-        std::unordered_map<std::size_t, core::HPPFramebuffer> framebuffers;
+        common::HPPShardedCache<core::HPPShaderModule>        shader_modules;
+        common::HPPShardedCache<core::HPPDescriptorSetLayout> descriptor_set_layouts;
+        common::HPPShardedCache<core::HPPPipelineLayout>      pipeline_layouts;
+        common::HPPShardedCache<core::HPPGraphicsPipeline>    graphics_pipelines;
+        common::HPPShardedCache<core::HPPRenderPass>          render_passes;
+        common::HPPShardedCache<core::HPPFramebuffer>         framebuffers;
+    };
+
+    /**
+     * @brief Load and save timings of the persistent pipeline cache
+     */
+    struct HPPPipelineCacheStats
+    {
+        bool     warm_start     = false;        // Whether the cache was seeded from a valid file on disk
+        size_t   loaded_bytes   = 0;
+        float    load_time_ms   = 0.0f;         // Reading and validating the file
+        float    create_time_ms = 0.0f;         // Creating the driver cache from the loaded data
+        size_t   saved_bytes    = 0;
+        float    save_time_ms   = 0.0f;         // Last merge and write back to disk
+        uint32_t save_count     = 0;
+        uint32_t save_failures  = 0;
+
+        std::string last_save_error;        // Message of the latest failed save
+    };
+
+    /**
+     * @brief Usage counters of every type of object in the cache
+     */
+    struct HPPResourceCacheStats
+    {
+        common::HPPCacheStats shader_modules;
+        common::HPPCacheStats descriptor_set_layouts;
+        common::HPPCacheStats pipeline_layouts;
+        common::HPPCacheStats graphics_pipelines;
+        common::HPPCacheStats render_passes;
+        common::HPPCacheStats framebuffers;
+        HPPPipelineCacheStats   pipeline_cache;
+        HPPPipelineCompileStats pipeline_compiles;
+        HPPShaderReloadStats    shader_reloads;
     };
 
     /**
@@ -23,34 +68,242 @@ namespace vkb
      * Some objects may need building if they are not found in the cache.
      *
      * The resource cache is also linked with ResourceRecord and ResourceReplay. Replay can warm-up
-     * the cache on app startup by creating all necessary objects.
+     * the cache on app startup by creating all necessary objects, recorded by a previous run and
+     * saved in the temporary directory.
      * The cache holds pointers to objects and has a mapping from such pointers to hashes.
-     * It can only be destroyed in bulk, single elements cannot be removed.
+     * Lookups of cached objects are lock-free, only a miss takes the lock of one shard of the cache.
+     *
+     * Each lookup stamps the object with the current frame. Framebuffers not used for a number of frames
+     * are evicted, as are the ones created for a released render target. Evicted objects
+     * are destroyed once the frames that may have used them have completed on the GPU.
+     *
+     * With shader reload enabled, shader modules are rebuilt in the background when their files change and
+     * swapped in by update(), which evicts the layouts and pipelines built from their previous code.
+     *
+     * The cache also owns the vk::PipelineCache of the device, which persists across runs in the
+     * temporary directory. Each thread gets its own pipeline cache, merged into the main one on save.
+     *
+     * With asynchronous pipeline compiles enabled, missing graphics pipelines can be requested without waiting,
+     * they are compiled on background threads. update() defers its maintenance while compiles run.
      */
     class HPPResourceCache
     {
     public:
         HPPResourceCache(vkb::core::HPPDevice& device);
+        ~HPPResourceCache();
 
         HPPResourceCache(const HPPResourceCache&)            = delete;
         HPPResourceCache(HPPResourceCache&&)                 = delete;
         HPPResourceCache& operator=(const HPPResourceCache&) = delete;
         HPPResourceCache& operator=(HPPResourceCache&&)      = delete;
 
+        /**
+         * @brief Destroys all the cached objects, the device must be idle
+         */
         void clear();
+
+        /**
+         * @brief Destroys all the cached framebuffers, the device must be idle
+         */
         void clear_framebuffers();
 
+        /**
+         * @brief Evicts the framebuffers created for a render target, to be called when it is destroyed
+         */
+        void release_framebuffers(const rendering::HPPRenderTarget& render_target);
+
+        /**
+         * @brief Sets how many frames a framebuffer can stay unused before it is evicted
+         */
+        void set_framebuffer_max_age(uint32_t frames) { framebuffer_max_age = frames; }
+
+        /**
+         * @brief Starts watching the files of the cached shader modules, including the ones they include.
+         *        Changed modules are rebuilt on a background thread and swapped in by update().
+         * @param poll_interval How often the files are checked for changes
+         */
+        void enable_shader_reload(std::chrono::milliseconds poll_interval = std::chrono::milliseconds(500));
+
+        void disable_shader_reload();
+
+        /**
+         * @brief Starts compiling the pipelines missed by request_graphics_pipeline_async() on background threads,
+         *        and counts the frames of the warm-up going over budget
+         * @param worker_count Number of compile threads, zero picks half of the hardware threads
+         * @param frame_budget Frame time above which a frame counts as a hitch
+         * @param warmup_frames Number of frames the hitches are counted for
+         */
+        void enable_async_pipeline_compile(uint32_t                  worker_count  = 0,
+                                           std::chrono::microseconds frame_budget  = std::chrono::microseconds(16667),
+                                           uint32_t                  warmup_frames = 600);
+
+        /**
+         * @brief Waits for the running compiles and stops the compile threads, the queued compiles complete as failed
+         */
+        void disable_async_pipeline_compile();
+
+        /**
+         * @brief Returns the frame objects are currently stamped with
+         */
+        uint64_t get_frame() const { return frame; }
+
+        /**
+         * @brief Requests a shader module, identified by the ids of its source and variant, its stage and its entry point.
+         *        Only a miss compiles and reflects the source.
+         */
+        core::HPPShaderModule& request_shader_module(vk::ShaderStageFlagBits       stage,
+                                                     const core::HPPShaderSource&  glsl_source,
+                                                     const core::HPPShaderVariant& shader_variant = {},
+                                                     const std::string&            entry_point    = "main");
+
+        /**
+         * @brief Requests a descriptor set layout by its bindings alone, so every set of the same signature shares one layout
+         */
+        core::HPPDescriptorSetLayout& request_descriptor_set_layout(const core::HPPDescriptorSetLayoutSignature& signature);
+
+        /**
+         * @brief Requests a pipeline layout, shared by the lists of shader modules compiled to the same binaries
+         */
+        core::HPPPipelineLayout& request_pipeline_layout(const std::vector<core::HPPShaderModule*>& shader_modules);
+
+        /**
+         * @brief Requests a graphics pipeline, built through the pipeline cache of the calling thread on a miss.
+         *        The pipeline layout and render pass of the state must have been requested from this cache.
+         */
+        core::HPPGraphicsPipeline& request_graphics_pipeline(const rendering::HPPPipelineState& pipeline_state);
+
+        /**
+         * @brief Requests a graphics pipeline without waiting for it to compile. A miss is compiled in the background,
+         *        the returned request holds no pipeline until then. Behaves as request_graphics_pipeline() if
+         *        asynchronous compiles are not enabled.
+         */
+        HPPPipelineRequest request_graphics_pipeline_async(const rendering::HPPPipelineState& pipeline_state);
+
         core::HPPRenderPass& request_render_pass(const std::vector<rendering::HPPAttachment>& attachments,
                                                  const std::vector<HPPLoadStoreInfo>&         load_store_infos,
                                                  const std::vector<core::HPPSubpassInfo>&     subpasses);
+
+        /**
+         * @brief Requests a render pass through a precomputed description, a hit neither allocates nor hashes the subpasses
+         */
+        core::HPPRenderPass& request_render_pass(const std::vector<rendering::HPPAttachment>& attachments, const core::HPPRenderPassDesc& desc);
         core::HPPFramebuffer& request_framebuffer(const rendering::HPPRenderTarget& render_target, const core::HPPRenderPass& render_pass);
 
+        /**
+         * @brief Returns the recorded object requests, prefixed with a header identifying the stream format
+         */
+        std::vector<uint8_t> serialize();
+
+        /**
+         * @brief Creates the objects of a stream returned by serialize() in parallel.
+         *        A stream written with another format is ignored, as are the objects failing to build.
+         * @return The number of objects available in the cache from the stream
+         */
+        size_t warmup(const std::vector<uint8_t>& data);
+
+        /**
+         * @brief Warms up the cache from the objects saved by a previous run, to be called before the first frame
+         * @return The number of objects available in the cache from the file
+         */
+        size_t load_resources();
+
+        /**
+         * @brief Atomically replaces the file read by load_resources() with the objects recorded so far.
+         *        Never throws, as it runs on shutdown, the file is removed if it cannot be written.
+         */
+        void save_resources();
+
+        /**
+         * @brief Creates the pipeline cache, seeded from the file saved by a previous run if it was
+         *        written by the same driver and device. Called once the device handle is created.
+         */
+        void create_pipeline_cache();
+
+        /**
+         * @brief Merges the per-thread pipeline caches, writes the result back to disk and destroys all of them.
+         *        Stops the asynchronous pipeline compiles first. Must be called before the device handle is destroyed.
+         */
+        void destroy_pipeline_cache();
+
+        /**
+         * @brief Returns the pipeline cache of the calling thread, creating it on first use
+         */
+        vk::PipelineCache request_pipeline_cache();
+
+        /**
+         * @brief Merges the per-thread pipeline caches into the main one
+         */
+        void merge_pipeline_caches();
+
+        /**
+         * @brief Merges the pipeline caches and atomically replaces the file on disk with their content.
+         *        Never throws, a failed save is counted in the stats and leaves the previous file in place.
+         */
+        void save_pipeline_cache();
+
+        /**
+         * @brief Sets how often update() writes the pipeline cache back to disk
+         */
+        void set_pipeline_cache_save_interval(std::chrono::seconds interval) { pipeline_cache_save_interval = interval; }
+
+        HPPPipelineCacheStats get_pipeline_cache_stats() const;
+
+        HPPResourceCacheStats get_stats() const;
+
+        /**
+         * @brief Writes the counters of get_stats() as text to resource_cache_stats.txt in the logs directory
+         */
+        void dump_stats() const;
+
+        /**
+         * @brief Sets how often update() dumps the counters, zero disables the periodic dump
+         */
+        void set_stats_dump_interval(std::chrono::seconds interval) { stats_dump_interval = interval; }
+
+        /**
+         * @brief Periodic maintenance, called by the render context at the end of every frame.
+         *        Swaps in the reloaded shader modules, evicts the stale framebuffers, destroys the evicted objects the GPU is done with and advances the frame.
+         *        Must not run concurrently with requests to the cache.
+         * @param completed_frame The last frame whose command buffers are known to have completed execution
+         */
+        void update(uint64_t completed_frame);
+
+    private:
+        void merge_pipeline_caches_impl();
+        void write_pipeline_cache();
+
+        void set_stamps();
+
+        void apply_shader_reloads();
+
     private:
         vkb::core::HPPDevice&  device;
         vkb::HPPResourceRecord recorder;
-        vk::PipelineCache      pipeline_cache = nullptr;
-        HPPResourceCacheState  state = {};
-        std::mutex             render_pass_mutex = {};
-        std::mutex             framebuffer_mutex = {};
+        HPPResourceCacheState  state;
+
+        uint64_t frame{ 1 };
+        uint32_t framebuffer_max_age{ 240 };
+
+        // Shared by the shader modules, so the headers they include are read once
+        ShaderPreprocessor shader_preprocessor;
+
+        std::unique_ptr<HPPShaderReloader> shader_reloader;
+        size_t                             tracked_shader_modules{ 0 };        // Cached modules when they were last handed to the reloader
+
+        std::unique_ptr<HPPPipelineCompiler>  pipeline_compiler;
+        uint32_t                              deferred_maintenance{ 0 };        // Updates in a row skipping maintenance for running compiles
+        std::chrono::steady_clock::time_point updated_at;                        // Last update, which ends a frame
+
+        vk::PipelineCache                                      pipeline_cache = nullptr;
+        std::vector<uint8_t>                                   pipeline_cache_data;          // Validated data the caches are seeded with
+        std::unordered_map<std::thread::id, vk::PipelineCache> thread_pipeline_caches;
+        mutable std::mutex                                     pipeline_cache_mutex;
+        HPPPipelineCacheStats                                  pipeline_cache_stats;
+        std::chrono::seconds                                   pipeline_cache_save_interval{ 60 };
+        std::chrono::steady_clock::time_point                  pipeline_cache_saved_at;
+        std::future<void>                                      pipeline_cache_save;          // Pending background save
+
+        std::chrono::seconds                  stats_dump_interval{ 10 };
+        std::chrono::steady_clock::time_point stats_dumped_at{ std::chrono::steady_clock::now() };
     };
 }
\ No newline at end of file
@@ -12,14 +12,76 @@ namespace vkb
             {
                 write(os, item.input_attachments);
                 write(os, item.output_attachments);
+                write(os, item.color_resolve_attachments);
+                write(os, item.disable_depth_stencil_attachment);
+                write(os, item.depth_stencil_resolve_attachment);
+                write(os, item.depth_stencil_resolve_mode);
+            }
+        }
+
+        inline void write_processes(std::ostringstream& os, const std::vector<std::string>& value)
+        {
+            write(os, value.size());
+            for (const std::string& item : value)
+            {
+                write(os, item);
             }
         }
     }
 
+    size_t HPPResourceRecord::register_shader_module(vk::ShaderStageFlagBits       stage,
+                                                     const core::HPPShaderSource&  glsl_source,
+                                                     const std::string&            entry_point,
+                                                     const core::HPPShaderVariant& shader_variant)
+    {
+        std::lock_guard<std::mutex> guard(mutex);
+
+        shader_module_indices.push_back(shader_module_indices.size());
+
+        // Modules loaded from a file record its name, replay reads the file again so an edited shader warms up the module
+        // the next requests build. Only sources without a file record their text.
+        auto& filename = glsl_source.get_filename();
+
+        write(stream, ResourceType::ShaderModule, stage, filename, filename.empty() ? glsl_source.get_source() : std::string{}, entry_point, shader_variant.get_preamble());
+
+        write_processes(stream, shader_variant.get_processes());
+
+        write(stream, std::map<std::string, size_t>{ shader_variant.get_runtime_array_sizes().begin(), shader_variant.get_runtime_array_sizes().end() });
+
+        return shader_module_indices.back();
+    }
+
+    size_t HPPResourceRecord::register_pipeline_layout(const std::vector<core::HPPShaderModule*>& shader_modules)
+    {
+        std::lock_guard<std::mutex> guard(mutex);
+
+        std::vector<size_t> shader_indices;
+        shader_indices.reserve(shader_modules.size());
+
+        for (auto* shader_module : shader_modules)
+        {
+            auto it = shader_module_to_index.find(shader_module);
+            if (it == shader_module_to_index.end())
+            {
+                return NOT_RECORDED;
+            }
+
+            shader_indices.push_back(it->second);
+        }
+
+        pipeline_layout_indices.push_back(pipeline_layout_indices.size());
+
+        write(stream, ResourceType::PipelineLayout, shader_indices);
+
+        return pipeline_layout_indices.back();
+    }
+
     size_t HPPResourceRecord::register_render_pass(const std::vector<rendering::HPPAttachment>& attachments,
                                                    const std::vector<HPPLoadStoreInfo>&         load_store_infos,
                                                    const std::vector<core::HPPSubpassInfo>&     subpasses)
     {
+        std::lock_guard<std::mutex> guard(mutex);
+
         render_pass_indices.push_back(render_pass_indices.size());
 
         write(stream,
@@ -32,8 +94,84 @@ namespace vkb
         return render_pass_indices.back();
     }
 
+    size_t HPPResourceRecord::register_render_pass(const std::vector<rendering::HPPAttachment>& attachments, const core::HPPRenderPassDesc& desc)
+    {
+        return register_render_pass(attachments, desc.get_load_store_infos(), desc.get_subpasses());
+    }
+
+    size_t HPPResourceRecord::register_graphics_pipeline(const rendering::HPPPipelineState& pipeline_state)
+    {
+        std::lock_guard<std::mutex> guard(mutex);
+
+        auto pipeline_layout_it = pipeline_layout_to_index.find(&pipeline_state.get_pipeline_layout());
+        auto render_pass_it     = render_pass_to_index.find(pipeline_state.get_render_pass());
+
+        if (pipeline_layout_it == pipeline_layout_to_index.end() || render_pass_it == render_pass_to_index.end())
+        {
+            return NOT_RECORDED;
+        }
+
+        graphics_pipeline_indices.push_back(graphics_pipeline_indices.size());
+
+        write(stream,
+              ResourceType::GraphicsPipeline,
+              pipeline_layout_it->second,
+              render_pass_it->second,
+              pipeline_state.get_subpass_index());
+
+        auto& vertex_input_state = pipeline_state.get_vertex_input_state();
+
+        write(stream,
+              vertex_input_state.bindings,
+              vertex_input_state.attributes,
+              pipeline_state.get_input_assembly_state(),
+              pipeline_state.get_rasterization_state(),
+              pipeline_state.get_viewport_state(),
+              pipeline_state.get_multisample_state(),
+              pipeline_state.get_depth_stencil_state());
+
+        auto& color_blend_state = pipeline_state.get_color_blend_state();
+
+        write(stream,
+              color_blend_state.logic_op,
+              color_blend_state.logic_op_enable,
+              color_blend_state.attachments);
+
+        return graphics_pipeline_indices.back();
+    }
+
+    void HPPResourceRecord::set_shader_module(size_t index, const core::HPPShaderModule& shader_module)
+    {
+        std::lock_guard<std::mutex> guard(mutex);
+
+        shader_module_to_index[&shader_module] = index;
+    }
+
+    void HPPResourceRecord::set_pipeline_layout(size_t index, const core::HPPPipelineLayout& pipeline_layout)
+    {
+        if (index == NOT_RECORDED)
+        {
+            return;
+        }
+
+        std::lock_guard<std::mutex> guard(mutex);
+
+        pipeline_layout_to_index[&pipeline_layout] = index;
+    }
+
     void HPPResourceRecord::set_render_pass(size_t index, const core::HPPRenderPass& render_pass)
     {
+        std::lock_guard<std::mutex> guard(mutex);
+
         render_pass_to_index[&render_pass] = index;
     }
+
+    std::vector<uint8_t> HPPResourceRecord::get_data()
+    {
+        std::lock_guard<std::mutex> guard(mutex);
+
+        std::string str = stream.str();
+
+        return std::vector<uint8_t>{ str.begin(), str.end() };
+    }
 }
\ No newline at end of file
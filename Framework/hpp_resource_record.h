@@ -12,21 +12,59 @@ namespace vkb
 
     /**
      * @brief Writes Vulkan objects in a memory stream
+     *        Registration is thread safe, as the resource cache records from all threads creating objects
      */
     class HPPResourceRecord
     {
     public:
+        /**
+         * @brief Index returned for an object that cannot be recorded, as it depends on objects not created through the cache
+         */
+        static constexpr size_t NOT_RECORDED = std::numeric_limits<size_t>::max();
+
+        size_t register_shader_module(vk::ShaderStageFlagBits       stage,
+                                      const core::HPPShaderSource&  glsl_source,
+                                      const std::string&            entry_point,
+                                      const core::HPPShaderVariant& shader_variant);
+
+        size_t register_pipeline_layout(const std::vector<core::HPPShaderModule*>& shader_modules);
+
         size_t register_render_pass(const std::vector<rendering::HPPAttachment>& attachments,
                                     const std::vector<HPPLoadStoreInfo>&         load_store_infos,
                                     const std::vector<core::HPPSubpassInfo>&     subpasses);
 
+        size_t register_render_pass(const std::vector<rendering::HPPAttachment>& attachments, const core::HPPRenderPassDesc& desc);
+
+        size_t register_graphics_pipeline(const rendering::HPPPipelineState& pipeline_state);
+
+        void set_shader_module(size_t index, const core::HPPShaderModule& shader_module);
+
+        void set_pipeline_layout(size_t index, const core::HPPPipelineLayout& pipeline_layout);
+
         void set_render_pass(size_t index, const core::HPPRenderPass& render_pass);
 
+        /**
+         * @brief Returns a copy of the recorded stream, which HPPResourceReplay can play back
+         */
+        std::vector<uint8_t> get_data();
+
     private:
+        std::mutex mutex;
+
         std::ostringstream stream;
 
+        std::vector<size_t> shader_module_indices;
+
+        std::vector<size_t> pipeline_layout_indices;
+
         std::vector<size_t> render_pass_indices;
 
+        std::vector<size_t> graphics_pipeline_indices;
+
+        std::unordered_map<const core::HPPShaderModule*, size_t> shader_module_to_index;
+
+        std::unordered_map<const core::HPPPipelineLayout*, size_t> pipeline_layout_to_index;
+
         std::unordered_map<const core::HPPRenderPass*, size_t> render_pass_to_index;
     };
 }
\ No newline at end of file
@@ -0,0 +1,293 @@
+#include "stdafx.h"
+#include "common/helpers.h"
+
+namespace vkb
+{
+    namespace
+    {
+        inline void read_subpass_info(std::istringstream& is, std::vector<core::HPPSubpassInfo>& value)
+        {
+            std::size_t size;
+            read(is, size);
+            value.resize(size);
+            for (core::HPPSubpassInfo& item : value)
+            {
+                read(is, item.input_attachments);
+                read(is, item.output_attachments);
+                read(is, item.color_resolve_attachments);
+                read(is, item.disable_depth_stencil_attachment);
+                read(is, item.depth_stencil_resolve_attachment);
+                read(is, item.depth_stencil_resolve_mode);
+            }
+        }
+
+        inline void read_processes(std::istringstream& is, std::vector<std::string>& value)
+        {
+            std::size_t size;
+            read(is, size);
+            value.resize(size);
+            for (std::string& item : value)
+            {
+                read(is, item);
+            }
+        }
+
+        /**
+         * @brief Runs jobs across the cores, objects of distinct keys are created concurrently by the cache
+         * @return The number of jobs which succeeded
+         */
+        size_t run_parallel(const std::vector<std::function<void()>>& jobs)
+        {
+            std::atomic<size_t> next_job{ 0 };
+            std::atomic<size_t> created{ 0 };
+
+            auto worker = [&jobs, &next_job, &created]() {
+                for (size_t i = next_job++; i < jobs.size(); i = next_job++)
+                {
+                    // A stale entry must not prevent the rest of the cache from warming up
+                    try
+                    {
+                        jobs[i]();
+                        created++;
+                    }
+                    catch (const std::exception&)
+                    {
+                    }
+                }
+            };
+
+            size_t worker_count = std::min<size_t>(std::max(1U, std::thread::hardware_concurrency()), jobs.size());
+
+            std::vector<std::future<void>> workers;
+            for (size_t i = 1; i < worker_count; ++i)
+            {
+                workers.push_back(std::async(std::launch::async, worker));
+            }
+
+            worker();
+
+            for (auto& w : workers)
+            {
+                w.get();
+            }
+
+            return created;
+        }
+
+        template <class T>
+        T& get_dependency(const std::vector<T*>& objects, size_t index)
+        {
+            if (index >= objects.size() || !objects[index])
+            {
+                throw std::runtime_error{ "Replay dependency was not created" };
+            }
+
+            return *objects[index];
+        }
+    }
+
+    HPPResourceReplay::HPPResourceReplay()
+    {
+        stream_resources[ResourceType::ShaderModule]     = std::bind(&HPPResourceReplay::create_shader_module, this, std::placeholders::_1, std::placeholders::_2);
+        stream_resources[ResourceType::PipelineLayout]   = std::bind(&HPPResourceReplay::create_pipeline_layout, this, std::placeholders::_1, std::placeholders::_2);
+        stream_resources[ResourceType::RenderPass]       = std::bind(&HPPResourceReplay::create_render_pass, this, std::placeholders::_1, std::placeholders::_2);
+        stream_resources[ResourceType::GraphicsPipeline] = std::bind(&HPPResourceReplay::create_graphics_pipeline, this, std::placeholders::_1, std::placeholders::_2);
+    }
+
+    size_t HPPResourceReplay::play(HPPResourceCache& resource_cache, const std::vector<uint8_t>& data)
+    {
+        std::istringstream stream{ std::string{ data.begin(), data.end() } };
+
+        jobs.clear();
+        shader_modules.clear();
+        pipeline_layouts.clear();
+        render_passes.clear();
+
+        while (true)
+        {
+            // Read command id
+            ResourceType resource_type;
+            read(stream, resource_type);
+
+            if (stream.eof())
+            {
+                break;
+            }
+
+            // Find command function for the given command id
+            auto cmd_it = stream_resources.find(resource_type);
+
+            // Check if command replayer supports the given command
+            if (cmd_it != stream_resources.end())
+            {
+                // Run command function
+                cmd_it->second(resource_cache, stream);
+            }
+            else
+            {
+                throw std::runtime_error{ "Replay command not supported" };
+            }
+
+            if (!stream)
+            {
+                throw std::runtime_error{ "Replay stream is truncated" };
+            }
+        }
+
+        // Types are replayed in the order they depend on each other, the objects of one type in parallel
+        size_t created = 0;
+
+        for (auto& type_jobs : jobs)
+        {
+            created += run_parallel(type_jobs.second);
+        }
+
+        jobs.clear();
+        shader_modules.clear();
+        pipeline_layouts.clear();
+        render_passes.clear();
+
+        return created;
+    }
+
+    void HPPResourceReplay::create_shader_module(HPPResourceCache& resource_cache, std::istringstream& stream)
+    {
+        vk::ShaderStageFlagBits       stage{};
+        std::string                   filename;
+        std::string                   glsl_source;
+        std::string                   entry_point;
+        std::string                   preamble;
+        std::vector<std::string>      processes;
+        std::map<std::string, size_t> runtime_array_sizes;
+
+        read(stream, stage, filename, glsl_source, entry_point, preamble);
+
+        read_processes(stream, processes);
+
+        read(stream, runtime_array_sizes);
+
+        size_t index = shader_modules.size();
+        shader_modules.push_back(nullptr);
+
+        jobs[ResourceType::ShaderModule].emplace_back([this, &resource_cache, index, stage, filename = std::move(filename), glsl_source = std::move(glsl_source), entry_point = std::move(entry_point),
+                                                       processes = std::move(processes), runtime_array_sizes = std::move(runtime_array_sizes)]() mutable {
+            // A file that no longer exists throws, which only drops this entry
+            core::HPPShaderSource shader_source{};
+            if (filename.empty())
+            {
+                shader_source.set_source(glsl_source);
+            }
+            else
+            {
+                shader_source = core::HPPShaderSource{ filename };
+            }
+
+            // The directives are added back from the processes rather than the preamble, so the variant equals the recorded one
+            core::HPPShaderVariant shader_variant;
+            for (auto& process : processes)
+            {
+                if (process.starts_with('D'))
+                {
+                    shader_variant.add_define(process.substr(1));
+                }
+                else if (process.starts_with('U'))
+                {
+                    shader_variant.add_undefine(process.substr(1));
+                }
+            }
+
+            shader_variant.set_runtime_array_sizes({ runtime_array_sizes.begin(), runtime_array_sizes.end() });
+
+            shader_modules[index] = &resource_cache.request_shader_module(stage, shader_source, shader_variant, entry_point);
+        });
+    }
+
+    void HPPResourceReplay::create_pipeline_layout(HPPResourceCache& resource_cache, std::istringstream& stream)
+    {
+        std::vector<size_t> shader_indices;
+
+        read(stream, shader_indices);
+
+        size_t index = pipeline_layouts.size();
+        pipeline_layouts.push_back(nullptr);
+
+        jobs[ResourceType::PipelineLayout].emplace_back([this, &resource_cache, index, shader_indices = std::move(shader_indices)]() {
+            std::vector<core::HPPShaderModule*> shader_stages;
+            shader_stages.reserve(shader_indices.size());
+
+            for (size_t shader_index : shader_indices)
+            {
+                shader_stages.push_back(&get_dependency(shader_modules, shader_index));
+            }
+
+            pipeline_layouts[index] = &resource_cache.request_pipeline_layout(shader_stages);
+        });
+    }
+
+    void HPPResourceReplay::create_render_pass(HPPResourceCache& resource_cache, std::istringstream& stream)
+    {
+        std::vector<rendering::HPPAttachment> attachments;
+        std::vector<HPPLoadStoreInfo>         load_store_infos;
+        std::vector<core::HPPSubpassInfo>     subpasses;
+
+        read(stream, attachments, load_store_infos);
+
+        read_subpass_info(stream, subpasses);
+
+        size_t index = render_passes.size();
+        render_passes.push_back(nullptr);
+
+        jobs[ResourceType::RenderPass].emplace_back([this, &resource_cache, index, attachments = std::move(attachments), load_store_infos = std::move(load_store_infos), subpasses = std::move(subpasses)]() {
+            render_passes[index] = &resource_cache.request_render_pass(attachments, load_store_infos, subpasses);
+        });
+    }
+
+    void HPPResourceReplay::create_graphics_pipeline(HPPResourceCache& resource_cache, std::istringstream& stream)
+    {
+        size_t   pipeline_layout_index{};
+        size_t   render_pass_index{};
+        uint32_t subpass_index{};
+
+        read(stream, pipeline_layout_index, render_pass_index, subpass_index);
+
+        rendering::HPPVertexInputState   vertex_input_state;
+        rendering::HPPInputAssemblyState input_assembly_state;
+        rendering::HPPRasterizationState rasterization_state;
+        rendering::HPPViewportState      viewport_state;
+        rendering::HPPMultisampleState   multisample_state;
+        rendering::HPPDepthStencilState  depth_stencil_state;
+
+        read(stream,
+             vertex_input_state.bindings,
+             vertex_input_state.attributes,
+             input_assembly_state,
+             rasterization_state,
+             viewport_state,
+             multisample_state,
+             depth_stencil_state);
+
+        rendering::HPPColorBlendState color_blend_state;
+
+        read(stream,
+             color_blend_state.logic_op,
+             color_blend_state.logic_op_enable,
+             color_blend_state.attachments);
+
+        jobs[ResourceType::GraphicsPipeline].emplace_back([=, this, &resource_cache]() {
+            rendering::HPPPipelineState pipeline_state;
+
+            pipeline_state.set_pipeline_layout(get_dependency(pipeline_layouts, pipeline_layout_index));
+            pipeline_state.set_render_pass(get_dependency(render_passes, render_pass_index));
+            pipeline_state.set_subpass_index(subpass_index);
+            pipeline_state.set_vertex_input_state(vertex_input_state);
+            pipeline_state.set_input_assembly_state(input_assembly_state);
+            pipeline_state.set_rasterization_state(rasterization_state);
+            pipeline_state.set_viewport_state(viewport_state);
+            pipeline_state.set_multisample_state(multisample_state);
+            pipeline_state.set_depth_stencil_state(depth_stencil_state);
+            pipeline_state.set_color_blend_state(color_blend_state);
+
+            resource_cache.request_graphics_pipeline(pipeline_state);
+        });
+    }
+}
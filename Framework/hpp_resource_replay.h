@@ -0,0 +1,52 @@
+#pragma once
+
+#include "hpp_resource_record.h"
+
+namespace vkb
+{
+    class HPPResourceCache;
+
+    /**
+     * @brief Reads Vulkan objects from a memory stream written by HPPResourceRecord and creates them in the resource cache.
+     *        The stream is parsed sequentially, then the objects are created in parallel across worker threads,
+     *        one type after the other in the order of ResourceType so the objects a type depends on already exist.
+     *        Framebuffers are never recorded, as they reference the image views of the running instance.
+     */
+    class HPPResourceReplay
+    {
+    public:
+        HPPResourceReplay();
+
+        /**
+         * @brief Creates all the objects of a recorded stream
+         * @param resource_cache The cache to create the objects in
+         * @param data A stream returned by HPPResourceRecord::get_data
+         * @return The number of objects created, or found already cached
+         */
+        size_t play(HPPResourceCache& resource_cache, const std::vector<uint8_t>& data);
+
+    protected:
+        void create_shader_module(HPPResourceCache& resource_cache, std::istringstream& stream);
+
+        void create_pipeline_layout(HPPResourceCache& resource_cache, std::istringstream& stream);
+
+        void create_render_pass(HPPResourceCache& resource_cache, std::istringstream& stream);
+
+        void create_graphics_pipeline(HPPResourceCache& resource_cache, std::istringstream& stream);
+
+    private:
+        using ResourceFunc = std::function<void(HPPResourceCache&, std::istringstream&)>;
+
+        std::unordered_map<ResourceType, ResourceFunc> stream_resources;
+
+        // Object creations parsed from the stream by type, each type is run in parallel once the previous one is done
+        std::map<ResourceType, std::vector<std::function<void()>>> jobs;
+
+        // Objects created, by recorded index, nullptr if their creation failed
+        std::vector<core::HPPShaderModule*> shader_modules;
+
+        std::vector<core::HPPPipelineLayout*> pipeline_layouts;
+
+        std::vector<const core::HPPRenderPass*> render_passes;
+    };
+}
@@ -0,0 +1,274 @@
+#include "stdafx.h"
+#include "hpp_shader_reloader.h"
+
+namespace vkb
+{
+    namespace
+    {
+        // A missing file gets the oldest time, so it counts as changed once it is written again
+        std::filesystem::file_time_type get_write_time(const std::string& file)
+        {
+            std::error_code error;
+
+            auto write_time = std::filesystem::last_write_time(fs::path::get(fs::path::Type::Shaders) + file, error);
+
+            return error ? std::filesystem::file_time_type::min() : write_time;
+        }
+    }
+
+    HPPShaderReloader::HPPShaderReloader(core::HPPDevice& device, ShaderPreprocessor& preprocessor, std::chrono::milliseconds poll_interval) :
+        device{ device },
+        preprocessor{ preprocessor },
+        thread{ [this, poll_interval]() { run(poll_interval); } }
+    { }
+
+    HPPShaderReloader::~HPPShaderReloader()
+    {
+        {
+            std::lock_guard<std::mutex> guard(mutex);
+
+            stopping = true;
+        }
+
+        wake.notify_all();
+        thread.join();
+    }
+
+    void HPPShaderReloader::track(core::HPPShaderModule& shader_module)
+    {
+        std::lock_guard<std::mutex> guard(mutex);
+
+        if (recipes.contains(&shader_module))
+        {
+            return;
+        }
+
+        Recipe recipe{ shader_module.get_stage(),
+                       shader_module.get_source(),
+                       shader_module.get_entry_point(),
+                       shader_module.get_variant(),
+                       get_files(shader_module) };
+
+        watch(recipe.files, &shader_module);
+
+        recipes.emplace(&shader_module, std::move(recipe));
+    }
+
+    void HPPShaderReloader::untrack(core::HPPShaderModule& shader_module)
+    {
+        std::lock_guard<std::mutex> guard(mutex);
+
+        auto* target = &shader_module;
+
+        auto it = recipes.find(target);
+        if (it == recipes.end())
+        {
+            return;
+        }
+
+        unwatch(it->second.files, target);
+        recipes.erase(it);
+
+        std::erase_if(reloads, [target](const HPPShaderReload& reload) { return reload.target == target; });
+    }
+
+    void HPPShaderReloader::clear()
+    {
+        std::lock_guard<std::mutex> guard(mutex);
+
+        generation++;
+
+        recipes.clear();
+        files.clear();
+        reloads.clear();
+    }
+
+    std::vector<HPPShaderReload> HPPShaderReloader::take_reloads()
+    {
+        std::lock_guard<std::mutex> guard(mutex);
+
+        return std::exchange(reloads, {});
+    }
+
+    HPPShaderReloadStats HPPShaderReloader::get_stats() const
+    {
+        std::lock_guard<std::mutex> guard(mutex);
+
+        return stats;
+    }
+
+    std::vector<std::string> HPPShaderReloader::get_files(const core::HPPShaderModule& shader_module)
+    {
+        std::vector<std::string> result;
+
+        // Sources set from memory have no file of their own, only their includes can change
+        if (!shader_module.get_source().get_filename().empty())
+        {
+            result.push_back(shader_module.get_source().get_filename());
+        }
+
+        result.insert(result.end(), shader_module.get_dependencies().begin(), shader_module.get_dependencies().end());
+
+        return result;
+    }
+
+    void HPPShaderReloader::watch(const std::vector<std::string>& watched_files, core::HPPShaderModule* shader_module)
+    {
+        for (auto& file : watched_files)
+        {
+            auto it = files.find(file);
+            if (it == files.end())
+            {
+                it = files.emplace(file, WatchedFile{ get_write_time(file) }).first;
+            }
+
+            it->second.dependents.insert(shader_module);
+        }
+    }
+
+    void HPPShaderReloader::unwatch(const std::vector<std::string>& watched_files, core::HPPShaderModule* shader_module)
+    {
+        for (auto& file : watched_files)
+        {
+            auto it = files.find(file);
+            if (it == files.end())
+            {
+                continue;
+            }
+
+            it->second.dependents.erase(shader_module);
+
+            if (it->second.dependents.empty())
+            {
+                files.erase(it);
+            }
+        }
+    }
+
+    void HPPShaderReloader::run(std::chrono::milliseconds poll_interval)
+    {
+        std::unique_lock<std::mutex> lock(mutex);
+
+        while (!wake.wait_for(lock, poll_interval, [this]() { return stopping; }))
+        {
+            lock.unlock();
+
+            poll();
+
+            lock.lock();
+        }
+    }
+
+    void HPPShaderReloader::poll()
+    {
+        std::vector<std::string> watched_files;
+        uint64_t                 poll_generation;
+        {
+            std::lock_guard<std::mutex> guard(mutex);
+
+            watched_files.reserve(files.size());
+            for (auto& file : files)
+            {
+                watched_files.push_back(file.first);
+            }
+
+            poll_generation = generation;
+        }
+
+        // Query the file system outside of the lock, so tracking new modules never waits on it
+        std::vector<std::pair<std::string, std::filesystem::file_time_type>> write_times;
+        write_times.reserve(watched_files.size());
+
+        for (auto& file : watched_files)
+        {
+            write_times.emplace_back(file, get_write_time(file));
+        }
+
+        // Collect the modules depending on the changed files, each one is rebuilt once however many of its files changed
+        std::vector<std::pair<core::HPPShaderModule*, Recipe>> affected;
+        std::vector<std::string>                               changed_files;
+        {
+            std::lock_guard<std::mutex> guard(mutex);
+
+            if (poll_generation != generation)
+            {
+                return;
+            }
+
+            std::unordered_set<core::HPPShaderModule*> dependents;
+
+            for (auto& [file, write_time] : write_times)
+            {
+                auto it = files.find(file);
+                if (it == files.end() || it->second.write_time == write_time)
+                {
+                    continue;
+                }
+
+                it->second.write_time = write_time;
+                dependents.insert(it->second.dependents.begin(), it->second.dependents.end());
+                changed_files.push_back(file);
+            }
+
+            for (auto* shader_module : dependents)
+            {
+                affected.emplace_back(shader_module, recipes.at(shader_module));
+            }
+        }
+
+        // The edited includes are read again by the rebuilds, the unchanged ones are still shared
+        for (auto& file : changed_files)
+        {
+            preprocessor.invalidate(file);
+        }
+
+        for (auto& [target, recipe] : affected)
+        {
+            std::unique_ptr<core::HPPShaderModule> shader_module;
+
+            try
+            {
+                // Read the source file again
+                core::HPPShaderSource source = recipe.source.get_filename().empty() ? recipe.source : core::HPPShaderSource{ recipe.source.get_filename() };
+
+                shader_module = std::make_unique<core::HPPShaderModule>(device, recipe.stage, source, recipe.entry_point, recipe.variant, &preprocessor);
+            }
+            catch (const std::exception& e)
+            {
+                // Most likely saved halfway through an edit, the next save triggers another attempt
+                std::lock_guard<std::mutex> guard(mutex);
+
+                stats.failed++;
+                stats.last_error = (recipe.files.empty() ? std::string{ "<memory>" } : recipe.files.front()) + ": " + e.what();
+                continue;
+            }
+
+            std::lock_guard<std::mutex> guard(mutex);
+
+            if (poll_generation != generation)
+            {
+                return;
+            }
+
+            // The module may have been untracked while it was rebuilt
+            auto it = recipes.find(target);
+            if (it == recipes.end())
+            {
+                continue;
+            }
+
+            // The edit may have changed the includes of the module
+            auto& current = it->second;
+
+            unwatch(current.files, target);
+
+            current.source = shader_module->get_source();
+            current.files  = get_files(*shader_module);
+
+            watch(current.files, target);
+
+            reloads.push_back({ target, std::move(shader_module) });
+            stats.reloaded++;
+        }
+    }
+}
\ No newline at end of file
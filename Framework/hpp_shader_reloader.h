@@ -0,0 +1,131 @@
+#pragma once
+
+#include <chrono>
+#include <condition_variable>
+#include <filesystem>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+#include "core/hpp_shader_module.h"
+#include "shader_preprocessor.h"
+
+namespace vkb
+{
+    /**
+     * @brief A shader module rebuilt from its edited files, waiting to replace the cached one
+     */
+    struct HPPShaderReload
+    {
+        core::HPPShaderModule*                 target;
+        std::unique_ptr<core::HPPShaderModule> module;
+    };
+
+    /**
+     * @brief Counters of the rebuilds of edited shader modules
+     */
+    struct HPPShaderReloadStats
+    {
+        uint64_t reloaded = 0;        // Modules rebuilt, taken or not
+        uint64_t failed   = 0;        // Rebuilds failing to compile, the module keeps its previous code
+
+        std::string last_error;        // Message of the latest failed rebuild, prefixed with the source file
+    };
+
+    /**
+     * @brief Watches the files shader modules are built from, and rebuilds the modules when they change.
+     *
+     * Each tracked module is registered with its source file and the files it includes, so an edit to a
+     * shared header rebuilds the modules including it, and only those. A background thread polls the
+     * modification times of the watched files and compiles the affected modules, their owner swaps them in
+     * through take_reloads() at a frame boundary. A module failing to compile keeps its previous code.
+     * The changed files are invalidated in the preprocessor the modules share, so the rebuilds read them again.
+     */
+    class HPPShaderReloader
+    {
+    public:
+        /**
+         * @brief Starts the background thread
+         * @param preprocessor The preprocessor shared by the modules, which must outlive the reloader
+         * @param poll_interval How often the modification times of the watched files are checked
+         */
+        HPPShaderReloader(core::HPPDevice& device, ShaderPreprocessor& preprocessor, std::chrono::milliseconds poll_interval);
+
+        ~HPPShaderReloader();
+
+        HPPShaderReloader(const HPPShaderReloader&)            = delete;
+        HPPShaderReloader(HPPShaderReloader&&)                 = delete;
+        HPPShaderReloader& operator=(const HPPShaderReloader&) = delete;
+        HPPShaderReloader& operator=(HPPShaderReloader&&)      = delete;
+
+        /**
+         * @brief Watches the files of a module, which must stay alive until clear() is called. Tracking it again does nothing.
+         */
+        void track(core::HPPShaderModule& shader_module);
+
+        /**
+         * @brief Stops watching the files of a module, and drops its rebuilds not taken yet
+         */
+        void untrack(core::HPPShaderModule& shader_module);
+
+        /**
+         * @brief Stops watching all the modules, and drops the rebuilt ones not taken yet
+         */
+        void clear();
+
+        /**
+         * @brief Returns the modules rebuilt since the last call, in the order they were rebuilt
+         */
+        std::vector<HPPShaderReload> take_reloads();
+
+        HPPShaderReloadStats get_stats() const;
+
+    private:
+        // What a module is rebuilt from
+        struct Recipe
+        {
+            vk::ShaderStageFlagBits  stage;
+            core::HPPShaderSource    source;
+            std::string              entry_point;
+            core::HPPShaderVariant   variant;
+            std::vector<std::string> files;        // Relative to the shader directory
+        };
+
+        struct WatchedFile
+        {
+            std::filesystem::file_time_type           write_time;
+            std::unordered_set<core::HPPShaderModule*> dependents;
+        };
+
+        static std::vector<std::string> get_files(const core::HPPShaderModule& shader_module);
+
+        // The mutex must be held
+        void watch(const std::vector<std::string>& files, core::HPPShaderModule* shader_module);
+        void unwatch(const std::vector<std::string>& files, core::HPPShaderModule* shader_module);
+
+        void run(std::chrono::milliseconds poll_interval);
+
+        void poll();
+
+        core::HPPDevice&    device;
+        ShaderPreprocessor& preprocessor;
+
+        mutable std::mutex      mutex;
+        std::condition_variable wake;
+        bool                    stopping = false;
+
+        // Incremented by clear(), so rebuilds started before it are dropped
+        uint64_t generation = 0;
+
+        std::unordered_map<core::HPPShaderModule*, Recipe> recipes;
+        std::unordered_map<std::string, WatchedFile>        files;
+        std::vector<HPPShaderReload>                        reloads;
+        HPPShaderReloadStats                                stats;
+
+        std::thread thread;
+    };
+}
\ No newline at end of file
@@ -7,6 +7,8 @@ namespace vkb
     Application::Application(const Window::Properties& properties) :
         name{"Sample Name"}
     {
+        vkb::filesystem::init();
+
         window = std::make_unique<GlfwWindow>(properties);
     }
 
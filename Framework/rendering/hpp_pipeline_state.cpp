@@ -1,5 +1,7 @@
 #include "stdafx.h"
 
+#include <bit>
+
 bool operator==(const vk::VertexInputBindingDescription& lhs, const vk::VertexInputBindingDescription& rhs)
 {
     return std::tie(lhs.binding, lhs.inputRate, lhs.stride) == std::tie(rhs.binding, rhs.inputRate, rhs.stride);
@@ -16,49 +18,15 @@ bool operator==(const vkb::rendering::HPPColorBlendAttachmentState& lhs, const v
            std::tie(rhs.alpha_blend_op, rhs.blend_enable, rhs.color_blend_op, rhs.color_write_mask, rhs.dst_alpha_blend_factor, rhs.dst_color_blend_factor, rhs.src_alpha_blend_factor, rhs.src_color_blend_factor);
 }
 
-bool operator!=(const vkb::rendering::HPPStencilOpState& lhs, const vkb::rendering::HPPStencilOpState& rhs)
-{
-    return std::tie(lhs.compare_op, lhs.depth_fail_op, lhs.fail_op, lhs.pass_op) != std::tie(rhs.compare_op, rhs.depth_fail_op, rhs.fail_op, rhs.pass_op);
-}
-
 bool operator!=(const vkb::rendering::HPPVertexInputState& lhs, const vkb::rendering::HPPVertexInputState& rhs)
 {
     return lhs.bindings != rhs.bindings || lhs.attributes != rhs.attributes;
 }
 
-bool operator!=(const vkb::rendering::HPPInputAssemblyState& lhs, const vkb::rendering::HPPInputAssemblyState& rhs)
-{
-    return std::tie(lhs.primitive_restart_enable, lhs.topology) != std::tie(rhs.primitive_restart_enable, rhs.topology);
-}
-
-bool operator!=(const vkb::rendering::HPPViewportState& lhs, const vkb::rendering::HPPViewportState& rhs)
-{
-    return lhs.viewport_count != rhs.viewport_count || lhs.scissor_count != rhs.scissor_count;
-}
-
-bool operator!=(const vkb::rendering::HPPRasterizationState& lhs, const vkb::rendering::HPPRasterizationState& rhs)
-{
-    return std::tie(lhs.cull_mode, lhs.depth_bias_enable, lhs.depth_clamp_enable, lhs.front_face, lhs.polygon_mode, lhs.rasterizer_discard_enable) !=
-           std::tie(rhs.cull_mode, rhs.depth_bias_enable, rhs.depth_clamp_enable, rhs.front_face, rhs.polygon_mode, rhs.rasterizer_discard_enable);
-}
-
-bool operator!=(const vkb::rendering::HPPMultisampleState& lhs, const vkb::rendering::HPPMultisampleState& rhs)
-{
-    return std::tie(lhs.alpha_to_coverage_enable, lhs.alpha_to_one_enable, lhs.min_sample_shading, lhs.rasterization_samples, lhs.sample_mask, lhs.sample_shading_enable) !=
-           std::tie(rhs.alpha_to_coverage_enable, rhs.alpha_to_one_enable, rhs.min_sample_shading, rhs.rasterization_samples, rhs.sample_mask, rhs.sample_shading_enable);
-}
-
-bool operator!=(const vkb::rendering::HPPDepthStencilState& lhs, const vkb::rendering::HPPDepthStencilState& rhs)
-{
-    return std::tie(lhs.depth_bounds_test_enable, lhs.depth_compare_op, lhs.depth_test_enable, lhs.depth_write_enable, lhs.stencil_test_enable) !=
-        std::tie(rhs.depth_bounds_test_enable, rhs.depth_compare_op, rhs.depth_test_enable, rhs.depth_write_enable, rhs.stencil_test_enable) ||
-        lhs.back != rhs.back || lhs.front != rhs.front;
-}
-
+// Only the attachments, the logic op is compared through the packed state
 bool operator!=(const vkb::rendering::HPPColorBlendState& lhs, const vkb::rendering::HPPColorBlendState& rhs)
 {
-    return std::tie(lhs.logic_op, lhs.logic_op_enable) != std::tie(rhs.logic_op, rhs.logic_op_enable) ||
-           lhs.attachments.size() != rhs.attachments.size() ||
+    return lhs.attachments.size() != rhs.attachments.size() ||
            !std::equal(lhs.attachments.begin(), lhs.attachments.end(), rhs.attachments.begin(),
                       [](const vkb::rendering::HPPColorBlendAttachmentState& lhs, const vkb::rendering::HPPColorBlendAttachmentState& rhs) {
                           return lhs == rhs;
@@ -67,53 +35,173 @@ bool operator!=(const vkb::rendering::HPPColorBlendState& lhs, const vkb::render
 
 namespace vkb::rendering
 {
-    void HPPPipelineState::reset()
-    {
-        clear_dirty();
-
-        pipeline_layout      = nullptr;
-        render_pass          = nullptr;
-        vertex_input_state   = {};
-        input_assembly_state = {};
-        viewport_state       = {};
-        rasterization_state  = {};
-        multisample_state    = {};
-        depth_stencil_state  = {};
-        color_blend_state    = {};
-        subpass_index        = { 0U };
-    }
+    static_assert(std::has_unique_object_representations_v<HPPPackedPipelineState>, "The packed state is compared and hashed as bytes");
 
-    void HPPPipelineState::set_pipeline_layout(vkb::core::HPPPipelineLayout& new_pipeline_layout)
+    namespace
     {
-        if (pipeline_layout)
+        enum PackedFlagBits : uint32_t
+        {
+            PrimitiveRestartBit      = 1 << 0,
+            DepthClampBit            = 1 << 1,
+            RasterizerDiscardBit     = 1 << 2,
+            DepthBiasBit             = 1 << 3,
+            SampleShadingBit         = 1 << 4,
+            AlphaToCoverageBit       = 1 << 5,
+            AlphaToOneBit            = 1 << 6,
+            DepthTestBit             = 1 << 7,
+            DepthWriteBit            = 1 << 8,
+            DepthBoundsTestBit       = 1 << 9,
+            StencilTestBit           = 1 << 10,
+            LogicOpBit               = 1 << 11
+        };
+
+        inline void set_flag(uint32_t& flags, uint32_t bit, vk::Bool32 value)
+        {
+            flags = value ? (flags | bit) : (flags & ~bit);
+        }
+
+        // Stencil and compare ops all fit in three bits
+        inline uint32_t pack_stencil_op(const HPPStencilOpState& state)
+        {
+            return static_cast<uint32_t>(state.fail_op) | (static_cast<uint32_t>(state.pass_op) << 4) |
+                   (static_cast<uint32_t>(state.depth_fail_op) << 8) | (static_cast<uint32_t>(state.compare_op) << 12);
+        }
+
+        inline void pack(const HPPInputAssemblyState& state, HPPPackedPipelineState& packed)
+        {
+            packed.topology = static_cast<uint32_t>(state.topology);
+            set_flag(packed.flags, PrimitiveRestartBit, state.primitive_restart_enable);
+        }
+
+        inline void pack(const HPPViewportState& state, HPPPackedPipelineState& packed)
+        {
+            packed.viewport_count = state.viewport_count;
+            packed.scissor_count  = state.scissor_count;
+        }
+
+        inline void pack(const HPPRasterizationState& state, HPPPackedPipelineState& packed)
+        {
+            packed.polygon_mode = static_cast<uint32_t>(state.polygon_mode);
+            packed.cull_mode    = static_cast<uint32_t>(state.cull_mode);
+            packed.front_face   = static_cast<uint32_t>(state.front_face);
+            set_flag(packed.flags, DepthClampBit, state.depth_clamp_enable);
+            set_flag(packed.flags, RasterizerDiscardBit, state.rasterizer_discard_enable);
+            set_flag(packed.flags, DepthBiasBit, state.depth_bias_enable);
+        }
+
+        inline void pack(const HPPMultisampleState& state, HPPPackedPipelineState& packed)
+        {
+            packed.rasterization_samples = static_cast<uint32_t>(state.rasterization_samples);
+            packed.min_sample_shading    = std::bit_cast<uint32_t>(state.min_sample_shading);
+            packed.sample_mask           = state.sample_mask;
+            set_flag(packed.flags, SampleShadingBit, state.sample_shading_enable);
+            set_flag(packed.flags, AlphaToCoverageBit, state.alpha_to_coverage_enable);
+            set_flag(packed.flags, AlphaToOneBit, state.alpha_to_one_enable);
+        }
+
+        inline void pack(const HPPDepthStencilState& state, HPPPackedPipelineState& packed)
+        {
+            packed.depth_compare_op = static_cast<uint32_t>(state.depth_compare_op);
+            packed.stencil_ops      = pack_stencil_op(state.front) | (pack_stencil_op(state.back) << 16);
+            set_flag(packed.flags, DepthTestBit, state.depth_test_enable);
+            set_flag(packed.flags, DepthWriteBit, state.depth_write_enable);
+            set_flag(packed.flags, DepthBoundsTestBit, state.depth_bounds_test_enable);
+            set_flag(packed.flags, StencilTestBit, state.stencil_test_enable);
+        }
+
+        inline void pack(const HPPColorBlendState& state, HPPPackedPipelineState& packed)
         {
-            if (pipeline_layout->get_handle() != new_pipeline_layout.get_handle())
+            packed.logic_op = static_cast<uint32_t>(state.logic_op);
+            set_flag(packed.flags, LogicOpBit, state.logic_op_enable);
+        }
+
+        // Updates the packed fields of a sub-state, returns whether any of them changed
+        template <class Update>
+        inline bool repack(HPPPackedPipelineState& packed_state, Update&& update)
+        {
+            auto packed = packed_state;
+            update(packed);
+
+            if (packed == packed_state)
             {
-                pipeline_layout = &new_pipeline_layout;
-                dirty = true;
+                return false;
             }
+
+            packed_state = packed;
+            return true;
         }
-        else
+
+        template <class T>
+        inline void write_vector(common::HPPHasher& hasher, const std::vector<T>& values)
         {
-            pipeline_layout = &new_pipeline_layout;
-            dirty = true;
+            static_assert(std::has_unique_object_representations_v<T>, "Padding would make equal states hash differently");
+
+            hasher.write(values.size());
+            hasher.write(values.data(), values.size() * sizeof(T));
         }
     }
 
-    void HPPPipelineState::set_render_pass(const vkb::core::HPPRenderPass& new_render_pass)
+    HPPPipelineState::HPPPipelineState()
+    {
+        // Pack the defaults, a sub-state never set must not compare equal to one set to all zeros
+        pack(input_assembly_state, packed_state);
+        pack(viewport_state, packed_state);
+        pack(rasterization_state, packed_state);
+        pack(multisample_state, packed_state);
+        pack(depth_stencil_state, packed_state);
+        pack(color_blend_state, packed_state);
+    }
+
+    const common::HPPHash128& HPPPipelineState::get_hash() const
     {
-        if (render_pass)
+        if (!hash_valid)
         {
-            if (render_pass->get_handle() != new_render_pass.get_handle())
-            {
-                render_pass = &new_render_pass;
-                dirty = true;
-            }
+            common::HPPHasher hasher;
+
+            hasher.write(packed_state);
+            write_vector(hasher, vertex_input_state.bindings);
+            write_vector(hasher, vertex_input_state.attributes);
+            write_vector(hasher, color_blend_state.attachments);
+
+            hash       = hasher.digest();
+            hash_valid = true;
+        }
+
+        return hash;
+    }
+
+    void HPPPipelineState::set_dirty(uint32_t bits)
+    {
+        dirty_bits |= bits;
+        hash_valid = false;
+    }
+
+    void HPPPipelineState::reset()
+    {
+        *this = HPPPipelineState{};
+    }
+
+    void HPPPipelineState::set_pipeline_layout(vkb::core::HPPPipelineLayout& new_pipeline_layout)
+    {
+        auto handle = reinterpret_cast<uint64_t>(static_cast<VkPipelineLayout>(new_pipeline_layout.get_handle()));
+
+        pipeline_layout = &new_pipeline_layout;
+
+        if (repack(packed_state, [handle](HPPPackedPipelineState& packed) { packed.pipeline_layout = handle; }))
+        {
+            set_dirty(PipelineLayoutBit);
         }
-        else
+    }
+
+    void HPPPipelineState::set_render_pass(const vkb::core::HPPRenderPass& new_render_pass)
+    {
+        auto handle = reinterpret_cast<uint64_t>(static_cast<VkRenderPass>(new_render_pass.get_handle()));
+
+        render_pass = &new_render_pass;
+
+        if (repack(packed_state, [handle](HPPPackedPipelineState& packed) { packed.render_pass = handle; }))
         {
-            render_pass = &new_render_pass;
-            dirty = true;
+            set_dirty(RenderPassBit);
         }
     }
 
@@ -122,70 +210,81 @@ namespace vkb::rendering
         if (vertex_input_state != new_vertex_input_state)
         {
             vertex_input_state = new_vertex_input_state;
-            dirty = true;
+            set_dirty(VertexInputBit);
         }
     }
 
     void HPPPipelineState::set_input_assembly_state(const HPPInputAssemblyState& new_input_assembly_state)
     {
-        if (input_assembly_state != new_input_assembly_state)
+        input_assembly_state = new_input_assembly_state;
+
+        if (repack(packed_state, [&](HPPPackedPipelineState& packed) { pack(new_input_assembly_state, packed); }))
         {
-            input_assembly_state = new_input_assembly_state;
-            dirty = true;
+            set_dirty(InputAssemblyBit);
         }
     }
 
     void HPPPipelineState::set_viewport_state(const HPPViewportState& new_viewport_state)
     {
-        if (viewport_state != new_viewport_state)
+        viewport_state = new_viewport_state;
+
+        if (repack(packed_state, [&](HPPPackedPipelineState& packed) { pack(new_viewport_state, packed); }))
         {
-            viewport_state = new_viewport_state;
-            dirty = true;
+            set_dirty(ViewportBit);
         }
     }
 
     void HPPPipelineState::set_rasterization_state(const HPPRasterizationState& new_rasterization_state)
     {
-        if (rasterization_state != new_rasterization_state)
+        rasterization_state = new_rasterization_state;
+
+        if (repack(packed_state, [&](HPPPackedPipelineState& packed) { pack(new_rasterization_state, packed); }))
         {
-            rasterization_state = new_rasterization_state;
-            dirty = true;
+            set_dirty(RasterizationBit);
         }
     }
 
     void HPPPipelineState::set_multisample_state(const HPPMultisampleState& new_multisample_state)
     {
-        if (multisample_state != new_multisample_state)
+        multisample_state = new_multisample_state;
+
+        if (repack(packed_state, [&](HPPPackedPipelineState& packed) { pack(new_multisample_state, packed); }))
         {
-            multisample_state = new_multisample_state;
-            dirty = true;
+            set_dirty(MultisampleBit);
         }
     }
 
     void HPPPipelineState::set_depth_stencil_state(const HPPDepthStencilState& new_depth_stencil_state)
     {
-        if (depth_stencil_state != new_depth_stencil_state)
+        depth_stencil_state = new_depth_stencil_state;
+
+        if (repack(packed_state, [&](HPPPackedPipelineState& packed) { pack(new_depth_stencil_state, packed); }))
         {
-            depth_stencil_state = new_depth_stencil_state;
-            dirty = true;
+            set_dirty(DepthStencilBit);
         }
     }
 
     void HPPPipelineState::set_color_blend_state(const HPPColorBlendState& new_color_blend_state)
     {
-        if (color_blend_state != new_color_blend_state)
+        bool attachments_changed = color_blend_state != new_color_blend_state;
+
+        color_blend_state = new_color_blend_state;
+
+        bool logic_op_changed = repack(packed_state, [&](HPPPackedPipelineState& packed) { pack(new_color_blend_state, packed); });
+
+        if (attachments_changed || logic_op_changed)
         {
-            color_blend_state = new_color_blend_state;
-            dirty = true;
+            set_dirty(ColorBlendBit);
         }
     }
 
     void HPPPipelineState::set_subpass_index(uint32_t new_subpass_index)
     {
-        if (subpass_index != new_subpass_index)
+        subpass_index = new_subpass_index;
+
+        if (repack(packed_state, [new_subpass_index](HPPPackedPipelineState& packed) { packed.subpass_index = new_subpass_index; }))
         {
-            subpass_index = new_subpass_index;
-            dirty = true;
+            set_dirty(SubpassIndexBit);
         }
     }
 }
\ No newline at end of file
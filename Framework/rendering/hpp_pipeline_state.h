@@ -1,5 +1,7 @@
 #pragma once
 
+#include "common/hpp_hasher.h"
+
 namespace vkb::core
 {
     class HPPPipelineLayout;
@@ -84,9 +86,54 @@ namespace vkb::rendering
         std::vector<HPPColorBlendAttachmentState> attachments;
     };
 
+    /**
+     * @brief The fixed-size part of a pipeline state packed into plain words, compared and hashed as a single block of bytes.
+     *        Every field is 32 or 64 bits wide, so the struct has no padding.
+     */
+    struct HPPPackedPipelineState
+    {
+        uint64_t pipeline_layout = 0;        // Handles of the cached layout and render pass
+        uint64_t render_pass     = 0;
+        uint32_t subpass_index   = 0;
+        uint32_t flags           = 0;        // The boolean states, one bit each
+        uint32_t topology        = 0;
+        uint32_t viewport_count  = 0;
+        uint32_t scissor_count   = 0;
+        uint32_t polygon_mode    = 0;
+        uint32_t cull_mode       = 0;
+        uint32_t front_face      = 0;
+        uint32_t rasterization_samples = 0;
+        uint32_t min_sample_shading    = 0;        // The bits of the float
+        uint32_t sample_mask           = 0;
+        uint32_t depth_compare_op      = 0;
+        uint32_t stencil_ops           = 0;        // The four operations of both faces, four bits each
+        uint32_t logic_op              = 0;
+
+        bool operator==(const HPPPackedPipelineState& other) const = default;
+    };
+
     class HPPPipelineState
     {
     public:
+        /**
+         * @brief The sub-states changed since the last call to clear_dirty(), one bit each
+         */
+        enum DirtyBits : uint32_t
+        {
+            PipelineLayoutBit = 1 << 0,
+            RenderPassBit     = 1 << 1,
+            SubpassIndexBit   = 1 << 2,
+            VertexInputBit    = 1 << 3,
+            InputAssemblyBit  = 1 << 4,
+            ViewportBit       = 1 << 5,
+            RasterizationBit  = 1 << 6,
+            MultisampleBit    = 1 << 7,
+            DepthStencilBit   = 1 << 8,
+            ColorBlendBit     = 1 << 9
+        };
+
+        HPPPipelineState();
+
         const vkb::core::HPPPipelineLayout& get_pipeline_layout() const      { return *pipeline_layout; }
         const vkb::core::HPPRenderPass*     get_render_pass() const          { return render_pass; }
         const HPPVertexInputState&          get_vertex_input_state() const   { return vertex_input_state; }
@@ -97,8 +144,16 @@ namespace vkb::rendering
         const HPPDepthStencilState&         get_depth_stencil_state() const  { return depth_stencil_state; }
         const HPPColorBlendState&           get_color_blend_state() const    { return color_blend_state; }
         uint32_t                            get_subpass_index() const        { return subpass_index; }
-        bool                                is_dirty() const                 { return dirty; /* TODO */ }
-        void                                clear_dirty()                    { dirty = false; /* TODO */ }
+        const HPPPackedPipelineState&       get_packed_state() const         { return packed_state; }
+        uint32_t                            get_dirty_bits() const           { return dirty_bits; }
+        bool                                is_dirty() const                 { return dirty_bits != 0; }
+        void                                clear_dirty()                    { dirty_bits = 0; }
+
+        /**
+         * @brief Returns the hash of the whole state, only computed again after a sub-state changed.
+         *        Not thread safe, states shared between threads must be copied.
+         */
+        const common::HPPHash128& get_hash() const;
 
         void reset();
         void set_pipeline_layout(vkb::core::HPPPipelineLayout& pipeline_layout);
@@ -113,7 +168,10 @@ namespace vkb::rendering
         void set_subpass_index(uint32_t subpass_index);
 
     private:
-        bool dirty{ false };
+        // Marks sub-states as changed, which also invalidates the hash
+        void set_dirty(uint32_t bits);
+
+        uint32_t dirty_bits{ 0 };
 
         vkb::core::HPPPipelineLayout* pipeline_layout{ nullptr };
 
@@ -134,5 +192,11 @@ namespace vkb::rendering
         HPPColorBlendState color_blend_state{};
 
         uint32_t subpass_index{ 0 };
+
+        // The fixed-size sub-states above, compared by their packed form when set
+        HPPPackedPipelineState packed_state{};
+
+        mutable common::HPPHash128 hash{};
+        mutable bool               hash_valid{ false };
     };
 }
\ No newline at end of file
@@ -62,6 +62,8 @@ namespace vkb::rendering
             frames.emplace_back(std::make_unique<HPPRenderFrame>(device, std::move(render_target), thread_count));
         }
 
+        submitted_frames.resize(frames.size(), 0);
+
         this->create_render_target_func = create_render_target_func;
         this->thread_count              = thread_count;
         this->prepared                  = true;
@@ -122,6 +124,7 @@ namespace vkb::rendering
 
             if (frame_it != frames.end())
             {
+                device.get_resource_cache().release_framebuffers((*frame_it)->get_render_target());
                 (*frame_it)->update_render_target(std::move(render_target));
             }
             else
@@ -133,7 +136,7 @@ namespace vkb::rendering
             ++frame_it;
         }
 
-        device.get_resource_cache().clear_framebuffers();
+        submitted_frames.resize(frames.size(), 0);
     }
 
     void HPPRenderContext::begin_frame()
@@ -193,6 +196,8 @@ namespace vkb::rendering
     void HPPRenderContext::wait_frame()
     {
         get_active_frame().reset();
+
+        submitted_frames[active_frame_index] = 0;
     }
 
     void HPPRenderContext::end_frame(vk::Semaphore semaphore)
@@ -234,6 +239,22 @@ namespace vkb::rendering
         }
 
         frame_active = false;
+
+        auto& resource_cache = device.get_resource_cache();
+
+        submitted_frames[active_frame_index] = resource_cache.get_frame();
+
+        // Everything before the oldest frame still pending on the GPU has completed
+        uint64_t completed_frame = resource_cache.get_frame();
+        for (uint64_t submitted_frame : submitted_frames)
+        {
+            if (submitted_frame != 0)
+            {
+                completed_frame = std::min(completed_frame, submitted_frame - 1);
+            }
+        }
+
+        resource_cache.update(completed_frame);
     }
 
     void HPPRenderContext::submit(vkb::core::HPPCommandBuffer& command_buffer)
@@ -163,6 +163,9 @@ namespace vkb::rendering
         // Whether a frame is active or not
         bool frame_active{ false };
 
+        // Resource cache frame last submitted by each frame, 0 once its fences have been waited on
+        std::vector<uint64_t> submitted_frames;
+
         HPPRenderTarget::CreateFunc create_render_target_func = HPPRenderTarget::DEFAULT_CREATE_FUNC;
 
         vk::SurfaceTransformFlagBitsKHR pre_transform{ vk::SurfaceTransformFlagBitsKHR::eIdentity };
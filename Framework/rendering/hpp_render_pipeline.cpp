@@ -33,6 +33,32 @@ namespace vkb::rendering
     {
         subpass->prepare();
         subpasses.emplace_back(std::move(subpass));
+
+        render_pass_desc_dirty = true;
+    }
+
+    const vkb::core::HPPRenderPassDesc& HPPRenderPipeline::get_render_pass_desc()
+    {
+        if (render_pass_desc_dirty)
+        {
+            std::vector<vkb::core::HPPSubpassInfo> subpass_infos;
+            subpass_infos.reserve(subpasses.size());
+
+            for (auto& subpass : subpasses)
+            {
+                subpass_infos.push_back({ subpass->get_input_attachments(),
+                                          subpass->get_output_attachments(),
+                                          subpass->get_color_resolve_attachments(),
+                                          subpass->get_disable_depth_stencil_attachment(),
+                                          subpass->get_depth_stencil_resolve_attachment(),
+                                          subpass->get_depth_stencil_resolve_mode() });
+            }
+
+            render_pass_desc       = vkb::core::HPPRenderPassDesc{ load_store, subpass_infos };
+            render_pass_desc_dirty = false;
+        }
+
+        return render_pass_desc;
     }
 
     void HPPRenderPipeline::draw(vkb::core::HPPCommandBuffer& command_buffer, HPPRenderTarget& render_target, vk::SubpassContents contents)
@@ -56,7 +82,7 @@ namespace vkb::rendering
 
             if (i == 0)
             {
-                command_buffer.begin_render_pass(render_target, load_store, clear_value, subpasses, contents);
+                command_buffer.begin_render_pass(render_target, get_render_pass_desc(), clear_value, contents);
             }
             else
             {
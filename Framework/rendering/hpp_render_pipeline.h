@@ -40,7 +40,7 @@ namespace vkb::rendering
         /**
          * @param load_store Load store info to set
          */
-        void set_load_store(const std::vector<HPPLoadStoreInfo>& ls) { load_store = ls; }
+        void set_load_store(const std::vector<HPPLoadStoreInfo>& ls) { load_store = ls; render_pass_desc_dirty = true; }
 
         /**
          * @return Clear values
@@ -71,6 +71,11 @@ namespace vkb::rendering
          */
         std::unique_ptr<HPPSubpass>& get_active_subpass() { return subpasses[active_subpass_index]; }
 
+        /**
+         * @return The description of the render pass of this pipeline, rebuilt only after the subpasses or load/store ops changed
+         */
+        const vkb::core::HPPRenderPassDesc& get_render_pass_desc();
+
     private:
         std::vector<std::unique_ptr<HPPSubpass>> subpasses;
 
@@ -81,5 +86,9 @@ namespace vkb::rendering
         std::vector<vk::ClearValue> clear_value = std::vector<vk::ClearValue>(2);
 
         size_t active_subpass_index{ 0 };
+
+        vkb::core::HPPRenderPassDesc render_pass_desc;
+
+        bool render_pass_desc_dirty{ true };
     };
 }
\ No newline at end of file
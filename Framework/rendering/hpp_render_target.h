@@ -40,6 +40,7 @@ namespace vkb::rendering
         const vk::Extent2D&                    get_extent() const      { return extent; }
         const std::vector<core::HPPImageView>& get_views() const       { return views; }
         const std::vector<HPPAttachment>&      get_attachments() const { return attachments; }
+        uint64_t                               get_generation() const  { return generation; }
 
         /**
          * @brief Sets the current input attachments overwriting the current ones
@@ -67,5 +68,6 @@ namespace vkb::rendering
         std::vector<HPPAttachment>      attachments;
         std::vector<uint32_t>           input_attachments = {};         // By default there are no input attachments
         std::vector<uint32_t>           output_attachments = { 0 };     // By default the output attachments is attachment 0
+        uint64_t                        generation = core::next_generation_id();    // Views are fixed at creation, so it identifies them all
     };
 }
\ No newline at end of file
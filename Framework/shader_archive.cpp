@@ -0,0 +1,356 @@
+#include "stdafx.h"
+#include "shader_archive.h"
+#include "spirv_reflection.h"
+
+#if defined(_WIN32)
+#   ifndef NOMINMAX
+#       define NOMINMAX
+#   endif
+#   ifndef WIN32_LEAN_AND_MEAN
+#       define WIN32_LEAN_AND_MEAN
+#   endif
+#   include <windows.h>
+#else
+#   include <fcntl.h>
+#   include <sys/mman.h>
+#   include <sys/stat.h>
+#   include <unistd.h>
+#endif
+
+namespace vkb
+{
+    namespace
+    {
+        // Bump when the file layout, or the way keys are computed, changes
+        constexpr uint32_t SHADER_ARCHIVE_MAGIC   = 0x41534B56;        // "VKSA"
+        constexpr uint32_t SHADER_ARCHIVE_VERSION = 1;
+
+        struct ShaderArchiveHeader
+        {
+            uint32_t magic       = SHADER_ARCHIVE_MAGIC;
+            uint32_t version     = SHADER_ARCHIVE_VERSION;
+            uint32_t entry_count = 0;
+            uint32_t reserved    = 0;
+            uint64_t index_offset = 0;
+        };
+
+        inline size_t align_up(size_t value)
+        {
+            return (value + ShaderArchive::ALIGNMENT - 1) & ~(ShaderArchive::ALIGNMENT - 1);
+        }
+
+        inline bool key_less(const common::HPPHash128& a, const common::HPPHash128& b)
+        {
+            return std::tie(a.high, a.low) < std::tie(b.high, b.low);
+        }
+
+        // Whether [offset, offset + size) lies within a file of file_size bytes, without overflowing
+        inline bool in_bounds(uint64_t offset, uint64_t size, size_t file_size)
+        {
+            return offset <= file_size && size <= file_size - offset;
+        }
+
+        inline void write_string(common::HPPHasher& hasher, std::string_view value)
+        {
+            hasher.write(value.size());
+            hasher.write(value.data(), value.size());
+        }
+    }
+
+    struct ShaderArchive::Entry
+    {
+        common::HPPHash128 key;
+        uint64_t           spirv_offset      = 0;
+        uint64_t           spirv_size        = 0;        // In bytes
+        uint64_t           reflection_offset = 0;
+        uint64_t           reflection_size   = 0;
+    };
+
+    ShaderArchive::~ShaderArchive()
+    {
+        close();
+    }
+
+    ShaderArchive& ShaderArchive::get()
+    {
+        static ShaderArchive archive;
+        static std::once_flag opened;
+
+        std::call_once(opened, []() { archive.open(fs::path::get(fs::path::Type::Shaders, "shaders.vksa")); });
+
+        return archive;
+    }
+
+    common::HPPHash128 ShaderArchive::get_key(vk::ShaderStageFlagBits       stage,
+                                              std::string_view              preprocessed_source,
+                                              const std::string&            entry_point,
+                                              const core::HPPShaderVariant& shader_variant)
+    {
+        common::HPPHasher hasher;
+
+        hasher.write(SHADER_ARCHIVE_VERSION);
+        hasher.write(stage);
+        write_string(hasher, entry_point);
+
+        auto processes = shader_variant.get_processes();
+
+        write_string(hasher, shader_variant.get_preamble());
+        hasher.write(processes.size());
+        for (auto& process : processes)
+        {
+            write_string(hasher, process);
+        }
+
+        // Runtime array sizes only change the reflection, which the archive stores as well
+        std::map<std::string, size_t> runtime_array_sizes{ shader_variant.get_runtime_array_sizes().begin(), shader_variant.get_runtime_array_sizes().end() };
+
+        hasher.write(runtime_array_sizes.size());
+        for (auto& [name, size] : runtime_array_sizes)
+        {
+            write_string(hasher, name);
+            hasher.write(size);
+        }
+
+        write_string(hasher, preprocessed_source);
+
+        return hasher.digest();
+    }
+
+    void ShaderArchive::write(const vkb::filesystem::Path& path, const std::vector<ShaderArchiveItem>& items)
+    {
+        std::vector<const ShaderArchiveItem*> sorted;
+        sorted.reserve(items.size());
+
+        for (auto& item : items)
+        {
+            sorted.push_back(&item);
+        }
+
+        std::ranges::stable_sort(sorted, [](const ShaderArchiveItem* a, const ShaderArchiveItem* b) { return key_less(a->key, b->key); });
+
+        auto last = std::unique(sorted.begin(), sorted.end(), [](const ShaderArchiveItem* a, const ShaderArchiveItem* b) { return a->key == b->key; });
+        sorted.erase(last, sorted.end());
+
+        ShaderArchiveHeader header;
+        header.entry_count  = static_cast<uint32_t>(sorted.size());
+        header.index_offset = align_up(sizeof(header));
+
+        std::vector<Entry> index(sorted.size());
+
+        std::vector<std::vector<uint8_t>> reflections;
+        reflections.reserve(sorted.size());
+
+        // Lay the blobs out after the index. Variants compiled to the same code share their blobs.
+        size_t offset = header.index_offset + index.size() * sizeof(Entry);
+
+        std::map<std::pair<uint64_t, uint64_t>, uint64_t> blob_offsets;
+
+        auto place_blob = [&offset, &blob_offsets](const void* blob, size_t size) {
+            common::HPPHasher hasher;
+            hasher.write(blob, size);
+
+            auto digest         = hasher.digest();
+            auto [it, inserted] = blob_offsets.try_emplace(std::make_pair(digest.low, digest.high), uint64_t{ 0 });
+
+            if (inserted)
+            {
+                it->second = align_up(offset);
+                offset     = it->second + size;
+            }
+
+            return it->second;
+        };
+
+        for (size_t i = 0; i < sorted.size(); i++)
+        {
+            reflections.push_back(serialize_shader_resources(sorted[i]->resources));
+
+            index[i].key = sorted[i]->key;
+
+            index[i].spirv_size   = sorted[i]->spirv.size() * sizeof(uint32_t);
+            index[i].spirv_offset = place_blob(sorted[i]->spirv.data(), index[i].spirv_size);
+
+            index[i].reflection_size   = reflections.back().size();
+            index[i].reflection_offset = place_blob(reflections.back().data(), index[i].reflection_size);
+        }
+
+        std::vector<uint8_t> data(offset);
+
+        std::memcpy(data.data(), &header, sizeof(header));
+
+        if (!index.empty())
+        {
+            std::memcpy(data.data() + header.index_offset, index.data(), index.size() * sizeof(Entry));
+        }
+
+        // Shared blobs are written again with the same bytes
+        for (size_t i = 0; i < sorted.size(); i++)
+        {
+            std::memcpy(data.data() + index[i].spirv_offset, sorted[i]->spirv.data(), index[i].spirv_size);
+            std::memcpy(data.data() + index[i].reflection_offset, reflections[i].data(), index[i].reflection_size);
+        }
+
+        vkb::filesystem::get()->write_file_atomic(path, data);
+    }
+
+    bool ShaderArchive::open(const vkb::filesystem::Path& path)
+    {
+        close();
+
+#if defined(_WIN32)
+        HANDLE file_handle = CreateFileW(path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+        if (file_handle == INVALID_HANDLE_VALUE)
+        {
+            return false;
+        }
+
+        file = file_handle;
+
+        LARGE_INTEGER file_size;
+        if (!GetFileSizeEx(file_handle, &file_size) || file_size.QuadPart == 0)
+        {
+            close();
+            return false;
+        }
+
+        mapping = CreateFileMappingW(file_handle, nullptr, PAGE_READONLY, 0, 0, nullptr);
+        if (!mapping)
+        {
+            close();
+            return false;
+        }
+
+        data = static_cast<const uint8_t*>(MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0));
+        if (!data)
+        {
+            close();
+            return false;
+        }
+
+        data_size = static_cast<size_t>(file_size.QuadPart);
+#else
+        int fd = ::open(path.c_str(), O_RDONLY);
+        if (fd < 0)
+        {
+            return false;
+        }
+
+        struct stat file_stat;
+        if (fstat(fd, &file_stat) != 0 || file_stat.st_size == 0)
+        {
+            ::close(fd);
+            return false;
+        }
+
+        void* mapped = mmap(nullptr, static_cast<size_t>(file_stat.st_size), PROT_READ, MAP_PRIVATE, fd, 0);
+
+        // The mapping keeps the file alive on its own
+        ::close(fd);
+
+        if (mapped == MAP_FAILED)
+        {
+            return false;
+        }
+
+        data      = static_cast<const uint8_t*>(mapped);
+        data_size = static_cast<size_t>(file_stat.st_size);
+#endif
+
+        if (!validate())
+        {
+            close();
+            return false;
+        }
+
+        ShaderArchiveHeader header;
+        std::memcpy(&header, data, sizeof(header));
+
+        entries     = reinterpret_cast<const Entry*>(data + header.index_offset);
+        entry_count = header.entry_count;
+
+        return true;
+    }
+
+    void ShaderArchive::close()
+    {
+#if defined(_WIN32)
+        if (data)
+        {
+            UnmapViewOfFile(data);
+        }
+        if (mapping)
+        {
+            CloseHandle(mapping);
+        }
+        if (file)
+        {
+            CloseHandle(file);
+        }
+#else
+        if (data)
+        {
+            munmap(const_cast<uint8_t*>(data), data_size);
+        }
+#endif
+
+        data        = nullptr;
+        data_size   = 0;
+        entries     = nullptr;
+        entry_count = 0;
+        file        = nullptr;
+        mapping     = nullptr;
+    }
+
+    std::optional<ShaderArchiveEntry> ShaderArchive::find(const common::HPPHash128& key) const
+    {
+        auto end = entries + entry_count;
+        auto it  = std::lower_bound(entries, end, key, [](const Entry& entry, const common::HPPHash128& value) { return key_less(entry.key, value); });
+
+        if (it == end || it->key != key)
+        {
+            return std::nullopt;
+        }
+
+        return ShaderArchiveEntry{ { reinterpret_cast<const uint32_t*>(data + it->spirv_offset), it->spirv_size / sizeof(uint32_t) },
+                                   { data + it->reflection_offset, it->reflection_size } };
+    }
+
+    bool ShaderArchive::validate() const
+    {
+        ShaderArchiveHeader header;
+
+        if (data_size < sizeof(header))
+        {
+            return false;
+        }
+
+        std::memcpy(&header, data, sizeof(header));
+
+        if (header.magic != SHADER_ARCHIVE_MAGIC || header.version != SHADER_ARCHIVE_VERSION ||
+            header.index_offset % alignof(Entry) != 0 || !in_bounds(header.index_offset, uint64_t{ header.entry_count } * sizeof(Entry), data_size))
+        {
+            return false;
+        }
+
+        auto index = reinterpret_cast<const Entry*>(data + header.index_offset);
+
+        for (uint32_t i = 0; i < header.entry_count; i++)
+        {
+            auto& entry = index[i];
+
+            if (!in_bounds(entry.spirv_offset, entry.spirv_size, data_size) || !in_bounds(entry.reflection_offset, entry.reflection_size, data_size) ||
+                entry.spirv_offset % sizeof(uint32_t) != 0 || entry.spirv_size % sizeof(uint32_t) != 0 || entry.spirv_size == 0)
+            {
+                return false;
+            }
+
+            // Lookups rely on the order of the index
+            if (i > 0 && !key_less(index[i - 1].key, entry.key))
+            {
+                return false;
+            }
+        }
+
+        return true;
+    }
+}
\ No newline at end of file
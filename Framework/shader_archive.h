@@ -0,0 +1,105 @@
+#pragma once
+
+#include <cstdint>
+#include <optional>
+#include <span>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "common/hpp_hasher.h"
+#include "core/hpp_shader_module.h"
+#include "filesystem/filesystem.h"
+
+namespace vkb
+{
+    /**
+     * @brief A shader stored in an archive, viewing the mapped file
+     */
+    struct ShaderArchiveEntry
+    {
+        std::span<const uint32_t> spirv;
+        std::span<const uint8_t>  reflection;        // Resources encoded by serialize_shader_resources
+    };
+
+    /**
+     * @brief A shader to store in an archive
+     */
+    struct ShaderArchiveItem
+    {
+        common::HPPHash128                   key;
+        std::vector<uint32_t>                spirv;
+        std::vector<core::HPPShaderResource> resources;
+    };
+
+    /**
+     * @brief Read-only archive of precompiled shader variants, memory mapped so binaries are used in place.
+     *
+     * The archive starts with a header, followed by an index of the entries sorted by key, then by the
+     * SPIR-V and reflection blobs, each aligned to ALIGNMENT bytes. Shaders are keyed by their stage, entry
+     * point, variant and include-expanded source, so an edited source misses and gets compiled at runtime.
+     * The whole file is validated once when opened, lookups are then a binary search over the index.
+     */
+    class ShaderArchive
+    {
+    public:
+        static constexpr size_t ALIGNMENT = 64;
+
+        ShaderArchive() = default;
+        ~ShaderArchive();
+
+        ShaderArchive(const ShaderArchive&)            = delete;
+        ShaderArchive(ShaderArchive&&)                 = delete;
+        ShaderArchive& operator=(const ShaderArchive&) = delete;
+        ShaderArchive& operator=(ShaderArchive&&)      = delete;
+
+        /**
+         * @brief Returns the archive shared by the process, opened from shaders.vksa in the shader directory on first use
+         */
+        static ShaderArchive& get();
+
+        /**
+         * @brief Returns the key of a shader, computed without compiling it
+         */
+        static common::HPPHash128 get_key(vk::ShaderStageFlagBits       stage,
+                                          std::string_view              preprocessed_source,
+                                          const std::string&            entry_point,
+                                          const core::HPPShaderVariant& shader_variant);
+
+        /**
+         * @brief Writes an archive, items sharing a key are stored once
+         * @throws std::runtime_error if the file cannot be written
+         */
+        static void write(const vkb::filesystem::Path& path, const std::vector<ShaderArchiveItem>& items);
+
+        /**
+         * @brief Maps an archive, replacing the one mapped before. Must not be called while shaders are being looked up.
+         * @return False if the file is missing or not a valid archive, the archive is then empty
+         */
+        bool open(const vkb::filesystem::Path& path);
+
+        void close();
+
+        /**
+         * @brief Looks up a shader, the entry stays valid until the archive is closed
+         */
+        std::optional<ShaderArchiveEntry> find(const common::HPPHash128& key) const;
+
+        size_t size() const { return entry_count; }
+
+    private:
+        struct Entry;
+
+        bool validate() const;
+
+        const uint8_t* data = nullptr;
+        size_t         data_size = 0;
+
+        const Entry* entries     = nullptr;
+        size_t       entry_count = 0;
+
+        // Platform handles of the mapping
+        void* file    = nullptr;
+        void* mapping = nullptr;
+    };
+}
\ No newline at end of file
@@ -0,0 +1,115 @@
+#include "stdafx.h"
+#include "shader_manifest.h"
+
+#include <fstream>
+
+namespace vkb
+{
+    namespace
+    {
+        const std::unordered_map<std::string, vk::ShaderStageFlagBits> stages = {
+            { "vert", vk::ShaderStageFlagBits::eVertex },
+            { "frag", vk::ShaderStageFlagBits::eFragment },
+            { "comp", vk::ShaderStageFlagBits::eCompute },
+            { "geom", vk::ShaderStageFlagBits::eGeometry },
+            { "tesc", vk::ShaderStageFlagBits::eTessellationControl },
+            { "tese", vk::ShaderStageFlagBits::eTessellationEvaluation },
+        };
+
+        // Parses a line of the manifest, returns false if the line has no variant
+        bool parse_line(const std::string& text, ShaderManifestEntry& entry)
+        {
+            std::istringstream stream(text);
+
+            std::string stage;
+            if (!(stream >> stage) || stage.front() == '#')
+            {
+                return false;
+            }
+
+            auto it = stages.find(stage);
+            if (it == stages.end())
+            {
+                throw std::runtime_error("Unknown shader stage " + stage);
+            }
+
+            entry.stage = it->second;
+
+            if (!(stream >> entry.file))
+            {
+                throw std::runtime_error("Missing shader file");
+            }
+
+            std::string option;
+            while (stream >> option)
+            {
+                if (option.size() < 3 || option.front() != '-')
+                {
+                    throw std::runtime_error("Invalid option " + option);
+                }
+
+                std::string value = option.substr(2);
+
+                switch (option[1])
+                {
+                    case 'e':
+                        entry.entry_point = value;
+                        break;
+                    case 'D':
+                        entry.variant.add_define(value);
+                        break;
+                    case 'U':
+                        entry.variant.add_undefine(value);
+                        break;
+                    case 'R':
+                    {
+                        size_t pos_equal = value.find('=');
+                        if (pos_equal == std::string::npos || pos_equal == 0)
+                        {
+                            throw std::runtime_error("Invalid runtime array size " + option);
+                        }
+
+                        entry.variant.add_runtime_array_size(value.substr(0, pos_equal), std::stoull(value.substr(pos_equal + 1)));
+                        break;
+                    }
+                    default:
+                        throw std::runtime_error("Invalid option " + option);
+                }
+            }
+
+            return true;
+        }
+    }
+
+    std::vector<ShaderManifestEntry> read_shader_manifest(const std::string& path, std::vector<ShaderManifestError>& errors)
+    {
+        std::ifstream file(path);
+        if (!file)
+        {
+            throw std::runtime_error("Cannot open manifest " + path);
+        }
+
+        std::vector<ShaderManifestEntry> entries;
+
+        std::string text;
+        for (size_t line = 1; std::getline(file, text); line++)
+        {
+            ShaderManifestEntry entry;
+            entry.line = line;
+
+            try
+            {
+                if (parse_line(text, entry))
+                {
+                    entries.push_back(std::move(entry));
+                }
+            }
+            catch (const std::exception& e)
+            {
+                errors.push_back({ line, e.what() });
+            }
+        }
+
+        return entries;
+    }
+}
\ No newline at end of file
@@ -0,0 +1,41 @@
+#pragma once
+
+#include <string>
+#include <vector>
+
+#include "core/hpp_shader_module.h"
+
+namespace vkb
+{
+    /**
+     * @brief A shader variant listed in a manifest
+     */
+    struct ShaderManifestEntry
+    {
+        vk::ShaderStageFlagBits     stage{};
+        std::string                 file;
+        std::string                 entry_point = "main";
+        core::HPPShaderVariant      variant;
+        size_t                      line = 0;
+    };
+
+    /**
+     * @brief An invalid line of a manifest
+     */
+    struct ShaderManifestError
+    {
+        size_t      line = 0;
+        std::string message;
+    };
+
+    /**
+     * @brief Reads a list of shader variants, as consumed by the offline shader tools.
+     *
+     * Each line lists a variant, lines starting with # are comments:
+     *     <vert|frag|comp|geom|tesc|tese> <file> [-e<entry point>] [-D<define>[=<value>]] [-U<name>] [-R<runtime array>=<size>]
+     * Invalid lines are skipped, and returned to the caller with their line number.
+     * @param[out] errors Appended with the invalid lines
+     * @throws std::runtime_error if the manifest cannot be read
+     */
+    std::vector<ShaderManifestEntry> read_shader_manifest(const std::string& path, std::vector<ShaderManifestError>& errors);
+}
\ No newline at end of file
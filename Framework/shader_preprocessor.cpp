@@ -0,0 +1,205 @@
+#include "stdafx.h"
+#include "shader_preprocessor.h"
+
+namespace vkb
+{
+    namespace
+    {
+        inline std::string_view trim_left(std::string_view value)
+        {
+            size_t start = value.find_first_not_of(" \t");
+            return start == std::string_view::npos ? std::string_view{} : value.substr(start);
+        }
+
+        /**
+         * @brief Matches a preprocessor directive, allowing blanks around the '#'
+         * @return The rest of the line after the directive name, or an empty optional if it is another line
+         */
+        inline std::optional<std::string_view> match_directive(std::string_view line, std::string_view name)
+        {
+            line = trim_left(line);
+
+            if (line.empty() || line.front() != '#')
+            {
+                return std::nullopt;
+            }
+
+            line = trim_left(line.substr(1));
+
+            if (line.substr(0, name.size()) != name)
+            {
+                return std::nullopt;
+            }
+
+            auto rest = line.substr(name.size());
+
+            // The name must end there, e.g. not match #include_next
+            if (!rest.empty() && rest.front() != ' ' && rest.front() != '\t' && rest.front() != '"' && rest.front() != '\r')
+            {
+                return std::nullopt;
+            }
+
+            return trim_left(rest);
+        }
+
+        inline bool is_pragma_once(std::string_view line)
+        {
+            auto rest = match_directive(line, "pragma");
+            return rest && rest->substr(0, 4) == "once" && trim_left(rest->substr(4)).find_first_not_of("\r") == std::string_view::npos;
+        }
+
+        /**
+         * @brief Calls a function with each line of a source and its 1-based number, without the line ending
+         */
+        template <class F>
+        inline void for_each_line(std::string_view source, F&& func)
+        {
+            size_t   pos         = 0;
+            uint32_t line_number = 0;
+
+            while (pos < source.size())
+            {
+                size_t end = source.find('\n', pos);
+                if (end == std::string_view::npos)
+                {
+                    end = source.size();
+                }
+
+                func(source.substr(pos, end - pos), ++line_number);
+
+                pos = end + 1;
+            }
+        }
+    }
+
+    struct ShaderPreprocessor::ExpandState
+    {
+        std::string output;
+
+        std::vector<std::string>                  dependencies;
+        std::unordered_map<std::string, uint32_t> source_indices;        // Source string number of each dependency
+        std::unordered_set<std::string>           expanded_once;         // Files with #pragma once expanded already
+        std::vector<std::string>                  include_stack;
+
+        // Keeps the content the output is built from alive
+        std::vector<std::shared_ptr<const File>> files;
+    };
+
+    ShaderPreprocessor::ShaderPreprocessor(FileLoader loader) :
+        loader{ loader ? std::move(loader) : FileLoader{ [](const std::string& path) { return fs::read_shader(path); } } }
+    { }
+
+    PreprocessedShader ShaderPreprocessor::process(std::string_view source) const
+    {
+        ExpandState state;
+        state.output.reserve(source.size());
+
+        expand(source, 0, state);
+
+        return { std::move(state.output), std::move(state.dependencies) };
+    }
+
+    void ShaderPreprocessor::invalidate(const std::string& path)
+    {
+        std::lock_guard<std::mutex> guard(mutex);
+
+        files.erase(path);
+    }
+
+    void ShaderPreprocessor::clear()
+    {
+        std::lock_guard<std::mutex> guard(mutex);
+
+        files.clear();
+    }
+
+    std::shared_ptr<const ShaderPreprocessor::File> ShaderPreprocessor::load(const std::string& path) const
+    {
+        {
+            std::lock_guard<std::mutex> guard(mutex);
+
+            auto it = files.find(path);
+            if (it != files.end())
+            {
+                return it->second;
+            }
+        }
+
+        // Read outside of the lock, two threads may read the same file once but neither waits on the other's reads
+        auto file = std::make_shared<File>();
+        file->content = loader(path);
+
+        for_each_line(file->content, [&file](std::string_view line, uint32_t) {
+            file->pragma_once = file->pragma_once || is_pragma_once(line);
+        });
+
+        std::lock_guard<std::mutex> guard(mutex);
+
+        return files.emplace(path, std::move(file)).first->second;
+    }
+
+    void ShaderPreprocessor::expand(std::string_view source, uint32_t source_index, ExpandState& state) const
+    {
+        for_each_line(source, [this, source_index, &state](std::string_view line, uint32_t line_number) {
+            auto include = match_directive(line, "include");
+
+            if (!include)
+            {
+                // Blank the directive rather than removing it, so the following lines keep their numbers
+                if (!is_pragma_once(line))
+                {
+                    state.output.append(line);
+                }
+                state.output.push_back('\n');
+                return;
+            }
+
+            // Include paths are relative to the base shader directory
+            size_t first_quote = include->find('"');
+            size_t last_quote  = include->find('"', first_quote + 1);
+
+            if (first_quote == std::string_view::npos || last_quote == std::string_view::npos || last_quote == first_quote + 1)
+            {
+                throw std::runtime_error("Malformed include directive: " + std::string{ line });
+            }
+
+            std::string path{ include->substr(first_quote + 1, last_quote - first_quote - 1) };
+
+            auto file = load(path);
+
+            if (file->pragma_once && state.expanded_once.contains(path))
+            {
+                state.output.push_back('\n');
+                return;
+            }
+
+            if (std::ranges::find(state.include_stack, path) != state.include_stack.end())
+            {
+                throw std::runtime_error("Recursive include of " + path + ", add #pragma once to it");
+            }
+
+            auto index_it = state.source_indices.find(path);
+            if (index_it == state.source_indices.end())
+            {
+                state.dependencies.push_back(path);
+                index_it = state.source_indices.emplace(path, static_cast<uint32_t>(state.dependencies.size())).first;
+            }
+
+            if (file->pragma_once)
+            {
+                state.expanded_once.insert(path);
+            }
+
+            state.files.push_back(file);
+            state.include_stack.push_back(path);
+
+            state.output.append("#line 1 " + std::to_string(index_it->second) + "\n");
+
+            expand(file->content, index_it->second, state);
+
+            state.output.append("#line " + std::to_string(line_number + 1) + " " + std::to_string(source_index) + "\n");
+
+            state.include_stack.pop_back();
+        });
+    }
+}
\ No newline at end of file
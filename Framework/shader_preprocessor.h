@@ -0,0 +1,83 @@
+#pragma once
+
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+namespace vkb
+{
+    /**
+     * @brief A shader source with its includes expanded
+     */
+    struct PreprocessedShader
+    {
+        std::string source;
+
+        // The files included directly or not, in the order they were first included.
+        // Dependency i is source string number i + 1 in the #line markers, the main source being 0.
+        std::vector<std::string> dependencies;
+    };
+
+    /**
+     * @brief Expands the #include "file" directives of GLSL sources in a single pass.
+     *
+     * Sources are scanned line by line through string views and appended to a single output, so expanding a
+     * shader is linear in the size of its include tree. Each file is read once and kept for the lifetime of the
+     * preprocessor, which is meant to serve a batch of compiles: shared headers are then read once for all of them.
+     * Files containing #pragma once are expanded once per source. #line markers keep the line numbers reported
+     * by the compiler those of the original files.
+     * Processing is thread safe.
+     */
+    class ShaderPreprocessor
+    {
+    public:
+        using FileLoader = std::function<std::string(const std::string&)>;
+
+        /**
+         * @param loader Reads an included file from its path, by default relative to the shader directory
+         */
+        explicit ShaderPreprocessor(FileLoader loader = {});
+
+        /**
+         * @brief Expands the includes of a source
+         * @param source The GLSL source
+         * @throws std::runtime_error if an include cannot be read, or includes itself without #pragma once
+         */
+        PreprocessedShader process(std::string_view source) const;
+
+        /**
+         * @brief Forgets the content read for a file, so the next source including it reads it again
+         */
+        void invalidate(const std::string& path);
+
+        /**
+         * @brief Forgets the content of all the files read so far
+         */
+        void clear();
+
+    private:
+        struct ExpandState;
+
+        struct File
+        {
+            std::string content;
+            bool        pragma_once = false;
+        };
+
+        std::shared_ptr<const File> load(const std::string& path) const;
+
+        void expand(std::string_view source, uint32_t source_index, ExpandState& state) const;
+
+        FileLoader loader;
+
+        mutable std::mutex mutex;
+
+        // Shared with the sources being processed, which keep views into them even if they get invalidated
+        mutable std::unordered_map<std::string, std::shared_ptr<const File>> files;
+    };
+}
\ No newline at end of file
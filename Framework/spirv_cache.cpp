@@ -0,0 +1,468 @@
+#include "stdafx.h"
+#include "spirv_cache.h"
+#include "spirv_reflection.h"
+
+#include <spirv-tools/libspirv.h>
+
+namespace vkb
+{
+    namespace
+    {
+        // Bump when the file layout, or the way keys are computed, changes
+        constexpr uint32_t SPIRV_CACHE_MAGIC   = 0x43565053;        // "SPVC"
+        constexpr uint32_t SPIRV_CACHE_VERSION = 1;
+
+        // Bump when the reflected fields, or the way SPIRVReflection fills them, change
+        constexpr uint32_t REFLECTION_CACHE_MAGIC   = 0x52565053;        // "SPVR"
+        constexpr uint32_t REFLECTION_CACHE_VERSION = 3;
+
+        struct SPIRVCacheHeader
+        {
+            uint32_t           magic   = SPIRV_CACHE_MAGIC;
+            uint32_t           version = SPIRV_CACHE_VERSION;
+            common::HPPHash128 key;
+            uint64_t           word_count      = 0;
+            uint64_t           compile_time_us = 0;
+        };
+
+        struct ReflectionCacheHeader
+        {
+            uint32_t           magic   = REFLECTION_CACHE_MAGIC;
+            uint32_t           version = REFLECTION_CACHE_VERSION;
+            common::HPPHash128 key;
+            uint64_t           payload_size = 0;
+        };
+
+        // Strings are prefixed with their size, so the boundaries between fields are part of the key
+        inline void write_string(common::HPPHasher& hasher, const std::string& value)
+        {
+            hasher.write(value.size());
+            hasher.write(value.data(), value.size());
+        }
+
+        // Everything a compile depends on besides its inputs
+        void write_environment(common::HPPHasher& hasher, const GLSLCompiler& compiler)
+        {
+            hasher.write(SPIRV_CACHE_VERSION);
+
+            // A new glslang may generate different code for the same source
+            auto glslang_version = glslang::GetVersion();
+            hasher.write(glslang_version.major);
+            hasher.write(glslang_version.minor);
+            hasher.write(glslang_version.patch);
+            write_string(hasher, glslang_version.flavor ? glslang_version.flavor : "");
+            hasher.write(glslang::GetSpirvGeneratorVersion());
+
+            hasher.write(compiler.get_target_language());
+            hasher.write(compiler.get_target_language_version());
+
+            // So do different passes, or a new spirv-opt
+            auto& optimizer_options = compiler.get_optimizer_options();
+            hasher.write(optimizer_options.optimization);
+            hasher.write(optimizer_options.strip_debug_info);
+            if (optimizer_options.optimization != SPIRVOptimization::None)
+            {
+                write_string(hasher, spvSoftwareVersionString());
+            }
+        }
+
+        inline uint64_t elapsed_us(std::chrono::steady_clock::time_point start)
+        {
+            return std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - start).count();
+        }
+    }
+
+    SPIRVCache::SPIRVCache(const vkb::filesystem::Path& directory) :
+        directory{ directory }
+    { }
+
+    SPIRVCache& SPIRVCache::get()
+    {
+        static SPIRVCache cache{ vkb::filesystem::Path{ fs::path::get(fs::path::Type::Temp) } / "spirv_cache" };
+
+        return cache;
+    }
+
+    common::HPPHash128 SPIRVCache::get_key(const GLSLCompiler&           compiler,
+                                           vk::ShaderStageFlagBits       stage,
+                                           const std::vector<uint8_t>&   glsl_source,
+                                           const std::string&            entry_point,
+                                           const core::HPPShaderVariant& shader_variant)
+    {
+        common::HPPHasher hasher;
+
+        write_environment(hasher, compiler);
+
+        hasher.write(stage);
+        write_string(hasher, entry_point);
+
+        auto processes = shader_variant.get_processes();
+
+        write_string(hasher, shader_variant.get_preamble());
+        hasher.write(processes.size());
+        for (auto& process : processes)
+        {
+            write_string(hasher, process);
+        }
+
+        hasher.write(glsl_source.size());
+        hasher.write(glsl_source.data(), glsl_source.size());
+
+        return hasher.digest();
+    }
+
+    common::HPPHash128 SPIRVCache::get_preprocessed_key(const GLSLCompiler&     compiler,
+                                                        vk::ShaderStageFlagBits stage,
+                                                        const std::string&      preprocessed_source,
+                                                        const std::string&      entry_point)
+    {
+        common::HPPHasher hasher;
+
+        write_environment(hasher, compiler);
+
+        // Kept apart from the keys of get_key, which hash the source before preprocessing
+        write_string(hasher, "preprocessed");
+
+        hasher.write(stage);
+        write_string(hasher, entry_point);
+        write_string(hasher, preprocessed_source);
+
+        return hasher.digest();
+    }
+
+    bool SPIRVCache::compile_to_spirv(const GLSLCompiler&           compiler,
+                                      vk::ShaderStageFlagBits       stage,
+                                      const std::vector<uint8_t>&   glsl_source,
+                                      const std::string&            entry_point,
+                                      const core::HPPShaderVariant& shader_variant,
+                                      std::vector<std::uint32_t>&   spirv,
+                                      std::string&                  info_log)
+    {
+        if (!enabled)
+        {
+            return compiler.compile_to_spirv(stage, glsl_source, entry_point, shader_variant, spirv, info_log);
+        }
+
+        auto key = get_key(compiler, stage, glsl_source, entry_point, shader_variant);
+
+        if (load(key, spirv))
+        {
+            return true;
+        }
+
+        // A source failing to preprocess is compiled anyway, to report the error
+        std::string preprocessed_source;
+        std::string preprocess_log;
+
+        if (!compiler.preprocess(stage, glsl_source, entry_point, shader_variant, preprocessed_source, preprocess_log))
+        {
+            return compile(compiler, { key }, stage, glsl_source, entry_point, shader_variant, spirv, info_log);
+        }
+
+        auto preprocessed_key = get_preprocessed_key(compiler, stage, preprocessed_source, entry_point);
+        auto pending_key      = std::make_pair(preprocessed_key.low, preprocessed_key.high);
+
+        // Claim the compile of the preprocessed source, unless another thread is compiling it already
+        std::promise<void>       compiled;
+        std::shared_future<void> pending;
+        {
+            std::lock_guard<std::mutex> guard(pending_mutex);
+
+            auto [it, inserted] = pending_compiles.try_emplace(pending_key);
+            if (inserted)
+            {
+                it->second = compiled.get_future().share();
+            }
+            else
+            {
+                pending = it->second;
+            }
+        }
+
+        if (pending.valid())
+        {
+            pending.wait();
+
+            if (load(preprocessed_key, spirv))
+            {
+                deduplicated++;
+                store(key, spirv, 0.0f);
+                return true;
+            }
+
+            // The other compile failed, or could not be stored
+            return compile(compiler, { key }, stage, glsl_source, entry_point, shader_variant, spirv, info_log);
+        }
+
+        bool success = true;
+
+        if (load(preprocessed_key, spirv))
+        {
+            deduplicated++;
+            store(key, spirv, 0.0f);
+        }
+        else
+        {
+            success = compile(compiler, { key, preprocessed_key }, stage, glsl_source, entry_point, shader_variant, spirv, info_log);
+        }
+
+        {
+            std::lock_guard<std::mutex> guard(pending_mutex);
+
+            pending_compiles.erase(pending_key);
+        }
+
+        compiled.set_value();
+
+        return success;
+    }
+
+    bool SPIRVCache::compile(const GLSLCompiler&                    compiler,
+                             const std::vector<common::HPPHash128>& keys,
+                             vk::ShaderStageFlagBits                stage,
+                             const std::vector<uint8_t>&            glsl_source,
+                             const std::string&                     entry_point,
+                             const core::HPPShaderVariant&          shader_variant,
+                             std::vector<std::uint32_t>&            spirv,
+                             std::string&                           info_log)
+    {
+        misses++;
+
+        auto start = std::chrono::steady_clock::now();
+
+        if (!compiler.compile_to_spirv(stage, glsl_source, entry_point, shader_variant, spirv, info_log))
+        {
+            return false;
+        }
+
+        float compile_time_ms = elapsed_us(start) / 1000.0f;
+
+        for (auto& key : keys)
+        {
+            store(key, spirv, compile_time_ms);
+        }
+
+        return true;
+    }
+
+    bool SPIRVCache::load(const common::HPPHash128& key, std::vector<std::uint32_t>& spirv)
+    {
+        auto start = std::chrono::steady_clock::now();
+        auto fs    = vkb::filesystem::get();
+        auto path  = get_path(key, ".spv");
+
+        std::vector<uint8_t> data;
+
+        try
+        {
+            if (!fs->is_file(path))
+            {
+                return false;
+            }
+
+            data = fs->read_file_binary(path);
+        }
+        catch (const std::exception&)
+        {
+            return false;
+        }
+
+        SPIRVCacheHeader header;
+
+        if (data.size() < sizeof(header))
+        {
+            return false;
+        }
+
+        std::memcpy(&header, data.data(), sizeof(header));
+
+        if (header.magic != SPIRV_CACHE_MAGIC || header.version != SPIRV_CACHE_VERSION || header.key != key ||
+            header.word_count == 0 || data.size() - sizeof(header) != header.word_count * sizeof(uint32_t))
+        {
+            return false;
+        }
+
+        spirv.resize(header.word_count);
+        std::memcpy(spirv.data(), data.data() + sizeof(header), header.word_count * sizeof(uint32_t));
+
+        uint64_t load_us = elapsed_us(start);
+
+        hits++;
+        load_time_us += load_us;
+        saved_time_us += static_cast<int64_t>(header.compile_time_us) - static_cast<int64_t>(load_us);
+
+        return true;
+    }
+
+    void SPIRVCache::store(const common::HPPHash128& key, const std::vector<std::uint32_t>& spirv, float compile_time_ms)
+    {
+        SPIRVCacheHeader header;
+        header.key             = key;
+        header.word_count      = spirv.size();
+        header.compile_time_us = static_cast<uint64_t>(compile_time_ms * 1000.0f);
+
+        std::vector<uint8_t> data(sizeof(header) + spirv.size() * sizeof(uint32_t));
+        std::memcpy(data.data(), &header, sizeof(header));
+        std::memcpy(data.data() + sizeof(header), spirv.data(), spirv.size() * sizeof(uint32_t));
+
+        // The binary is in hand already, failing to keep it only costs a compile next time
+        try
+        {
+            vkb::filesystem::get()->write_file_atomic(get_path(key, ".spv"), data);
+        }
+        catch (const std::exception&)
+        {
+        }
+    }
+
+    common::HPPHash128 SPIRVCache::get_reflection_key(SPIRVReflectionBackend        backend,
+                                                      vk::ShaderStageFlagBits       stage,
+                                                      const std::vector<uint32_t>&  spirv,
+                                                      const core::HPPShaderVariant& shader_variant)
+    {
+        common::HPPHasher hasher;
+
+        hasher.write(REFLECTION_CACHE_VERSION);
+        hasher.write(backend);
+        hasher.write(stage);
+
+        hasher.write(spirv.size());
+        hasher.write(spirv.data(), spirv.size() * sizeof(uint32_t));
+
+        // Sorted, so the key does not depend on the order of the map
+        std::map<std::string, size_t> runtime_array_sizes{ shader_variant.get_runtime_array_sizes().begin(), shader_variant.get_runtime_array_sizes().end() };
+
+        hasher.write(runtime_array_sizes.size());
+        for (auto& [name, size] : runtime_array_sizes)
+        {
+            write_string(hasher, name);
+            hasher.write(size);
+        }
+
+        return hasher.digest();
+    }
+
+    bool SPIRVCache::reflect_shader_resources(vk::ShaderStageFlagBits               stage,
+                                              const std::vector<uint32_t>&          spirv,
+                                              std::vector<core::HPPShaderResource>& resources,
+                                              const core::HPPShaderVariant&         shader_variant)
+    {
+        SPIRVReflectionBackend backend = reflection_backend;
+        SPIRVReflection        spirv_reflection{ backend };
+
+        if (!enabled)
+        {
+            return spirv_reflection.reflect_shader_resources(stage, spirv, resources, shader_variant);
+        }
+
+        // The backend is part of the key, so comparing the backends is never fooled by the cache
+        auto key = get_reflection_key(backend, stage, spirv, shader_variant);
+
+        if (load_reflection(key, resources))
+        {
+            return true;
+        }
+
+        reflection_misses++;
+
+        if (!spirv_reflection.reflect_shader_resources(stage, spirv, resources, shader_variant))
+        {
+            return false;
+        }
+
+        store_reflection(key, resources);
+
+        return true;
+    }
+
+    bool SPIRVCache::load_reflection(const common::HPPHash128& key, std::vector<core::HPPShaderResource>& resources)
+    {
+        auto fs   = vkb::filesystem::get();
+        auto path = get_path(key, ".refl");
+
+        std::vector<uint8_t> data;
+
+        try
+        {
+            if (!fs->is_file(path))
+            {
+                return false;
+            }
+
+            data = fs->read_file_binary(path);
+        }
+        catch (const std::exception&)
+        {
+            return false;
+        }
+
+        ReflectionCacheHeader header;
+
+        if (data.size() < sizeof(header))
+        {
+            return false;
+        }
+
+        std::memcpy(&header, data.data(), sizeof(header));
+
+        if (header.magic != REFLECTION_CACHE_MAGIC || header.version != REFLECTION_CACHE_VERSION || header.key != key ||
+            data.size() - sizeof(header) != header.payload_size)
+        {
+            return false;
+        }
+
+        if (!deserialize_shader_resources(data.data() + sizeof(header), header.payload_size, resources))
+        {
+            return false;
+        }
+
+        reflection_hits++;
+
+        return true;
+    }
+
+    void SPIRVCache::store_reflection(const common::HPPHash128& key, const std::vector<core::HPPShaderResource>& resources)
+    {
+        std::vector<uint8_t> payload = serialize_shader_resources(resources);
+
+        ReflectionCacheHeader header;
+        header.key          = key;
+        header.payload_size = payload.size();
+
+        std::vector<uint8_t> data(sizeof(header) + payload.size());
+        std::memcpy(data.data(), &header, sizeof(header));
+        std::memcpy(data.data() + sizeof(header), payload.data(), payload.size());
+
+        try
+        {
+            vkb::filesystem::get()->write_file_atomic(get_path(key, ".refl"), data);
+        }
+        catch (const std::exception&)
+        {
+        }
+    }
+
+    SPIRVCacheStats SPIRVCache::get_stats() const
+    {
+        SPIRVCacheStats stats;
+
+        stats.hits          = hits;
+        stats.misses        = misses;
+        stats.deduplicated  = deduplicated;
+        stats.load_time_ms  = load_time_us / 1000.0f;
+        stats.saved_time_ms = saved_time_us / 1000.0f;
+
+        stats.reflection_hits   = reflection_hits;
+        stats.reflection_misses = reflection_misses;
+
+        return stats;
+    }
+
+    vkb::filesystem::Path SPIRVCache::get_path(const common::HPPHash128& key, const char* extension) const
+    {
+        std::ostringstream name;
+        name << std::hex << std::setfill('0') << std::setw(16) << key.high << std::setw(16) << key.low << extension;
+
+        return directory / name.str();
+    }
+}
\ No newline at end of file
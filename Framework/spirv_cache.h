@@ -0,0 +1,169 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <future>
+#include <map>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#include "glsl_compiler.h"
+#include "spirv_reflection.h"
+#include "common/hpp_hasher.h"
+#include "filesystem/filesystem.h"
+
+namespace vkb
+{
+    /**
+     * @brief Hit ratio and timings of the SPIR-V cache
+     */
+    struct SPIRVCacheStats
+    {
+        uint64_t hits          = 0;
+        uint64_t misses        = 0;        // Lookups compiled by glslang, including the ones with a corrupt file
+        uint64_t deduplicated  = 0;        // Hits on the binary of another variant preprocessing to the same output
+        float    load_time_ms  = 0.0f;     // Reading and validating the files of the hits
+        float    saved_time_ms = 0.0f;     // Compile time recorded with the hits, minus the time spent loading them
+
+        uint64_t reflection_hits   = 0;
+        uint64_t reflection_misses = 0;    // Binaries reflected by SPIRV-Cross
+    };
+
+    /**
+     * @brief Content addressed on-disk cache of compiled shaders, in front of GLSLCompiler.
+     *
+     * Each binary is stored in its own file, named after a 128-bit hash of everything the compile depends on:
+     * the include-expanded source, the variant preamble and processes, the entry point, the stage, the target
+     * environment of the compiler and the version of glslang. Any change to those gives another file, so entries
+     * never need invalidating. Files are written atomically and validated on load, a bad one is compiled again.
+     * A binary is also stored under a hash of the preprocessed source, so a variant whose defines make no difference
+     * to the source loads the binary of the first one compiled, even while it is still being compiled on another thread.
+     *
+     * The shader resources reflected from a binary are stored next to it, keyed by a hash of the binary and
+     * of the runtime array sizes of the variant, so loading a cached shader skips SPIRV-Cross as well.
+     */
+    class SPIRVCache
+    {
+    public:
+        /**
+         * @brief Creates a cache storing its files in a directory, created on the first store
+         */
+        explicit SPIRVCache(const vkb::filesystem::Path& directory);
+
+        /**
+         * @brief Returns the cache shared by the process, stored in the temporary directory
+         */
+        static SPIRVCache& get();
+
+        /**
+         * @brief Returns the key of a compile, see GLSLCompiler::compile_to_spirv for the parameters
+         */
+        static common::HPPHash128 get_key(const GLSLCompiler&           compiler,
+                                          vk::ShaderStageFlagBits       stage,
+                                          const std::vector<uint8_t>&   glsl_source,
+                                          const std::string&            entry_point,
+                                          const core::HPPShaderVariant& shader_variant);
+
+        /**
+         * @brief Returns the key of a compile from the output of GLSLCompiler::preprocess, shared by the variants preprocessing to it
+         */
+        static common::HPPHash128 get_preprocessed_key(const GLSLCompiler&     compiler,
+                                                       vk::ShaderStageFlagBits stage,
+                                                       const std::string&      preprocessed_source,
+                                                       const std::string&      entry_point);
+
+        /**
+         * @brief Compiles GLSL to SPIR-V through the cache, glslang only runs on a miss
+         * @return Whether spirv holds the compiled shader, info_log is only filled by a failed compile
+         */
+        bool compile_to_spirv(const GLSLCompiler&           compiler,
+                              vk::ShaderStageFlagBits       stage,
+                              const std::vector<uint8_t>&   glsl_source,
+                              const std::string&            entry_point,
+                              const core::HPPShaderVariant& shader_variant,
+                              std::vector<std::uint32_t>&   spirv,
+                              std::string&                  info_log);
+
+        /**
+         * @brief Reads the binary stored for a key
+         * @return False if there is none, or the file is not valid
+         */
+        bool load(const common::HPPHash128& key, std::vector<std::uint32_t>& spirv);
+
+        /**
+         * @brief Stores a binary along with the time it took to compile, a failing write only loses the entry
+         */
+        void store(const common::HPPHash128& key, const std::vector<std::uint32_t>& spirv, float compile_time_ms);
+
+        /**
+         * @brief Returns the key of the resources reflected from a binary, see SPIRVReflection::reflect_shader_resources for the parameters
+         */
+        static common::HPPHash128 get_reflection_key(SPIRVReflectionBackend        backend,
+                                                     vk::ShaderStageFlagBits       stage,
+                                                     const std::vector<uint32_t>&  spirv,
+                                                     const core::HPPShaderVariant& shader_variant);
+
+        /**
+         * @brief Reflects the resources of a binary through the cache, SPIRV-Cross only runs on a miss
+         * @return Whether resources holds the reflected resources
+         */
+        bool reflect_shader_resources(vk::ShaderStageFlagBits               stage,
+                                      const std::vector<uint32_t>&          spirv,
+                                      std::vector<core::HPPShaderResource>& resources,
+                                      const core::HPPShaderVariant&         shader_variant);
+
+        /**
+         * @brief Reads the resources stored for a key
+         * @return False if there are none, or the file is not valid
+         */
+        bool load_reflection(const common::HPPHash128& key, std::vector<core::HPPShaderResource>& resources);
+
+        /**
+         * @brief Stores the resources reflected from a binary, a failing write only loses the entry
+         */
+        void store_reflection(const common::HPPHash128& key, const std::vector<core::HPPShaderResource>& resources);
+
+        /**
+         * @brief Selects how reflect_shader_resources reflects the binaries missing from the cache
+         */
+        void set_reflection_backend(SPIRVReflectionBackend backend) { reflection_backend = backend; }
+
+        /**
+         * @brief Disabling the cache makes compile_to_spirv always compile, reflect_shader_resources always reflect, and neither store
+         */
+        void set_enabled(bool enabled) { this->enabled = enabled; }
+
+        SPIRVCacheStats get_stats() const;
+
+    private:
+        vkb::filesystem::Path get_path(const common::HPPHash128& key, const char* extension) const;
+
+        // Compiles a miss, storing the binary under each of the keys given
+        bool compile(const GLSLCompiler&                    compiler,
+                     const std::vector<common::HPPHash128>& keys,
+                     vk::ShaderStageFlagBits                stage,
+                     const std::vector<uint8_t>&            glsl_source,
+                     const std::string&                     entry_point,
+                     const core::HPPShaderVariant&          shader_variant,
+                     std::vector<std::uint32_t>&            spirv,
+                     std::string&                           info_log);
+
+        vkb::filesystem::Path directory;
+
+        std::atomic<bool>                   enabled{ true };
+        std::atomic<SPIRVReflectionBackend> reflection_backend{ SPIRVReflectionBackend::SPIRVCross };
+
+        std::atomic<uint64_t> hits{ 0 };
+        std::atomic<uint64_t> misses{ 0 };
+        std::atomic<uint64_t> deduplicated{ 0 };
+        std::atomic<uint64_t> load_time_us{ 0 };
+        std::atomic<int64_t>  saved_time_us{ 0 };
+        std::atomic<uint64_t> reflection_hits{ 0 };
+        std::atomic<uint64_t> reflection_misses{ 0 };
+
+        // Preprocessed keys being compiled, completed once the binary is stored
+        std::mutex                                                        pending_mutex;
+        std::map<std::pair<uint64_t, uint64_t>, std::shared_future<void>> pending_compiles;
+    };
+}
\ No newline at end of file
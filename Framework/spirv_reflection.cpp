@@ -16,6 +16,7 @@
  */
 
 #include "spirv_reflection.h"
+#include "common/helpers.h"
 
 namespace vkb
 {
@@ -75,13 +76,27 @@ namespace vkb
             shader_resource.input_attachment_index = compiler.get_decoration(resource.id, spv::DecorationInputAttachmentIndex);
         }
 
+        // Storage images carry their access qualifiers on the variable, buffers on every member of their block
+        inline spirv_cross::Bitset get_access_flags(const spirv_cross::Compiler& compiler, const spirv_cross::Resource& resource)
+        {
+            if (compiler.get_type(resource.base_type_id).basetype == spirv_cross::SPIRType::Struct)
+            {
+                return compiler.get_buffer_block_flags(resource.id);
+            }
+
+            return compiler.get_decoration_bitset(resource.id);
+        }
+
         template <>
         inline void read_resource_decoration<spv::DecorationNonWritable>(const spirv_cross::Compiler&  compiler,
                                                                          const spirv_cross::Resource&  resource,
                                                                          core::HPPShaderResource&      shader_resource,
                                                                          const core::HPPShaderVariant& variant)
         {
-            shader_resource.qualifiers |= core::HPPShaderResourceQualifiers::NonWritable;
+            if (get_access_flags(compiler, resource).get(spv::DecorationNonWritable))
+            {
+                shader_resource.qualifiers |= core::HPPShaderResourceQualifiers::NonWritable;
+            }
         }
 
         template <>
@@ -90,7 +105,10 @@ namespace vkb
                                                                          core::HPPShaderResource&      shader_resource,
                                                                          const core::HPPShaderVariant& variant)
         {
-            shader_resource.qualifiers |= core::HPPShaderResourceQualifiers::NonReadable;
+            if (get_access_flags(compiler, resource).get(spv::DecorationNonReadable))
+            {
+                shader_resource.qualifiers |= core::HPPShaderResourceQualifiers::NonReadable;
+            }
         }
 
         inline void read_resource_vec_size(const spirv_cross::Compiler&  compiler,
@@ -355,7 +373,7 @@ namespace vkb
 
             for (auto& resource : storage_resources)
             {
-                core::HPPShaderResource shader_resource;
+                core::HPPShaderResource shader_resource{};
                 shader_resource.type = core::HPPShaderResourceType::BufferStorage;
                 shader_resource.stages = stage;
                 shader_resource.name = resource.name;
@@ -370,10 +388,74 @@ namespace vkb
                 resources.push_back(shader_resource);
             }
         }
+
+        inline void encode_shader_resource(std::ostringstream& os, const core::HPPShaderResource& resource)
+        {
+            write(os,
+                  static_cast<uint32_t>(resource.stages),
+                  resource.type,
+                  resource.mode,
+                  resource.set,
+                  resource.binding,
+                  resource.location,
+                  resource.input_attachment_index,
+                  resource.vec_size,
+                  resource.columns,
+                  resource.array_size,
+                  resource.offset,
+                  resource.size,
+                  resource.constant_id,
+                  resource.qualifiers,
+                  resource.name);
+        }
+
+        // Reads the name by hand, so a corrupt size fails the read rather than allocating it
+        inline bool decode_shader_resource(std::istringstream& is, size_t size, core::HPPShaderResource& resource)
+        {
+            uint32_t    stages;
+            std::size_t name_size;
+
+            read(is,
+                 stages,
+                 resource.type,
+                 resource.mode,
+                 resource.set,
+                 resource.binding,
+                 resource.location,
+                 resource.input_attachment_index,
+                 resource.vec_size,
+                 resource.columns,
+                 resource.array_size,
+                 resource.offset,
+                 resource.size,
+                 resource.constant_id,
+                 resource.qualifiers,
+                 name_size);
+
+            if (!is || name_size > size - static_cast<size_t>(is.tellg()))
+            {
+                return false;
+            }
+
+            resource.stages = static_cast<vk::ShaderStageFlags>(stages);
+            resource.name.resize(name_size);
+            is.read(resource.name.data(), name_size);
+
+            return static_cast<bool>(is);
+        }
     }        // namespace
 
+    SPIRVReflection::SPIRVReflection(SPIRVReflectionBackend backend) :
+        backend{ backend }
+    { }
+
     bool SPIRVReflection::reflect_shader_resources(vk::ShaderStageFlagBits stage, const std::vector<uint32_t>& spirv, std::vector<core::HPPShaderResource>& resources, const core::HPPShaderVariant& variant)
     {
+        if (backend == SPIRVReflectionBackend::Native)
+        {
+            return reflect_native(stage, spirv, resources, variant);
+        }
+
         spirv_cross::CompilerGLSL compiler{ spirv };
 
         auto opts = compiler.get_common_options();
@@ -452,4 +534,51 @@ namespace vkb
             resources.push_back(shader_resource);
         }
     }
+
+    std::vector<uint8_t> serialize_shader_resources(const std::vector<core::HPPShaderResource>& resources)
+    {
+        std::ostringstream os;
+
+        write(os, resources.size());
+
+        for (auto& resource : resources)
+        {
+            encode_shader_resource(os, resource);
+        }
+
+        std::string data = os.str();
+
+        return { data.begin(), data.end() };
+    }
+
+    bool deserialize_shader_resources(const uint8_t* data, size_t size, std::vector<core::HPPShaderResource>& resources)
+    {
+        std::istringstream is{ std::string{ reinterpret_cast<const char*>(data), size } };
+
+        std::size_t count;
+        read(is, count);
+
+        if (!is)
+        {
+            return false;
+        }
+
+        std::vector<core::HPPShaderResource> decoded;
+
+        for (std::size_t i = 0; i < count; i++)
+        {
+            core::HPPShaderResource resource{};
+
+            if (!decode_shader_resource(is, size, resource))
+            {
+                return false;
+            }
+
+            decoded.push_back(std::move(resource));
+        }
+
+        resources.insert(resources.end(), std::make_move_iterator(decoded.begin()), std::make_move_iterator(decoded.end()));
+
+        return true;
+    }
 }        // namespace vkb
@@ -32,10 +32,19 @@
 
 namespace vkb
 {
+    /// The ways SPIRVReflection can read a binary, both giving the same resources
+    enum class SPIRVReflectionBackend
+    {
+        SPIRVCross,        ///< Parses the binary into a full SPIRV-Cross compiler
+        Native             ///< Reads the decorations and types it needs in a single pass over the words, into flat tables indexed by id
+    };
+
     /// Generate a list of shader resource based on SPIRV reflection code, and provided ShaderVariant
     class SPIRVReflection
     {
     public:
+        explicit SPIRVReflection(SPIRVReflectionBackend backend = SPIRVReflectionBackend::SPIRVCross);
+
         /// @brief Reflects shader resources from SPIRV code
         /// @param stage The Vulkan shader stage flag
         /// @param spirv The SPIRV code of shader
@@ -47,6 +56,13 @@ namespace vkb
                                      const core::HPPShaderVariant&         variant);
 
     private:
+        /// @brief Reflects shader resources without SPIRV-Cross, defined in spirv_reflection_native.cpp
+        /// @return False if the binary is malformed
+        bool reflect_native(vk::ShaderStageFlagBits               stage,
+                            const std::vector<uint32_t>&          spirv,
+                            std::vector<core::HPPShaderResource>& resources,
+                            const core::HPPShaderVariant&         variant);
+
         void parse_shader_resources(const spirv_cross::Compiler&          compiler,
                                     vk::ShaderStageFlagBits               stage,
                                     std::vector<core::HPPShaderResource>& resources,
@@ -61,5 +77,14 @@ namespace vkb
                                             vk::ShaderStageFlagBits               stage,
                                             std::vector<core::HPPShaderResource>& resources,
                                             const core::HPPShaderVariant&         variant);
+
+        SPIRVReflectionBackend backend;
     };
+
+    /// @brief Encodes reflected resources in the compact binary form stored by the shader caches
+    std::vector<uint8_t> serialize_shader_resources(const std::vector<core::HPPShaderResource>& resources);
+
+    /// @brief Decodes resources encoded by serialize_shader_resources, appending them to a list
+    /// @return False if the data is not a valid encoding, resources is then left as it was
+    bool deserialize_shader_resources(const uint8_t* data, size_t size, std::vector<core::HPPShaderResource>& resources);
 }        // namespace vkb
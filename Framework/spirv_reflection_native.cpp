@@ -0,0 +1,787 @@
+#include "stdafx.h"
+#include "spirv_reflection.h"
+
+namespace vkb
+{
+    namespace
+    {
+        constexpr uint32_t SPIRV_MAGIC       = 0x07230203;
+        constexpr uint32_t SPIRV_HEADER_SIZE = 5;
+
+        // Variable decorations, and member decorations of structs, the reflection reads
+        struct Decorations
+        {
+            enum : uint32_t
+            {
+                DescriptorSet        = 1 << 0,
+                Binding              = 1 << 1,
+                Location             = 1 << 2,
+                InputAttachmentIndex = 1 << 3,
+                SpecId               = 1 << 4,
+                Block                = 1 << 5,
+                BufferBlock          = 1 << 6,
+                BuiltIn              = 1 << 7,
+                NonReadable          = 1 << 8,
+                NonWritable          = 1 << 9,
+                RowMajor             = 1 << 10,
+            };
+
+            uint32_t flags                  = 0;
+            uint32_t set                    = 0;
+            uint32_t binding                = 0;
+            uint32_t location               = 0;
+            uint32_t input_attachment_index = 0;
+            uint32_t spec_id                = 0;
+            uint32_t array_stride           = 0;
+            uint32_t offset                 = 0;
+            uint32_t matrix_stride          = 0;
+        };
+
+        struct Type
+        {
+            spv::Op  op           = spv::OpNop;
+            uint32_t width        = 0;        // Scalars
+            uint32_t element      = 0;        // Component, column, element, pointee or image type
+            uint32_t count        = 0;        // Vector size, matrix columns, or id of the array length
+            uint32_t storage      = 0;        // Pointers
+            uint32_t dim          = 0;        // Images
+            uint32_t sampled      = 0;        // Images
+            uint32_t member_begin = 0;        // Struct members, in the shared member table
+            uint32_t member_count = 0;
+        };
+
+        struct Constant
+        {
+            uint32_t type           = 0;
+            uint64_t value          = 0;
+            bool     defined        = false;
+            bool     specialization = false;
+        };
+
+        struct Variable
+        {
+            uint32_t id;
+            uint32_t type;
+            uint32_t storage;
+        };
+
+        /**
+         * @brief Tables of the ids of a module, indexed by id and filled by a single pass over its words
+         */
+        class Module
+        {
+        public:
+            bool parse(const std::vector<uint32_t>& spirv)
+            {
+                if (spirv.size() < SPIRV_HEADER_SIZE || spirv[0] != SPIRV_MAGIC)
+                {
+                    return false;
+                }
+
+                version     = spirv[1];
+                module_size = spirv.size();
+
+                uint32_t bound = spirv[3];
+
+                names.resize(bound);
+                decorations.resize(bound);
+                types.resize(bound);
+                constants.resize(bound);
+                member_decorations.resize(bound);
+                interface.resize(bound);
+
+                for (size_t pos = SPIRV_HEADER_SIZE; pos < spirv.size();)
+                {
+                    uint32_t word_count = spirv[pos] >> 16;
+                    auto     op         = static_cast<spv::Op>(spirv[pos] & 0xffff);
+
+                    if (word_count == 0 || pos + word_count > spirv.size())
+                    {
+                        return false;
+                    }
+
+                    if (!parse_instruction(op, &spirv[pos + 1], word_count - 1))
+                    {
+                        return false;
+                    }
+
+                    pos += word_count;
+                }
+
+                return true;
+            }
+
+            // Reflects the resources in the order, and with the values, SPIRV-Cross reports them
+            void reflect(vk::ShaderStageFlagBits stage, std::vector<core::HPPShaderResource>& resources, const core::HPPShaderVariant& variant) const
+            {
+                std::array<std::vector<const Variable*>, static_cast<size_t>(core::HPPShaderResourceType::All)> groups;
+
+                for (auto& variable : variables)
+                {
+                    auto type = classify(variable);
+                    if (type != core::HPPShaderResourceType::All)
+                    {
+                        groups[static_cast<size_t>(type)].push_back(&variable);
+                    }
+                }
+
+                for (size_t type = 0; type < groups.size(); type++)
+                {
+                    if (type == static_cast<size_t>(core::HPPShaderResourceType::PushConstant))
+                    {
+                        continue;
+                    }
+
+                    for (auto* variable : groups[type])
+                    {
+                        resources.push_back(read_variable(*variable, static_cast<core::HPPShaderResourceType>(type), stage, variant));
+                    }
+                }
+
+                for (auto* variable : groups[static_cast<size_t>(core::HPPShaderResourceType::PushConstant)])
+                {
+                    resources.push_back(read_push_constant(*variable, stage, variant));
+                }
+
+                for (uint32_t id : spec_constants)
+                {
+                    if (!(decorations[id].flags & Decorations::SpecId))
+                    {
+                        continue;
+                    }
+
+                    core::HPPShaderResource shader_resource{};
+                    shader_resource.type        = core::HPPShaderResourceType::SpecializationConstant;
+                    shader_resource.stages      = stage;
+                    shader_resource.name        = names[id];
+                    shader_resource.constant_id = decorations[id].spec_id;
+                    shader_resource.size        = get_scalar_size(constants[id].type);
+
+                    resources.push_back(shader_resource);
+                }
+            }
+
+        private:
+            static std::string_view read_string(const uint32_t* operands, uint32_t count, uint32_t& consumed)
+            {
+                auto*  begin = reinterpret_cast<const char*>(operands);
+                size_t max   = count * sizeof(uint32_t);
+                size_t size  = std::find(begin, begin + max, '\0') - begin;
+
+                consumed = static_cast<uint32_t>(size / sizeof(uint32_t) + 1);
+
+                return { begin, size };
+            }
+
+            bool is_valid(uint32_t id) const
+            {
+                return id < types.size();
+            }
+
+            bool parse_instruction(spv::Op op, const uint32_t* operands, uint32_t count)
+            {
+                switch (op)
+                {
+                case spv::OpEntryPoint:
+                {
+                    // Like SPIRV-Cross, only the first entry point is considered
+                    if (count < 3 || entry_point_found)
+                    {
+                        return count >= 3;
+                    }
+
+                    entry_point_found = true;
+
+                    uint32_t consumed = 0;
+                    read_string(operands + 2, count - 2, consumed);
+
+                    for (uint32_t i = 2 + consumed; i < count; i++)
+                    {
+                        if (!is_valid(operands[i]))
+                        {
+                            return false;
+                        }
+                        interface[operands[i]] = true;
+                    }
+                    return true;
+                }
+                case spv::OpName:
+                {
+                    if (count < 2 || !is_valid(operands[0]))
+                    {
+                        return false;
+                    }
+
+                    uint32_t consumed = 0;
+                    names[operands[0]] = read_string(operands + 1, count - 1, consumed);
+                    return true;
+                }
+                case spv::OpDecorate:
+                {
+                    if (count < 2 || !is_valid(operands[0]))
+                    {
+                        return false;
+                    }
+
+                    decorate(decorations[operands[0]], static_cast<spv::Decoration>(operands[1]), operands + 2, count - 2);
+                    return true;
+                }
+                case spv::OpMemberDecorate:
+                {
+                    // Each member of a struct takes a word of its OpTypeStruct, an index past the size of the module is malformed
+                    if (count < 3 || !is_valid(operands[0]) || operands[1] >= module_size)
+                    {
+                        return false;
+                    }
+
+                    auto& members = member_decorations[operands[0]];
+                    if (members.size() <= operands[1])
+                    {
+                        members.resize(operands[1] + 1);
+                    }
+
+                    decorate(members[operands[1]], static_cast<spv::Decoration>(operands[2]), operands + 3, count - 3);
+                    return true;
+                }
+                case spv::OpTypeBool:
+                case spv::OpTypeSampler:
+                    return set_type(operands, count, 1, { op });
+                case spv::OpTypeInt:
+                case spv::OpTypeFloat:
+                    return set_type(operands, count, 2, { op, operands[1] });
+                case spv::OpTypeVector:
+                case spv::OpTypeMatrix:
+                case spv::OpTypeArray:
+                    return set_type(operands, count, 3, { op, 0, operands[1], operands[2] });
+                case spv::OpTypeRuntimeArray:
+                case spv::OpTypeSampledImage:
+                    return set_type(operands, count, 2, { op, 0, operands[1] });
+                case spv::OpTypeImage:
+                    return set_type(operands, count, 8, { op, 0, operands[1], 0, 0, operands[2], operands[6] });
+                case spv::OpTypePointer:
+                    return set_type(operands, count, 3, { op, 0, operands[2], 0, operands[1] });
+                case spv::OpTypeStruct:
+                {
+                    Type type{ op };
+                    type.member_begin = static_cast<uint32_t>(members.size());
+                    type.member_count = count - 1;
+
+                    members.insert(members.end(), operands + 1, operands + count);
+
+                    return set_type(operands, count, 1, type);
+                }
+                case spv::OpConstant:
+                case spv::OpSpecConstant:
+                {
+                    if (count < 3 || !is_valid(operands[1]))
+                    {
+                        return false;
+                    }
+
+                    auto& constant          = constants[operands[1]];
+                    constant.type           = operands[0];
+                    constant.value          = count > 3 ? (static_cast<uint64_t>(operands[3]) << 32) | operands[2] : operands[2];
+                    constant.defined        = true;
+                    constant.specialization = op == spv::OpSpecConstant;
+
+                    if (constant.specialization)
+                    {
+                        spec_constants.push_back(operands[1]);
+                    }
+                    return true;
+                }
+                case spv::OpSpecConstantTrue:
+                case spv::OpSpecConstantFalse:
+                case spv::OpSpecConstantComposite:
+                {
+                    if (count < 2 || !is_valid(operands[1]))
+                    {
+                        return false;
+                    }
+
+                    auto& constant          = constants[operands[1]];
+                    constant.type           = operands[0];
+                    constant.value          = op == spv::OpSpecConstantTrue;
+                    constant.defined        = op != spv::OpSpecConstantComposite;
+                    constant.specialization = true;
+
+                    spec_constants.push_back(operands[1]);
+                    return true;
+                }
+                case spv::OpVariable:
+                {
+                    if (count < 3 || !is_valid(operands[0]) || !is_valid(operands[1]))
+                    {
+                        return false;
+                    }
+
+                    if (operands[2] != spv::StorageClassFunction)
+                    {
+                        variables.push_back({ operands[1], operands[0], operands[2] });
+                    }
+                    return true;
+                }
+                default:
+                    return true;
+                }
+            }
+
+            bool set_type(const uint32_t* operands, uint32_t count, uint32_t min_count, const Type& type)
+            {
+                if (count < min_count || !is_valid(operands[0]))
+                {
+                    return false;
+                }
+
+                types[operands[0]] = type;
+                return true;
+            }
+
+            static void decorate(Decorations& target, spv::Decoration decoration, const uint32_t* operands, uint32_t count)
+            {
+                auto value = [operands, count]() { return count ? operands[0] : 0; };
+
+                switch (decoration)
+                {
+                case spv::DecorationDescriptorSet:
+                    target.flags |= Decorations::DescriptorSet;
+                    target.set = value();
+                    break;
+                case spv::DecorationBinding:
+                    target.flags |= Decorations::Binding;
+                    target.binding = value();
+                    break;
+                case spv::DecorationLocation:
+                    target.flags |= Decorations::Location;
+                    target.location = value();
+                    break;
+                case spv::DecorationInputAttachmentIndex:
+                    target.flags |= Decorations::InputAttachmentIndex;
+                    target.input_attachment_index = value();
+                    break;
+                case spv::DecorationSpecId:
+                    target.flags |= Decorations::SpecId;
+                    target.spec_id = value();
+                    break;
+                case spv::DecorationArrayStride:
+                    target.array_stride = value();
+                    break;
+                case spv::DecorationOffset:
+                    target.offset = value();
+                    break;
+                case spv::DecorationMatrixStride:
+                    target.matrix_stride = value();
+                    break;
+                case spv::DecorationBlock:
+                    target.flags |= Decorations::Block;
+                    break;
+                case spv::DecorationBufferBlock:
+                    target.flags |= Decorations::BufferBlock;
+                    break;
+                case spv::DecorationBuiltIn:
+                    target.flags |= Decorations::BuiltIn;
+                    break;
+                case spv::DecorationNonReadable:
+                    target.flags |= Decorations::NonReadable;
+                    break;
+                case spv::DecorationNonWritable:
+                    target.flags |= Decorations::NonWritable;
+                    break;
+                case spv::DecorationRowMajor:
+                    target.flags |= Decorations::RowMajor;
+                    break;
+                default:
+                    break;
+                }
+            }
+
+            const Type& get_type(uint32_t id) const
+            {
+                static const Type unknown;
+                return is_valid(id) ? types[id] : unknown;
+            }
+
+            bool is_array(uint32_t id) const
+            {
+                auto op = get_type(id).op;
+                return op == spv::OpTypeArray || op == spv::OpTypeRuntimeArray;
+            }
+
+            // Strips the arrays around a type, the id left is what SPIRV-Cross calls the self of the type
+            uint32_t get_element(uint32_t id) const
+            {
+                while (is_array(id))
+                {
+                    id = get_type(id).element;
+                }
+                return id;
+            }
+
+            uint32_t get_array_length(uint32_t id) const
+            {
+                auto& type = get_type(id);
+                if (type.op == spv::OpTypeRuntimeArray)
+                {
+                    return 0;
+                }
+
+                // Specialization constants count with their default value
+                return is_valid(type.count) ? static_cast<uint32_t>(constants[type.count].value) : 0;
+            }
+
+            // Length of the innermost array around a type, 1 if it is not an array
+            uint32_t get_innermost_array_length(uint32_t id) const
+            {
+                if (!is_array(id))
+                {
+                    return 1;
+                }
+
+                while (is_array(get_type(id).element))
+                {
+                    id = get_type(id).element;
+                }
+                return get_array_length(id);
+            }
+
+            uint32_t get_member_type(const Type& type, uint32_t index) const
+            {
+                return members[type.member_begin + index];
+            }
+
+            const Decorations& get_member_decorations(uint32_t struct_id, uint32_t index) const
+            {
+                static const Decorations none;
+
+                auto& struct_members = member_decorations[struct_id];
+                return index < struct_members.size() ? struct_members[index] : none;
+            }
+
+            bool has_member_flag(uint32_t struct_id, uint32_t flag) const
+            {
+                auto& type = get_type(struct_id);
+                for (uint32_t i = 0; i < type.member_count; i++)
+                {
+                    if (get_member_decorations(struct_id, i).flags & flag)
+                    {
+                        return true;
+                    }
+                }
+                return false;
+            }
+
+            // Decorations of a variable, along with the ones all the members of its block share
+            uint32_t get_access_flags(const Variable& variable, uint32_t self) const
+            {
+                uint32_t flags = decorations[variable.id].flags;
+
+                auto& type = get_type(self);
+                if (type.op != spv::OpTypeStruct || type.member_count == 0)
+                {
+                    return flags;
+                }
+
+                uint32_t member_flags = ~0u;
+                for (uint32_t i = 0; i < type.member_count; i++)
+                {
+                    member_flags &= get_member_decorations(self, i).flags;
+                }
+
+                return flags | member_flags;
+            }
+
+            uint32_t get_scalar_size(uint32_t id) const
+            {
+                auto* type = &get_type(id);
+                while (type->op == spv::OpTypeVector || type->op == spv::OpTypeMatrix)
+                {
+                    type = &get_type(type->element);
+                }
+
+                switch (type->op)
+                {
+                case spv::OpTypeBool:
+                    return 4;
+                case spv::OpTypeInt:
+                case spv::OpTypeFloat:
+                    return type->width == 32 || type->width == 64 ? type->width / 8 : 0;
+                default:
+                    return 0;
+                }
+            }
+
+            uint32_t get_member_size(uint32_t struct_id, uint32_t index) const
+            {
+                uint32_t member_id = get_member_type(get_type(struct_id), index);
+                auto&    member    = get_type(member_id);
+
+                switch (member.op)
+                {
+                case spv::OpTypePointer:
+                    return 8;
+                case spv::OpTypeArray:
+                case spv::OpTypeRuntimeArray:
+                    return decorations[member_id].array_stride * get_array_length(member_id);
+                case spv::OpTypeStruct:
+                    return get_declared_struct_size(member_id);
+                case spv::OpTypeMatrix:
+                {
+                    auto& member_decoration = get_member_decorations(struct_id, index);
+                    auto& column            = get_type(member.element);
+
+                    return member_decoration.matrix_stride * ((member_decoration.flags & Decorations::RowMajor) ? column.count : member.count);
+                }
+                case spv::OpTypeVector:
+                    return member.count * get_type(member.element).width / 8;
+                case spv::OpTypeInt:
+                case spv::OpTypeFloat:
+                    return member.width / 8;
+                default:
+                    throw std::runtime_error("Querying size for object with opaque size");
+                }
+            }
+
+            // The size of a struct ends with the member at the highest offset, whatever order they are declared in
+            uint32_t get_declared_struct_size(uint32_t struct_id) const
+            {
+                auto& type = get_type(struct_id);
+                if (type.member_count == 0)
+                {
+                    throw std::runtime_error("Declared struct in block cannot be empty");
+                }
+
+                uint32_t member_index   = 0;
+                uint32_t highest_offset = 0;
+
+                for (uint32_t i = 0; i < type.member_count; i++)
+                {
+                    uint32_t offset = get_member_decorations(struct_id, i).offset;
+                    if (offset > highest_offset)
+                    {
+                        highest_offset = offset;
+                        member_index   = i;
+                    }
+                }
+
+                return highest_offset + get_member_size(struct_id, member_index);
+            }
+
+            uint32_t get_declared_struct_size(uint32_t struct_id, const std::string& name, const core::HPPShaderVariant& variant) const
+            {
+                uint32_t size = get_declared_struct_size(struct_id);
+
+                auto&    type    = get_type(struct_id);
+                uint32_t last_id = get_member_type(type, type.member_count - 1);
+                auto&    last    = get_type(last_id);
+
+                // A runtime array last takes the size requested by the variant, only one dimensional ones are sized
+                if (last.op == spv::OpTypeRuntimeArray && !is_array(last.element))
+                {
+                    auto it = variant.get_runtime_array_sizes().find(name);
+                    if (it != variant.get_runtime_array_sizes().end())
+                    {
+                        size += static_cast<uint32_t>(it->second) * decorations[last_id].array_stride;
+                    }
+                }
+
+                return size;
+            }
+
+            std::string get_resource_name(const Variable& variable, uint32_t self) const
+            {
+                if (!names[self].empty())
+                {
+                    return std::string{ names[self] };
+                }
+
+                if (!names[variable.id].empty())
+                {
+                    return std::string{ names[variable.id] };
+                }
+
+                return "_" + std::to_string(self) + "_" + std::to_string(variable.id);
+            }
+
+            // Returns All for the variables that are not reflected
+            core::HPPShaderResourceType classify(const Variable& variable) const
+            {
+                auto& pointer = get_type(variable.type);
+                if (pointer.op != spv::OpTypePointer)
+                {
+                    return core::HPPShaderResourceType::All;
+                }
+
+                // Before SPIR-V 1.4, only inputs and outputs are listed in the interface of the entry point
+                bool io = variable.storage == spv::StorageClassInput || variable.storage == spv::StorageClassOutput;
+                if ((version >= 0x10400 || io) && !interface[variable.id])
+                {
+                    return core::HPPShaderResourceType::All;
+                }
+
+                uint32_t self = get_element(pointer.element);
+                auto&    type = get_type(self);
+
+                if ((decorations[variable.id].flags & Decorations::BuiltIn) ||
+                    (type.op == spv::OpTypeStruct && has_member_flag(self, Decorations::BuiltIn)))
+                {
+                    return core::HPPShaderResourceType::All;
+                }
+
+                switch (variable.storage)
+                {
+                case spv::StorageClassInput:
+                    return core::HPPShaderResourceType::Input;
+                case spv::StorageClassOutput:
+                    return core::HPPShaderResourceType::Output;
+                case spv::StorageClassUniform:
+                    if (decorations[self].flags & Decorations::Block)
+                    {
+                        return core::HPPShaderResourceType::BufferUniform;
+                    }
+                    return (decorations[self].flags & Decorations::BufferBlock) ? core::HPPShaderResourceType::BufferStorage : core::HPPShaderResourceType::All;
+                case spv::StorageClassStorageBuffer:
+                    return core::HPPShaderResourceType::BufferStorage;
+                case spv::StorageClassPushConstant:
+                    return core::HPPShaderResourceType::PushConstant;
+                case spv::StorageClassUniformConstant:
+                    switch (type.op)
+                    {
+                    case spv::OpTypeImage:
+                        if (type.dim == spv::DimSubpassData)
+                        {
+                            return core::HPPShaderResourceType::InputAttachment;
+                        }
+                        return type.sampled == 2 ? core::HPPShaderResourceType::ImageStorage : core::HPPShaderResourceType::Image;
+                    case spv::OpTypeSampler:
+                        return core::HPPShaderResourceType::Sampler;
+                    case spv::OpTypeSampledImage:
+                        return core::HPPShaderResourceType::ImageSampler;
+                    default:
+                        return core::HPPShaderResourceType::All;
+                    }
+                default:
+                    return core::HPPShaderResourceType::All;
+                }
+            }
+
+            core::HPPShaderResource read_variable(const Variable&               variable,
+                                                  core::HPPShaderResourceType   resource_type,
+                                                  vk::ShaderStageFlagBits       stage,
+                                                  const core::HPPShaderVariant& variant) const
+            {
+                auto&       decoration = decorations[variable.id];
+                uint32_t    pointee    = get_type(variable.type).element;
+                uint32_t    self       = get_element(pointee);
+                const auto& element    = get_type(self);
+
+                core::HPPShaderResource shader_resource{};
+                shader_resource.type       = resource_type;
+                shader_resource.stages     = resource_type == core::HPPShaderResourceType::InputAttachment ? vk::ShaderStageFlagBits::eFragment : stage;
+                shader_resource.name       = get_resource_name(variable, self);
+                shader_resource.array_size = get_innermost_array_length(pointee);
+
+                switch (resource_type)
+                {
+                case core::HPPShaderResourceType::Input:
+                case core::HPPShaderResourceType::Output:
+                    shader_resource.vec_size = 1;
+                    shader_resource.columns  = 1;
+
+                    if (element.op == spv::OpTypeVector)
+                    {
+                        shader_resource.vec_size = element.count;
+                    }
+                    else if (element.op == spv::OpTypeMatrix)
+                    {
+                        shader_resource.vec_size = get_type(element.element).count;
+                        shader_resource.columns  = element.count;
+                    }
+
+                    shader_resource.location = decoration.location;
+                    break;
+                case core::HPPShaderResourceType::InputAttachment:
+                    shader_resource.input_attachment_index = decoration.input_attachment_index;
+                    break;
+                case core::HPPShaderResourceType::BufferUniform:
+                case core::HPPShaderResourceType::BufferStorage:
+                    shader_resource.size = get_declared_struct_size(self, shader_resource.name, variant);
+                    break;
+                default:
+                    break;
+                }
+
+                if (resource_type == core::HPPShaderResourceType::ImageStorage || resource_type == core::HPPShaderResourceType::BufferStorage)
+                {
+                    uint32_t flags = get_access_flags(variable, self);
+
+                    if (flags & Decorations::NonReadable)
+                    {
+                        shader_resource.qualifiers |= core::HPPShaderResourceQualifiers::NonReadable;
+                    }
+                    if (flags & Decorations::NonWritable)
+                    {
+                        shader_resource.qualifiers |= core::HPPShaderResourceQualifiers::NonWritable;
+                    }
+                }
+
+                if (resource_type != core::HPPShaderResourceType::Input && resource_type != core::HPPShaderResourceType::Output)
+                {
+                    shader_resource.set     = decoration.set;
+                    shader_resource.binding = decoration.binding;
+                }
+
+                return shader_resource;
+            }
+
+            core::HPPShaderResource read_push_constant(const Variable& variable, vk::ShaderStageFlagBits stage, const core::HPPShaderVariant& variant) const
+            {
+                uint32_t self = get_element(get_type(variable.type).element);
+                auto&    type = get_type(self);
+
+                core::HPPShaderResource shader_resource{};
+                shader_resource.type   = core::HPPShaderResourceType::PushConstant;
+                shader_resource.stages = stage;
+                shader_resource.name   = get_resource_name(variable, self);
+                shader_resource.offset = std::numeric_limits<uint32_t>::max();
+
+                for (uint32_t i = 0; i < type.member_count; i++)
+                {
+                    shader_resource.offset = std::min(shader_resource.offset, get_member_decorations(self, i).offset);
+                }
+
+                shader_resource.size = get_declared_struct_size(self, shader_resource.name, variant) - shader_resource.offset;
+
+                return shader_resource;
+            }
+
+            uint32_t version     = 0;
+            size_t   module_size = 0;        // In words
+
+            bool entry_point_found = false;
+
+            std::vector<std::string_view>         names;
+            std::vector<Decorations>              decorations;
+            std::vector<std::vector<Decorations>> member_decorations;
+            std::vector<Type>                     types;
+            std::vector<uint32_t>                 members;               // Member types of all the structs
+            std::vector<Constant>                 constants;
+            std::vector<uint32_t>                 spec_constants;        // In declaration order
+            std::vector<Variable>                 variables;             // Global variables, in declaration order
+            std::vector<bool>                     interface;             // Whether an id is in the interface of the entry point
+        };
+    }        // namespace
+
+    bool SPIRVReflection::reflect_native(vk::ShaderStageFlagBits stage, const std::vector<uint32_t>& spirv, std::vector<core::HPPShaderResource>& resources, const core::HPPShaderVariant& variant)
+    {
+        Module module;
+
+        if (!module.parse(spirv))
+        {
+            return false;
+        }
+
+        module.reflect(stage, resources, variant);
+
+        return true;
+    }
+}        // namespace vkb
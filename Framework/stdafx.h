@@ -2,7 +2,9 @@
 
 #include <cassert>
 #include <cstdio>
+#include <cstring>
 #include <sstream>
+#include <iomanip>
 #include <string>
 #include <vector>
 #include <map>
@@ -10,9 +12,14 @@
 #include <unordered_map>
 #include <unordered_set>
 #include <optional>
+#include <span>
 #include <functional>
 #include <algorithm>
+#include <atomic>
 #include <mutex>
+#include <thread>
+#include <future>
+#include <chrono>
 
 #include <Volk/volk.h>
 #include <vma/vk_mem_alloc.h>
@@ -41,6 +48,8 @@
 #include "core/hpp_framebuffer.h"
 #include "core/hpp_pipeline_layout.h"
 #include "core/hpp_shader_module.h"
+#include "core/hpp_descriptor_set_layout.h"
+#include "core/hpp_pipeline.h"
 
 #include "rendering/hpp_render_target.h"
 #include "rendering/hpp_render_frame.h"
@@ -50,6 +59,7 @@
 #include "rendering/hpp_subpass.h"
 
 #include "hpp_resource_record.h"
+#include "hpp_resource_replay.h"
 #include "hpp_resource_cache.h"
 #include "hpp_semaphore_pool.h"
 #include "hpp_fence_pool.h"
\ No newline at end of file
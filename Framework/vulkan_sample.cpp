@@ -13,6 +13,9 @@ namespace vkb
         if (device)
         {
             device->get_handle().waitIdle();
+
+            // Lets the next run create the objects of this one before its first frame
+            device->get_resource_cache().save_resources();
         }
 
         render_context.reset();
@@ -91,6 +94,9 @@ namespace vkb
         create_render_context();
         prepare_render_context();
 
+        // 5. Create the objects recorded by the previous run, so they are not built on the first frames
+        device->get_resource_cache().load_resources();
+
         // TODO
 
         return true;
@@ -0,0 +1,321 @@
+#define VULKAN_HPP_DISPATCH_LOADER_DYNAMIC 1
+
+#include "stdafx.h"
+#include "common/hpp_resource_caching.h"
+
+#include <fstream>
+#include <random>
+
+VULKAN_HPP_DEFAULT_DISPATCH_LOADER_DYNAMIC_STORAGE
+
+namespace
+{
+    // The parameters of a render pass request, before they are folded into a description
+    struct RenderPassArgs
+    {
+        std::vector<vkb::rendering::HPPAttachment> attachments;
+        std::vector<vkb::HPPLoadStoreInfo>         load_store_infos;
+        std::vector<vkb::core::HPPSubpassInfo>     subpasses;
+    };
+
+    using RenderPassKey = vkb::common::HPPCacheKey<std::vector<vkb::rendering::HPPAttachment>, std::vector<vkb::HPPLoadStoreInfo>, std::vector<vkb::core::HPPSubpassInfo>>;
+
+    // Nanoseconds per hash over the repetitions of a workload
+    struct Timing
+    {
+        double min_ns    = 0.0;
+        double median_ns = 0.0;
+    };
+
+    struct WorkloadResult
+    {
+        std::string name;
+        Timing      hash_combine;
+        Timing      hasher;
+    };
+
+    void print_usage()
+    {
+        std::printf("Usage: HasherBenchmark [-k <keys>] [-n <hashes>] [-r <repetitions>] [-o <file>]\n"
+                    "\n"
+                    "    -k <keys>         Number of distinct render pass keys, 100000 by default\n"
+                    "    -n <hashes>       Hashes of each timed run, 1000000 by default\n"
+                    "    -r <repetitions>  Number of timed runs of each workload, 5 by default\n"
+                    "    -o <file>         Writes the results to a file instead of the standard output\n"
+                    "\n"
+                    "Compares HPPHasher, which keys the resource caches, with the hash_combine path it replaced:\n"
+                    "the time to hash render pass requests and byte blocks of growing sizes, and the collisions\n"
+                    "among the distinct render pass keys. The results are written as JSON.\n");
+    }
+
+    // Distinct render pass requests, drawn from the attachment formats and subpass layouts of typical frames
+    std::vector<RenderPassArgs> make_render_passes(size_t count)
+    {
+        const vk::Format formats[] = { vk::Format::eR8G8B8A8Unorm, vk::Format::eR8G8B8A8Srgb, vk::Format::eB8G8R8A8Unorm, vk::Format::eB8G8R8A8Srgb,
+                                       vk::Format::eR16G16B16A16Sfloat, vk::Format::eA2B10G10R10UnormPack32, vk::Format::eR32Sfloat, vk::Format::eR16G16Sfloat };
+
+        std::mt19937_64 random{ 42 };
+
+        auto pick = [&random](size_t size) { return static_cast<size_t>(random() % size); };
+
+        std::vector<RenderPassArgs>    render_passes;
+        std::set<std::vector<uint8_t>> keys;
+
+        // Bounded, in case fewer distinct keys exist than requested
+        for (size_t attempt = 0; render_passes.size() < count && attempt < count * 16; attempt++)
+        {
+            RenderPassArgs args;
+
+            uint32_t color_count = 1 + static_cast<uint32_t>(pick(4));
+            auto     samples     = pick(4) ? vk::SampleCountFlagBits::e1 : vk::SampleCountFlagBits::e4;
+
+            for (uint32_t c = 0; c < color_count; c++)
+            {
+                vkb::rendering::HPPAttachment attachment{ formats[pick(8)], samples, vk::ImageUsageFlagBits::eColorAttachment };
+                attachment.initial_layout = pick(2) ? vk::ImageLayout::eUndefined : vk::ImageLayout::eColorAttachmentOptimal;
+
+                args.attachments.push_back(attachment);
+                args.load_store_infos.push_back({ static_cast<vk::AttachmentLoadOp>(pick(3)), pick(4) ? vk::AttachmentStoreOp::eStore : vk::AttachmentStoreOp::eDontCare });
+            }
+
+            args.attachments.emplace_back(pick(2) ? vk::Format::eD32Sfloat : vk::Format::eD24UnormS8Uint, samples, vk::ImageUsageFlagBits::eDepthStencilAttachment);
+            args.load_store_infos.push_back({ vk::AttachmentLoadOp::eClear, vk::AttachmentStoreOp::eDontCare });
+
+            // Each subpass writes a subset of the color attachments, and may read the previous outputs
+            size_t subpass_count = 1 + pick(3);
+            for (size_t s = 0; s < subpass_count; s++)
+            {
+                vkb::core::HPPSubpassInfo subpass{};
+
+                for (uint32_t c = 0; c < color_count; c++)
+                {
+                    (pick(2) ? subpass.output_attachments : subpass.input_attachments).push_back(c);
+                }
+
+                subpass.disable_depth_stencil_attachment = pick(4) == 0;
+                args.subpasses.push_back(std::move(subpass));
+            }
+
+            if (keys.insert(RenderPassKey{ args.attachments, args.load_store_infos, args.subpasses }.serialize()).second)
+            {
+                render_passes.push_back(std::move(args));
+            }
+        }
+
+        return render_passes;
+    }
+
+    // The hash the caches computed before HPPHasher, one std::hash per field folded in with glm's hash_combine
+    size_t hash_combine_render_pass(const RenderPassArgs& args)
+    {
+        size_t result = 0;
+
+        vkb::hash_combine(result, args.attachments);
+        vkb::hash_combine(result, args.load_store_infos);
+        vkb::hash_combine(result, args.subpasses);
+
+        return result;
+    }
+
+    // The hash_param<std::vector<uint8_t>> the caches used for byte keys, copying them into a temporary string
+    size_t hash_combine_bytes(const std::vector<uint8_t>& bytes)
+    {
+        size_t result = 0;
+
+        vkb::hash_combine(result, std::string{ bytes.begin(), bytes.end() });
+
+        return result;
+    }
+
+    // What key_param writes for the same vector, its size then its bytes in place
+    vkb::common::HPPHash128 hasher_bytes(const std::vector<uint8_t>& bytes)
+    {
+        vkb::common::HPPHasher hasher;
+
+        hasher.write(bytes.size());
+        hasher.write(bytes.data(), bytes.size());
+
+        return hasher.digest();
+    }
+
+    /**
+     * @brief Times a hash function over the inputs, cycling through them
+     * @param checksum Summed with the hashes, so they are not optimized away
+     */
+    template <class Input, class F>
+    Timing measure(const std::vector<Input>& inputs, size_t hash_count, uint32_t repetitions, uint64_t& checksum, F&& hash)
+    {
+        std::vector<double> times;
+        times.reserve(repetitions);
+
+        for (uint32_t r = 0; r < repetitions; r++)
+        {
+            uint64_t sum = 0;
+
+            auto start = std::chrono::steady_clock::now();
+
+            for (size_t i = 0, index = 0; i < hash_count; i++)
+            {
+                sum += hash(inputs[index]);
+
+                if (++index == inputs.size())
+                {
+                    index = 0;
+                }
+            }
+
+            times.push_back(std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count() / hash_count);
+
+            checksum += sum;
+        }
+
+        std::ranges::sort(times);
+
+        size_t middle = times.size() / 2;
+
+        return { times.front(), times.size() % 2 ? times[middle] : (times[middle - 1] + times[middle]) / 2.0 };
+    }
+
+    // Number of inputs sharing their hash with an earlier one
+    template <class Input, class F>
+    size_t count_collisions(const std::vector<Input>& inputs, F&& hash)
+    {
+        std::vector<decltype(hash(inputs.front()))> hashes;
+        hashes.reserve(inputs.size());
+
+        for (auto& input : inputs)
+        {
+            hashes.push_back(hash(input));
+        }
+
+        std::ranges::sort(hashes, [](const auto& lhs, const auto& rhs) {
+            if constexpr (std::is_same_v<std::decay_t<decltype(lhs)>, vkb::common::HPPHash128>)
+            {
+                return std::tie(lhs.low, lhs.high) < std::tie(rhs.low, rhs.high);
+            }
+            else
+            {
+                return lhs < rhs;
+            }
+        });
+
+        return hashes.size() - static_cast<size_t>(std::distance(hashes.begin(), std::unique(hashes.begin(), hashes.end())));
+    }
+}
+
+int main(int argc, char* argv[])
+{
+    std::string output_path;
+    size_t      key_count   = 100000;
+    size_t      hash_count  = 1000000;
+    uint32_t    repetitions = 5;
+
+    for (int i = 1; i < argc; i++)
+    {
+        std::string argument = argv[i];
+
+        if (argument == "-k" && i + 1 < argc)
+        {
+            key_count = static_cast<size_t>(std::max(1ull, std::strtoull(argv[++i], nullptr, 10)));
+        }
+        else if (argument == "-n" && i + 1 < argc)
+        {
+            hash_count = static_cast<size_t>(std::max(1ull, std::strtoull(argv[++i], nullptr, 10)));
+        }
+        else if (argument == "-r" && i + 1 < argc)
+        {
+            repetitions = static_cast<uint32_t>(std::max(1ul, std::strtoul(argv[++i], nullptr, 10)));
+        }
+        else if (argument == "-o" && i + 1 < argc)
+        {
+            output_path = argv[++i];
+        }
+        else
+        {
+            print_usage();
+            return 1;
+        }
+    }
+
+    try
+    {
+        auto render_passes = make_render_passes(key_count);
+
+        uint64_t checksum = 0;
+
+        auto hasher_render_pass = [](const RenderPassArgs& args) {
+            return RenderPassKey{ args.attachments, args.load_store_infos, args.subpasses }.get_hash();
+        };
+
+        std::vector<WorkloadResult> results;
+
+        results.push_back({ "render_pass",
+                            measure(render_passes, hash_count, repetitions, checksum, hash_combine_render_pass),
+                            measure(render_passes, hash_count, repetitions, checksum, [&](const RenderPassArgs& args) { return hasher_render_pass(args).low; }) });
+
+        // Blocks of the sizes hashed by the caches, from a few handles up to SPIR-V binaries
+        std::mt19937_64 random{ 7 };
+
+        for (size_t size : { 16, 64, 256, 1024, 4096 })
+        {
+            std::vector<std::vector<uint8_t>> blocks(64, std::vector<uint8_t>(size));
+            for (auto& block : blocks)
+            {
+                std::ranges::generate(block, [&random]() { return static_cast<uint8_t>(random()); });
+            }
+
+            results.push_back({ "bytes_" + std::to_string(size),
+                                measure(blocks, hash_count, repetitions, checksum, hash_combine_bytes),
+                                measure(blocks, hash_count, repetitions, checksum, [](const std::vector<uint8_t>& bytes) { return hasher_bytes(bytes).low; }) });
+        }
+
+        size_t hash_combine_collisions = count_collisions(render_passes, hash_combine_render_pass);
+        size_t hasher_collisions       = count_collisions(render_passes, hasher_render_pass);
+
+        std::ostringstream json;
+        json << std::fixed << std::setprecision(3);
+
+        json << "{\n"
+             << "  \"render_pass_keys\": " << render_passes.size() << ",\n"
+             << "  \"hashes\": " << hash_count << ",\n"
+             << "  \"repetitions\": " << repetitions << ",\n"
+             << "  \"checksum\": " << checksum << ",\n"
+             << "  \"collisions\": { \"hash_combine\": " << hash_combine_collisions << ", \"hasher\": " << hasher_collisions << " },\n"
+             << "  \"workloads\": [\n";
+
+        for (size_t i = 0; i < results.size(); i++)
+        {
+            auto& result = results[i];
+
+            json << "    {\n"
+                 << "      \"name\": \"" << result.name << "\",\n"
+                 << "      \"hash_combine\": { \"min_ns\": " << result.hash_combine.min_ns << ", \"median_ns\": " << result.hash_combine.median_ns << " },\n"
+                 << "      \"hasher\": { \"min_ns\": " << result.hasher.min_ns << ", \"median_ns\": " << result.hasher.median_ns << " },\n"
+                 << "      \"speedup\": " << (result.hasher.median_ns > 0.0 ? result.hash_combine.median_ns / result.hasher.median_ns : 0.0) << "\n"
+                 << "    }" << (i + 1 < results.size() ? "," : "") << "\n";
+        }
+
+        json << "  ]\n"
+             << "}\n";
+
+        if (output_path.empty())
+        {
+            std::fputs(json.str().c_str(), stdout);
+        }
+        else
+        {
+            std::ofstream file(output_path, std::ios::binary);
+            if (!(file << json.str()))
+            {
+                throw std::runtime_error("Cannot write " + output_path);
+            }
+        }
+    }
+    catch (const std::exception& e)
+    {
+        std::fprintf(stderr, "%s\n", e.what());
+        return 1;
+    }
+
+    return 0;
+}
\ No newline at end of file
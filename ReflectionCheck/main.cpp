@@ -0,0 +1,422 @@
+#define VULKAN_HPP_DISPATCH_LOADER_DYNAMIC 1
+
+#include "stdafx.h"
+#include "glsl_compiler.h"
+#include "shader_manifest.h"
+#include "shader_preprocessor.h"
+#include "spirv_cache.h"
+#include "spirv_reflection.h"
+
+#include <fstream>
+
+VULKAN_HPP_DEFAULT_DISPATCH_LOADER_DYNAMIC_STORAGE
+
+namespace
+{
+    using ShaderResources = std::vector<vkb::core::HPPShaderResource>;
+
+    void print_usage()
+    {
+        std::printf("Usage: ReflectionCheck [<manifest>]\n"
+                    "\n"
+                    "    <manifest>  The shader variants to check, ../ShaderBenchmark/corpus/manifest.txt by default\n"
+                    "\n"
+                    "Compiles the variants of a ShaderCompiler manifest and reflects their resources, then checks that the\n"
+                    "resources come back unchanged from the reflection cache: encoded and decoded by serialize_shader_resources,\n"
+                    "and stored to and loaded from a .refl file. Files are relative to the directory of the manifest.\n"
+                    "Each binary is also reflected by the Native backend, which must give the resources SPIRV-Cross gives,\n"
+                    "apart from the size of arrays sized by a specialization constant, checked on a shader of its own.\n"
+                    "Lists the differences and exits with 1 if any variant fails a check.\n");
+    }
+
+    template <class T>
+    void diff_field(std::vector<std::string>& differences, const std::string& resource, const char* field, const T& expected, const T& actual)
+    {
+        if (expected == actual)
+        {
+            return;
+        }
+
+        std::ostringstream message;
+
+        if constexpr (std::is_enum_v<T>)
+        {
+            message << resource << ": " << field << " " << static_cast<uint32_t>(expected) << " became " << static_cast<uint32_t>(actual);
+        }
+        else if constexpr (std::is_same_v<T, vk::ShaderStageFlags>)
+        {
+            message << resource << ": " << field << " " << vk::to_string(expected) << " became " << vk::to_string(actual);
+        }
+        else
+        {
+            message << resource << ": " << field << " " << expected << " became " << actual;
+        }
+
+        differences.push_back(message.str());
+    }
+
+    // Describes how two lists of resources differ, field by field, empty if they are equal
+    std::vector<std::string> diff_resources(const ShaderResources& expected, const ShaderResources& actual)
+    {
+        std::vector<std::string> differences;
+
+        if (expected.size() != actual.size())
+        {
+            differences.push_back(std::to_string(expected.size()) + " resources became " + std::to_string(actual.size()));
+        }
+
+        for (size_t i = 0; i < std::min(expected.size(), actual.size()); i++)
+        {
+            auto& lhs = expected[i];
+            auto& rhs = actual[i];
+
+            std::string resource = "resource " + std::to_string(i) + " (" + lhs.name + ")";
+
+            diff_field(differences, resource, "stages", lhs.stages, rhs.stages);
+            diff_field(differences, resource, "type", lhs.type, rhs.type);
+            diff_field(differences, resource, "mode", lhs.mode, rhs.mode);
+            diff_field(differences, resource, "set", lhs.set, rhs.set);
+            diff_field(differences, resource, "binding", lhs.binding, rhs.binding);
+            diff_field(differences, resource, "location", lhs.location, rhs.location);
+            diff_field(differences, resource, "input_attachment_index", lhs.input_attachment_index, rhs.input_attachment_index);
+            diff_field(differences, resource, "vec_size", lhs.vec_size, rhs.vec_size);
+            diff_field(differences, resource, "columns", lhs.columns, rhs.columns);
+            diff_field(differences, resource, "array_size", lhs.array_size, rhs.array_size);
+            diff_field(differences, resource, "offset", lhs.offset, rhs.offset);
+            diff_field(differences, resource, "size", lhs.size, rhs.size);
+            diff_field(differences, resource, "constant_id", lhs.constant_id, rhs.constant_id);
+            diff_field(differences, resource, "qualifiers", lhs.qualifiers, rhs.qualifiers);
+            diff_field(differences, resource, "name", lhs.name, rhs.name);
+        }
+
+        // Fields compared by the default operator== but missing above would hide here
+        if (differences.empty() && expected != actual)
+        {
+            differences.push_back("resources differ in a field not listed by diff_resources");
+        }
+
+        return differences;
+    }
+
+    /**
+     * @brief Checks that the resources reflected from a binary come back unchanged from the reflection cache
+     * @return The differences found, empty if the round trips are exact
+     */
+    std::vector<std::string> check_round_trip(vkb::SPIRVCache&                cache,
+                                              const vkb::ShaderManifestEntry& entry,
+                                              const std::vector<uint32_t>&    spirv,
+                                              const ShaderResources&          resources)
+    {
+        std::vector<std::string> differences;
+
+        auto report = [&differences](const char* path, std::vector<std::string>&& found) {
+            for (auto& difference : found)
+            {
+                differences.push_back(std::string{ path } + ": " + difference);
+            }
+        };
+
+        auto data = vkb::serialize_shader_resources(resources);
+
+        ShaderResources decoded;
+        if (!vkb::deserialize_shader_resources(data.data(), data.size(), decoded))
+        {
+            differences.push_back("serialize_shader_resources: the encoding does not decode");
+        }
+        else
+        {
+            report("serialize_shader_resources", diff_resources(resources, decoded));
+        }
+
+        auto key = vkb::SPIRVCache::get_reflection_key(vkb::SPIRVReflectionBackend::SPIRVCross, entry.stage, spirv, entry.variant);
+
+        cache.store_reflection(key, resources);
+
+        ShaderResources loaded;
+        if (!cache.load_reflection(key, loaded))
+        {
+            differences.push_back("store_reflection: the .refl file does not load");
+        }
+        else
+        {
+            report("store_reflection", diff_resources(resources, loaded));
+        }
+
+        return differences;
+    }
+
+    /**
+     * @brief Checks that the Native backend reflects a binary into the resources SPIRV-Cross reflected
+     * @return The differences found, empty if the backends agree
+     */
+    std::vector<std::string> check_backends(vk::ShaderStageFlagBits            stage,
+                                            const std::vector<uint32_t>&       spirv,
+                                            const vkb::core::HPPShaderVariant& variant,
+                                            const ShaderResources&             resources)
+    {
+        ShaderResources native;
+        if (!vkb::SPIRVReflection{ vkb::SPIRVReflectionBackend::Native }.reflect_shader_resources(stage, spirv, native, variant))
+        {
+            return { "Native backend: reflection failed" };
+        }
+
+        auto differences = diff_resources(resources, native);
+        for (auto& difference : differences)
+        {
+            difference = "Native backend: " + difference;
+        }
+
+        return differences;
+    }
+
+    // An array sized by a specialization constant, the one case where the backends report different resources
+    const char* SPEC_CONSTANT_ARRAY_SOURCE = R"(#version 450
+layout(local_size_x = 64) in;
+
+layout(constant_id = 7) const uint SHADOW_MAP_COUNT = 4;
+
+layout(set = 0, binding = 0) uniform sampler2D shadow_maps[SHADOW_MAP_COUNT];
+
+layout(set = 0, binding = 1) buffer Result
+{
+    vec4 values[];
+} result;
+
+void main()
+{
+    result.values[gl_GlobalInvocationID.x] = textureLod(shadow_maps[SHADOW_MAP_COUNT - 1], vec2(0.5), 0.0);
+}
+)";
+
+    /**
+     * @brief Checks the documented difference between the backends on an array sized by a specialization constant.
+     *        SPIRV-Cross reports the id of the constant as the array size, the Native backend its default value.
+     *        Every other field must match.
+     * @return The differences found, empty if the backends differ only as documented
+     */
+    std::vector<std::string> check_spec_constant_array(const vkb::GLSLCompiler& compiler)
+    {
+        const uint32_t constant_id   = 7;
+        const uint32_t default_value = 4;
+
+        std::string source = SPEC_CONSTANT_ARRAY_SOURCE;
+
+        vkb::core::HPPShaderVariant variant;
+        std::vector<uint32_t>       spirv;
+        std::string                 info_log;
+
+        if (!compiler.compile_to_spirv(vk::ShaderStageFlagBits::eCompute, std::vector<uint8_t>{ source.begin(), source.end() }, "main", variant, spirv, info_log))
+        {
+            return { "compilation failed\n" + info_log };
+        }
+
+        ShaderResources cross;
+        ShaderResources native;
+
+        if (!vkb::SPIRVReflection{ vkb::SPIRVReflectionBackend::SPIRVCross }.reflect_shader_resources(vk::ShaderStageFlagBits::eCompute, spirv, cross, variant) ||
+            !vkb::SPIRVReflection{ vkb::SPIRVReflectionBackend::Native }.reflect_shader_resources(vk::ShaderStageFlagBits::eCompute, spirv, native, variant))
+        {
+            return { "reflection failed" };
+        }
+
+        // The id SPIRV-Cross is expected to report, as SPIRV-Cross itself names the constant
+        uint32_t constant_spirv_id = 0;
+        for (auto& constant : spirv_cross::Compiler{ spirv }.get_specialization_constants())
+        {
+            if (constant.constant_id == constant_id)
+            {
+                constant_spirv_id = constant.id;
+            }
+        }
+
+        auto find_shadow_maps = [](ShaderResources& resources) {
+            auto it = std::ranges::find(resources, std::string{ "shadow_maps" }, &vkb::core::HPPShaderResource::name);
+            return it != resources.end() ? &*it : nullptr;
+        };
+
+        auto* cross_shadow_maps  = find_shadow_maps(cross);
+        auto* native_shadow_maps = find_shadow_maps(native);
+
+        if (!cross_shadow_maps || !native_shadow_maps)
+        {
+            return { "specialization constant array: shadow_maps is not reflected" };
+        }
+
+        std::vector<std::string> differences;
+
+        if (native_shadow_maps->array_size != default_value)
+        {
+            differences.push_back("specialization constant array: the Native backend sizes shadow_maps " + std::to_string(native_shadow_maps->array_size) +
+                                  ", not the default value " + std::to_string(default_value));
+        }
+
+        if (constant_spirv_id == 0 || cross_shadow_maps->array_size != constant_spirv_id)
+        {
+            differences.push_back("specialization constant array: SPIRV-Cross sizes shadow_maps " + std::to_string(cross_shadow_maps->array_size) +
+                                  ", not the id of the constant " + std::to_string(constant_spirv_id));
+        }
+
+        // Once the documented difference is taken out, the backends must agree on everything else
+        cross_shadow_maps->array_size = native_shadow_maps->array_size;
+
+        for (auto& difference : diff_resources(cross, native))
+        {
+            differences.push_back("specialization constant array: Native backend: " + difference);
+        }
+
+        return differences;
+    }
+}
+
+int main(int argc, char* argv[])
+{
+    std::string manifest_path = "../ShaderBenchmark/corpus/manifest.txt";
+
+    std::vector<std::string> arguments;
+
+    for (int i = 1; i < argc; i++)
+    {
+        std::string argument = argv[i];
+
+        if (!argument.empty() && argument.front() == '-')
+        {
+            print_usage();
+            return 1;
+        }
+
+        arguments.push_back(argument);
+    }
+
+    if (arguments.size() > 1)
+    {
+        print_usage();
+        return 1;
+    }
+
+    if (!arguments.empty())
+    {
+        manifest_path = arguments[0];
+    }
+
+    // The cache writes its .refl files to a directory of its own, removed once done
+    auto cache_directory = std::filesystem::temp_directory_path() / "ReflectionCheck";
+
+    try
+    {
+        vkb::filesystem::init();
+
+        std::vector<vkb::ShaderManifestError> errors;
+
+        auto entries = vkb::read_shader_manifest(manifest_path, errors);
+
+        for (auto& error : errors)
+        {
+            std::fprintf(stderr, "%s:%zu: %s\n", manifest_path.c_str(), error.line, error.message.c_str());
+        }
+
+        if (!errors.empty())
+        {
+            return 1;
+        }
+
+        if (entries.empty())
+        {
+            std::fprintf(stderr, "%s: no shader variant\n", manifest_path.c_str());
+            return 1;
+        }
+
+        auto directory = std::filesystem::path(manifest_path).parent_path();
+
+        auto load_file = [&directory](const std::string& path) {
+            std::ifstream file(directory / path, std::ios::binary);
+            if (!file)
+            {
+                throw std::runtime_error("Cannot read " + path);
+            }
+
+            std::ostringstream content;
+            content << file.rdbuf();
+            return content.str();
+        };
+
+        vkb::ShaderPreprocessor preprocessor{ load_file };
+
+        std::filesystem::remove_all(cache_directory);
+
+        vkb::SPIRVCache cache{ cache_directory };
+
+        // Compiled as the framework compiles the shaders missing from the archive
+        vkb::GLSLCompiler compiler;
+
+        bool   failed         = false;
+        size_t resource_count = 0;
+
+        for (auto& entry : entries)
+        {
+            auto report = [&](const std::string& message) {
+                std::fprintf(stderr, "%s:%zu: %s: %s\n", manifest_path.c_str(), entry.line, entry.file.c_str(), message.c_str());
+                failed = true;
+            };
+
+            try
+            {
+                auto source = preprocessor.process(load_file(entry.file)).source;
+
+                std::vector<uint32_t> spirv;
+                std::string           info_log;
+
+                if (!compiler.compile_to_spirv(entry.stage, std::vector<uint8_t>{ source.begin(), source.end() }, entry.entry_point, entry.variant, spirv, info_log))
+                {
+                    report("compilation failed\n" + info_log);
+                    continue;
+                }
+
+                ShaderResources resources;
+
+                if (!vkb::SPIRVReflection{ vkb::SPIRVReflectionBackend::SPIRVCross }.reflect_shader_resources(entry.stage, spirv, resources, entry.variant))
+                {
+                    report("reflection failed");
+                    continue;
+                }
+
+                resource_count += resources.size();
+
+                for (auto& difference : check_round_trip(cache, entry, spirv, resources))
+                {
+                    report(difference);
+                }
+
+                for (auto& difference : check_backends(entry.stage, spirv, entry.variant, resources))
+                {
+                    report(difference);
+                }
+            }
+            catch (const std::exception& e)
+            {
+                report(e.what());
+            }
+        }
+
+        std::filesystem::remove_all(cache_directory);
+
+        for (auto& difference : check_spec_constant_array(compiler))
+        {
+            std::fprintf(stderr, "%s\n", difference.c_str());
+            failed = true;
+        }
+
+        if (failed)
+        {
+            return 1;
+        }
+
+        std::printf("%zu variants, %zu resources: the reflection cache round trips are exact, the backends agree\n", entries.size(), resource_count);
+    }
+    catch (const std::exception& e)
+    {
+        std::fprintf(stderr, "%s\n", e.what());
+        return 1;
+    }
+
+    return 0;
+}
\ No newline at end of file
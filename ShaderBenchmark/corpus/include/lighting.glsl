@@ -0,0 +1,44 @@
+#pragma once
+
+#include "include/scene.glsl"
+
+const float PI = 3.14159265359;
+
+float distribution_ggx(float n_dot_h, float roughness)
+{
+    float a  = roughness * roughness;
+    float a2 = a * a;
+    float d  = n_dot_h * n_dot_h * (a2 - 1.0) + 1.0;
+    return a2 / (PI * d * d);
+}
+
+float geometry_schlick_ggx(float n_dot_v, float roughness)
+{
+    float k = (roughness + 1.0) * (roughness + 1.0) / 8.0;
+    return n_dot_v / (n_dot_v * (1.0 - k) + k);
+}
+
+vec3 fresnel_schlick(float cos_theta, vec3 f0)
+{
+    return f0 + (1.0 - f0) * pow(clamp(1.0 - cos_theta, 0.0, 1.0), 5.0);
+}
+
+vec3 evaluate_light(vec3 normal, vec3 view_direction, vec3 base_color, float metallic, float roughness)
+{
+    vec3 light_direction = normalize(-scene.light_direction.xyz);
+    vec3 half_vector     = normalize(view_direction + light_direction);
+
+    float n_dot_l = max(dot(normal, light_direction), 0.0);
+    float n_dot_v = max(dot(normal, view_direction), 0.0001);
+    float n_dot_h = max(dot(normal, half_vector), 0.0);
+
+    vec3  f0 = mix(vec3(0.04), base_color, metallic);
+    vec3  f  = fresnel_schlick(max(dot(half_vector, view_direction), 0.0), f0);
+    float d  = distribution_ggx(n_dot_h, roughness);
+    float g  = geometry_schlick_ggx(n_dot_v, roughness) * geometry_schlick_ggx(n_dot_l, roughness);
+
+    vec3 specular = d * g * f / (4.0 * n_dot_v * n_dot_l + 0.0001);
+    vec3 diffuse  = (1.0 - f) * (1.0 - metallic) * base_color / PI;
+
+    return (diffuse + specular) * scene.light_color.rgb * n_dot_l;
+}
@@ -0,0 +1,11 @@
+#pragma once
+
+layout(set = 0, binding = 0) uniform SceneUniforms
+{
+    mat4 view;
+    mat4 projection;
+    mat4 light_view_projection;
+    vec4 camera_position;
+    vec4 light_direction;
+    vec4 light_color;
+} scene;
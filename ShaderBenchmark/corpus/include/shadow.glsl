@@ -0,0 +1,27 @@
+#pragma once
+
+#include "include/scene.glsl"
+
+layout(set = 0, binding = 1) uniform sampler2DShadow shadow_map;
+
+float sample_shadow(vec3 world_position)
+{
+    vec4 light_position = scene.light_view_projection * vec4(world_position, 1.0);
+    vec3 coordinates    = light_position.xyz / light_position.w;
+    coordinates.xy      = coordinates.xy * 0.5 + 0.5;
+
+#ifdef SHADOW_PCF
+    vec2  texel  = 1.0 / vec2(textureSize(shadow_map, 0));
+    float result = 0.0;
+    for (int y = -SHADOW_PCF; y <= SHADOW_PCF; y++)
+    {
+        for (int x = -SHADOW_PCF; x <= SHADOW_PCF; x++)
+        {
+            result += texture(shadow_map, vec3(coordinates.xy + vec2(x, y) * texel, coordinates.z));
+        }
+    }
+    return result / float((2 * SHADOW_PCF + 1) * (2 * SHADOW_PCF + 1));
+#else
+    return texture(shadow_map, coordinates);
+#endif
+}
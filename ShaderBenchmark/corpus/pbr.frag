@@ -0,0 +1,68 @@
+#version 450
+
+#include "include/lighting.glsl"
+#include "include/shadow.glsl"
+
+layout(location = 0) in vec3 in_position;
+layout(location = 1) in vec3 in_normal;
+layout(location = 2) in vec2 in_uv;
+#ifdef HAS_TANGENTS
+layout(location = 3) in vec4 in_tangent;
+#endif
+
+layout(set = 2, binding = 0) uniform MaterialUniforms
+{
+    vec4  base_color_factor;
+    float metallic_factor;
+    float roughness_factor;
+    float alpha_cutoff;
+} material;
+
+#ifdef HAS_BASE_COLOR_TEXTURE
+layout(set = 2, binding = 1) uniform sampler2D base_color_texture;
+#endif
+#ifdef HAS_METALLIC_ROUGHNESS_TEXTURE
+layout(set = 2, binding = 2) uniform sampler2D metallic_roughness_texture;
+#endif
+#if defined(HAS_NORMAL_TEXTURE) && defined(HAS_TANGENTS)
+layout(set = 2, binding = 3) uniform sampler2D normal_texture;
+#endif
+
+layout(location = 0) out vec4 out_color;
+
+void main()
+{
+    vec4 base_color = material.base_color_factor;
+#ifdef HAS_BASE_COLOR_TEXTURE
+    base_color *= texture(base_color_texture, in_uv);
+#endif
+
+#ifdef ALPHA_MASK
+    if (base_color.a < material.alpha_cutoff)
+    {
+        discard;
+    }
+#endif
+
+    float metallic  = material.metallic_factor;
+    float roughness = material.roughness_factor;
+#ifdef HAS_METALLIC_ROUGHNESS_TEXTURE
+    vec4 metallic_roughness = texture(metallic_roughness_texture, in_uv);
+    metallic  *= metallic_roughness.b;
+    roughness *= metallic_roughness.g;
+#endif
+
+    vec3 normal = normalize(in_normal);
+#if defined(HAS_NORMAL_TEXTURE) && defined(HAS_TANGENTS)
+    vec3 tangent   = normalize(in_tangent.xyz);
+    vec3 bitangent = cross(normal, tangent) * in_tangent.w;
+    normal         = normalize(mat3(tangent, bitangent, normal) * (texture(normal_texture, in_uv).xyz * 2.0 - 1.0));
+#endif
+
+    vec3 view_direction = normalize(scene.camera_position.xyz - in_position);
+    vec3 color          = evaluate_light(normal, view_direction, base_color.rgb, metallic, roughness) * sample_shadow(in_position);
+
+    color += base_color.rgb * 0.03;
+
+    out_color = vec4(color, base_color.a);
+}
@@ -0,0 +1,54 @@
+#version 450
+
+#include "include/scene.glsl"
+
+layout(location = 0) in vec3 in_position;
+layout(location = 1) in vec3 in_normal;
+layout(location = 2) in vec2 in_uv;
+#ifdef HAS_TANGENTS
+layout(location = 3) in vec4 in_tangent;
+#endif
+#ifdef SKINNED
+layout(location = 4) in uvec4 in_joints;
+layout(location = 5) in vec4 in_weights;
+
+layout(set = 1, binding = 0) readonly buffer Joints
+{
+    mat4 joint_matrices[];
+};
+#endif
+
+layout(push_constant) uniform PushConstants
+{
+    mat4 model;
+} push_constants;
+
+layout(location = 0) out vec3 out_position;
+layout(location = 1) out vec3 out_normal;
+layout(location = 2) out vec2 out_uv;
+#ifdef HAS_TANGENTS
+layout(location = 3) out vec4 out_tangent;
+#endif
+
+void main()
+{
+    mat4 model = push_constants.model;
+
+#ifdef SKINNED
+    model = model * (in_weights.x * joint_matrices[in_joints.x] +
+                     in_weights.y * joint_matrices[in_joints.y] +
+                     in_weights.z * joint_matrices[in_joints.z] +
+                     in_weights.w * joint_matrices[in_joints.w]);
+#endif
+
+    vec4 world_position = model * vec4(in_position, 1.0);
+
+    out_position = world_position.xyz;
+    out_normal   = mat3(model) * in_normal;
+    out_uv       = in_uv;
+#ifdef HAS_TANGENTS
+    out_tangent = vec4(mat3(model) * in_tangent.xyz, in_tangent.w);
+#endif
+
+    gl_Position = scene.projection * scene.view * world_position;
+}
@@ -0,0 +1,15 @@
+#version 450
+
+#include "include/scene.glsl"
+
+layout(location = 0) in vec3 in_position;
+
+layout(push_constant) uniform PushConstants
+{
+    mat4 model;
+} push_constants;
+
+void main()
+{
+    gl_Position = scene.light_view_projection * push_constants.model * vec4(in_position, 1.0);
+}
@@ -0,0 +1,36 @@
+#version 450
+
+layout(set = 0, binding = 0) uniform sampler2D hdr_image;
+
+layout(location = 0) in vec2 in_uv;
+
+layout(location = 0) out vec4 out_color;
+
+layout(push_constant) uniform PushConstants
+{
+    float exposure;
+} push_constants;
+
+vec3 aces(vec3 x)
+{
+    return clamp((x * (2.51 * x + 0.03)) / (x * (2.43 * x + 0.59) + 0.14), 0.0, 1.0);
+}
+
+void main()
+{
+    vec3 color = texture(hdr_image, in_uv).rgb * push_constants.exposure;
+
+#if defined(TONEMAP_ACES)
+    color = aces(color);
+#elif defined(TONEMAP_REINHARD)
+    color = color / (color + 1.0);
+#else
+    color = clamp(color, 0.0, 1.0);
+#endif
+
+#ifndef OUTPUT_SRGB
+    color = pow(color, vec3(1.0 / 2.2));
+#endif
+
+    out_color = vec4(color, 1.0);
+}
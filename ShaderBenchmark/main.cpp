@@ -0,0 +1,421 @@
+#define VULKAN_HPP_DISPATCH_LOADER_DYNAMIC 1
+
+#include "stdafx.h"
+#include "glsl_compiler.h"
+#include "shader_manifest.h"
+#include "shader_preprocessor.h"
+#include "spirv_reflection.h"
+
+#include <fstream>
+
+VULKAN_HPP_DEFAULT_DISPATCH_LOADER_DYNAMIC_STORAGE
+
+namespace
+{
+    // Wall times of the repetitions of a stage, in milliseconds
+    struct Timing
+    {
+        double min_ms    = 0.0;
+        double median_ms = 0.0;
+    };
+
+    struct StageResult
+    {
+        std::string name;
+        Timing      single_thread;
+        Timing      multi_thread;
+    };
+
+    void print_usage()
+    {
+        std::printf("Usage: ShaderBenchmark [<manifest>] [-j <threads>] [-r <repetitions>] [-O0|-O|-Os] [-o <file>]\n"
+                    "\n"
+                    "    <manifest>        The shader variants to run, corpus/manifest.txt by default\n"
+                    "    -j <threads>      Number of threads of the multi-threaded runs, all the cores by default\n"
+                    "    -r <repetitions>  Number of timed runs of each stage, 5 by default\n"
+                    "    -O0, -O, -Os      The spirv-opt passes of the optimize stage, the performance passes by default\n"
+                    "    -o <file>         Writes the results to a file instead of the standard output\n"
+                    "\n"
+                    "Runs the variants of a ShaderCompiler manifest through each stage of the shader path on its own:\n"
+                    "include expansion, preprocessing, compilation, optimization and reflection with both backends.\n"
+                    "Each stage runs on one thread, then on all the threads, and the results are written as JSON.\n"
+                    "Files are relative to the directory of the manifest, and are read once before timing.\n");
+    }
+
+    // Calls func with each index below count, spread over thread_count threads
+    template <class F>
+    void run_parallel(size_t count, uint32_t thread_count, F& func)
+    {
+        if (thread_count <= 1)
+        {
+            for (size_t i = 0; i < count; i++)
+            {
+                func(i);
+            }
+            return;
+        }
+
+        std::atomic<size_t> next_index{ 0 };
+
+        std::vector<std::thread> threads;
+        threads.reserve(thread_count);
+
+        for (uint32_t t = 0; t < thread_count; t++)
+        {
+            threads.emplace_back([&]() {
+                for (size_t i = next_index++; i < count; i = next_index++)
+                {
+                    func(i);
+                }
+            });
+        }
+
+        for (auto& thread : threads)
+        {
+            thread.join();
+        }
+    }
+
+    /**
+     * @brief Times the runs of a stage over all the variants
+     * @param setup Called before each run, untimed, to reset the inputs a stage modifies in place
+     */
+    template <class Setup, class F>
+    Timing measure(size_t count, uint32_t thread_count, uint32_t repetitions, Setup&& setup, F&& func)
+    {
+        std::vector<double> times;
+        times.reserve(repetitions);
+
+        for (uint32_t r = 0; r < repetitions; r++)
+        {
+            setup();
+
+            auto start = std::chrono::steady_clock::now();
+
+            run_parallel(count, thread_count, func);
+
+            times.push_back(std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count());
+        }
+
+        std::ranges::sort(times);
+
+        size_t middle = times.size() / 2;
+
+        return { times.front(), times.size() % 2 ? times[middle] : (times[middle - 1] + times[middle]) / 2.0 };
+    }
+
+    std::string escape_json(const std::string& value)
+    {
+        std::string result;
+
+        for (char c : value)
+        {
+            if (c == '"' || c == '\\')
+            {
+                result += '\\';
+                result += c;
+            }
+            else if (static_cast<unsigned char>(c) < 0x20)
+            {
+                char code[8];
+                std::snprintf(code, sizeof(code), "\\u%04x", c);
+                result += code;
+            }
+            else
+            {
+                result += c;
+            }
+        }
+
+        return result;
+    }
+
+    const char* get_optimization_name(vkb::SPIRVOptimization optimization)
+    {
+        switch (optimization)
+        {
+            case vkb::SPIRVOptimization::Performance:
+                return "performance";
+            case vkb::SPIRVOptimization::Size:
+                return "size";
+            default:
+                return "none";
+        }
+    }
+}
+
+int main(int argc, char* argv[])
+{
+    std::string              manifest_path = "corpus/manifest.txt";
+    std::string              output_path;
+    uint32_t                 thread_count  = std::max(1u, std::thread::hardware_concurrency());
+    uint32_t                 repetitions   = 5;
+    vkb::SPIRVOptimization   optimization  = vkb::SPIRVOptimization::Performance;
+    std::vector<std::string> arguments;
+
+    for (int i = 1; i < argc; i++)
+    {
+        std::string argument = argv[i];
+
+        if (argument == "-j" && i + 1 < argc)
+        {
+            thread_count = static_cast<uint32_t>(std::max(1ul, std::strtoul(argv[++i], nullptr, 10)));
+        }
+        else if (argument == "-r" && i + 1 < argc)
+        {
+            repetitions = static_cast<uint32_t>(std::max(1ul, std::strtoul(argv[++i], nullptr, 10)));
+        }
+        else if (argument == "-o" && i + 1 < argc)
+        {
+            output_path = argv[++i];
+        }
+        else if (argument == "-O0")
+        {
+            optimization = vkb::SPIRVOptimization::None;
+        }
+        else if (argument == "-O")
+        {
+            optimization = vkb::SPIRVOptimization::Performance;
+        }
+        else if (argument == "-Os")
+        {
+            optimization = vkb::SPIRVOptimization::Size;
+        }
+        else if (!argument.empty() && argument.front() == '-')
+        {
+            print_usage();
+            return 1;
+        }
+        else
+        {
+            arguments.push_back(argument);
+        }
+    }
+
+    if (arguments.size() > 1)
+    {
+        print_usage();
+        return 1;
+    }
+
+    if (!arguments.empty())
+    {
+        manifest_path = arguments[0];
+    }
+
+    try
+    {
+        std::vector<vkb::ShaderManifestError> errors;
+
+        auto entries = vkb::read_shader_manifest(manifest_path, errors);
+
+        for (auto& error : errors)
+        {
+            std::fprintf(stderr, "%s:%zu: %s\n", manifest_path.c_str(), error.line, error.message.c_str());
+        }
+
+        if (!errors.empty())
+        {
+            return 1;
+        }
+
+        if (entries.empty())
+        {
+            std::fprintf(stderr, "%s: no shader variant\n", manifest_path.c_str());
+            return 1;
+        }
+
+        // Keep the file system out of the timings, every file is read once during the first run
+        auto directory = std::filesystem::path(manifest_path).parent_path();
+
+        std::mutex                                   files_mutex;
+        std::unordered_map<std::string, std::string> files;
+
+        auto load_file = [&](const std::string& path) {
+            std::lock_guard<std::mutex> guard(files_mutex);
+
+            auto it = files.find(path);
+            if (it == files.end())
+            {
+                std::ifstream file(directory / path, std::ios::binary);
+                if (!file)
+                {
+                    throw std::runtime_error("Cannot read " + path);
+                }
+
+                std::ostringstream content;
+                content << file.rdbuf();
+
+                it = files.emplace(path, content.str()).first;
+            }
+
+            return it->second;
+        };
+
+        size_t count = entries.size();
+
+        std::vector<std::vector<uint8_t>>  sources(count);
+        std::vector<std::string>           preprocessed(count);
+        std::vector<std::vector<uint32_t>> unoptimized(count);
+        std::vector<std::vector<uint32_t>> optimized(count);
+
+        vkb::GLSLCompiler compiler;
+        compiler.set_optimizer_options({ vkb::SPIRVOptimization::None, false });
+
+        vkb::GLSLCompiler optimizer;
+        optimizer.set_optimizer_options({ optimization, optimization != vkb::SPIRVOptimization::None });
+
+        // A new preprocessor for each run, so shared headers are scanned again as in a fresh batch
+        std::unique_ptr<vkb::ShaderPreprocessor> preprocessor;
+
+        auto reset_preprocessor = [&]() { preprocessor = std::make_unique<vkb::ShaderPreprocessor>(load_file); };
+        auto reset_optimized    = [&]() { optimized = unoptimized; };
+        auto no_setup           = []() {};
+
+        auto include_stage = [&](size_t i) {
+            auto result = preprocessor->process(load_file(entries[i].file));
+            sources[i].assign(result.source.begin(), result.source.end());
+        };
+
+        auto preprocess_stage = [&](size_t i) {
+            std::string info_log;
+            if (!compiler.preprocess(entries[i].stage, sources[i], entries[i].entry_point, entries[i].variant, preprocessed[i], info_log))
+            {
+                throw std::runtime_error(entries[i].file + ": preprocessing failed\n" + info_log);
+            }
+        };
+
+        auto compile_stage = [&](size_t i) {
+            std::string info_log;
+            if (!compiler.compile_to_spirv(entries[i].stage, sources[i], entries[i].entry_point, entries[i].variant, unoptimized[i], info_log))
+            {
+                throw std::runtime_error(entries[i].file + ": compilation failed\n" + info_log);
+            }
+        };
+
+        auto optimize_stage = [&](size_t i) {
+            std::string info_log;
+            optimizer.optimize(optimized[i], info_log);
+        };
+
+        auto reflect_stage = [&](vkb::SPIRVReflectionBackend backend) {
+            return [&entries, &optimized, backend](size_t i) {
+                vkb::SPIRVReflection                      reflection{ backend };
+                std::vector<vkb::core::HPPShaderResource> resources;
+
+                if (!reflection.reflect_shader_resources(entries[i].stage, optimized[i], resources, entries[i].variant))
+                {
+                    throw std::runtime_error(entries[i].file + ": reflection failed");
+                }
+            };
+        };
+
+        auto reflect_cross_stage  = reflect_stage(vkb::SPIRVReflectionBackend::SPIRVCross);
+        auto reflect_native_stage = reflect_stage(vkb::SPIRVReflectionBackend::Native);
+
+        // Run the whole path once on a single thread: it fills the inputs of each stage, initializes glslang,
+        // and reports the variants failing somewhere before anything is timed
+        reset_preprocessor();
+        for (size_t i = 0; i < count; i++)
+        {
+            try
+            {
+                include_stage(i);
+                preprocess_stage(i);
+                compile_stage(i);
+            }
+            catch (const std::exception& e)
+            {
+                std::fprintf(stderr, "%s:%zu: %s\n", manifest_path.c_str(), entries[i].line, e.what());
+                failed = true;
+            }
+        }
+
+        if (failed)
+        {
+            return 1;
+        }
+
+        reset_optimized();
+        for (size_t i = 0; i < count; i++)
+        {
+            optimize_stage(i);
+            reflect_cross_stage(i);
+            reflect_native_stage(i);
+        }
+
+        size_t unoptimized_word_count = 0;
+        size_t optimized_word_count   = 0;
+
+        for (size_t i = 0; i < count; i++)
+        {
+            unoptimized_word_count += unoptimized[i].size();
+            optimized_word_count   += optimized[i].size();
+        }
+
+        std::vector<StageResult> results;
+
+        auto run_stage = [&](const char* name, auto&& setup, auto&& func) {
+            StageResult result{ name };
+
+            result.single_thread = measure(count, 1, repetitions, setup, func);
+            result.multi_thread  = measure(count, thread_count, repetitions, setup, func);
+
+            results.push_back(std::move(result));
+        };
+
+        run_stage("include", reset_preprocessor, include_stage);
+        run_stage("preprocess", no_setup, preprocess_stage);
+        run_stage("compile", no_setup, compile_stage);
+        run_stage("optimize", reset_optimized, optimize_stage);
+        run_stage("reflect_spirv_cross", no_setup, reflect_cross_stage);
+        run_stage("reflect_native", no_setup, reflect_native_stage);
+
+        std::ostringstream json;
+        json << std::fixed << std::setprecision(3);
+
+        json << "{\n"
+             << "  \"manifest\": \"" << escape_json(manifest_path) << "\",\n"
+             << "  \"variants\": " << count << ",\n"
+             << "  \"threads\": " << thread_count << ",\n"
+             << "  \"repetitions\": " << repetitions << ",\n"
+             << "  \"optimization\": \"" << get_optimization_name(optimization) << "\",\n"
+             << "  \"spirv_words\": { \"unoptimized\": " << unoptimized_word_count << ", \"optimized\": " << optimized_word_count << " },\n"
+             << "  \"stages\": [\n";
+
+        for (size_t i = 0; i < results.size(); i++)
+        {
+            auto& result = results[i];
+
+            json << "    {\n"
+                 << "      \"name\": \"" << result.name << "\",\n"
+                 << "      \"single_thread\": { \"min_ms\": " << result.single_thread.min_ms << ", \"median_ms\": " << result.single_thread.median_ms << " },\n"
+                 << "      \"multi_thread\": { \"min_ms\": " << result.multi_thread.min_ms << ", \"median_ms\": " << result.multi_thread.median_ms << " },\n"
+                 << "      \"speedup\": " << (result.multi_thread.median_ms > 0.0 ? result.single_thread.median_ms / result.multi_thread.median_ms : 0.0) << "\n"
+                 << "    }" << (i + 1 < results.size() ? "," : "") << "\n";
+        }
+
+        json << "  ]\n"
+             << "}\n";
+
+        if (output_path.empty())
+        {
+            std::fputs(json.str().c_str(), stdout);
+        }
+        else
+        {
+            std::ofstream file(output_path, std::ios::binary);
+            if (!(file << json.str()))
+            {
+                throw std::runtime_error("Cannot write " + output_path);
+            }
+        }
+    }
+    catch (const std::exception& e)
+    {
+        std::fprintf(stderr, "%s\n", e.what());
+        return 1;
+    }
+
+    return 0;
+}
\ No newline at end of file
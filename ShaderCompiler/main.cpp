@@ -0,0 +1,180 @@
+#define VULKAN_HPP_DISPATCH_LOADER_DYNAMIC 1
+
+#include "stdafx.h"
+#include "glsl_compiler.h"
+#include "shader_archive.h"
+#include "shader_manifest.h"
+#include "shader_preprocessor.h"
+#include "spirv_reflection.h"
+
+VULKAN_HPP_DEFAULT_DISPATCH_LOADER_DYNAMIC_STORAGE
+
+namespace
+{
+    void print_usage()
+    {
+        std::printf("Usage: ShaderCompiler <manifest> <archive> [-j <threads>] [-O0|-O|-Os] [-g]\n"
+                    "\n"
+                    "    -j <threads>  Number of threads to compile on, all the cores by default\n"
+                    "    -O0, -O, -Os  No spirv-opt passes, the performance passes or the size passes. Defaults to the build profile of the tool\n"
+                    "    -g            Keep the debug instructions, which are stripped along with -O and -Os by default\n"
+                    "\n"
+                    "Compiles the shader variants listed in the manifest into an archive loaded at startup by the framework.\n"
+                    "Each line of the manifest lists a variant, lines starting with # are comments:\n"
+                    "    <vert|frag|comp|geom|tesc|tese> <file> [-e<entry point>] [-D<define>[=<value>]] [-U<name>] [-R<runtime array>=<size>]\n"
+                    "Files are relative to the shader directory.\n");
+    }
+}
+
+int main(int argc, char* argv[])
+{
+    std::vector<std::string>   arguments;
+    uint32_t                   thread_count = 0;
+    vkb::SPIRVOptimizerOptions optimizer_options;
+    bool                       keep_debug_info = false;
+
+    for (int i = 1; i < argc; i++)
+    {
+        std::string argument = argv[i];
+
+        if (argument == "-j" && i + 1 < argc)
+        {
+            thread_count = static_cast<uint32_t>(std::strtoul(argv[++i], nullptr, 10));
+        }
+        else if (argument == "-O0")
+        {
+            optimizer_options.optimization = vkb::SPIRVOptimization::None;
+        }
+        else if (argument == "-O")
+        {
+            optimizer_options.optimization = vkb::SPIRVOptimization::Performance;
+        }
+        else if (argument == "-Os")
+        {
+            optimizer_options.optimization = vkb::SPIRVOptimization::Size;
+        }
+        else if (argument == "-g")
+        {
+            keep_debug_info = true;
+        }
+        else
+        {
+            arguments.push_back(argument);
+        }
+    }
+
+    if (arguments.size() != 2)
+    {
+        print_usage();
+        return 1;
+    }
+
+    optimizer_options.strip_debug_info = !keep_debug_info && optimizer_options.optimization != vkb::SPIRVOptimization::None;
+
+    const std::string& manifest_path = arguments[0];
+    const std::string& archive_path  = arguments[1];
+
+    try
+    {
+        vkb::filesystem::init();
+
+        std::vector<vkb::ShaderManifestError> errors;
+
+        auto entries = vkb::read_shader_manifest(manifest_path, errors);
+
+        for (auto& error : errors)
+        {
+            std::fprintf(stderr, "%s:%zu: %s\n", manifest_path.c_str(), error.line, error.message.c_str());
+        }
+
+        bool failed = !errors.empty();
+
+        // Expand the includes up front, the key of each variant is computed from its expanded source
+        vkb::ShaderPreprocessor preprocessor;
+
+        std::vector<vkb::GLSLCompileJob>             jobs;
+        std::vector<vkb::ShaderArchiveItem>          items;
+        std::vector<const vkb::ShaderManifestEntry*> job_entries;
+
+        for (auto& entry : entries)
+        {
+            try
+            {
+                vkb::core::HPPShaderSource source{ entry.file };
+
+                auto preprocessed = preprocessor.process(source.get_source());
+
+                vkb::ShaderArchiveItem item;
+                item.key = vkb::ShaderArchive::get_key(entry.stage, preprocessed.source, entry.entry_point, entry.variant);
+                items.push_back(std::move(item));
+
+                jobs.push_back({ entry.stage, { preprocessed.source.begin(), preprocessed.source.end() }, entry.entry_point, entry.variant });
+                job_entries.push_back(&entry);
+            }
+            catch (const std::exception& e)
+            {
+                std::fprintf(stderr, "%s:%zu: %s: %s\n", manifest_path.c_str(), entry.line, entry.file.c_str(), e.what());
+                failed = true;
+            }
+        }
+
+        vkb::GLSLCompiler glsl_compiler;
+        glsl_compiler.set_optimizer_options(optimizer_options);
+
+        auto results = glsl_compiler.compile_batch(jobs, thread_count);
+
+        vkb::SPIRVReflection spirv_reflection;
+
+        size_t unoptimized_word_count = 0;
+        size_t word_count             = 0;
+        size_t compile_count          = 0;
+
+        for (size_t i = 0; i < results.size(); i++)
+        {
+            auto& entry = *job_entries[i];
+
+            if (!results[i].success)
+            {
+                std::fprintf(stderr, "%s:%zu: %s: compilation failed\n%s\n", manifest_path.c_str(), entry.line, entry.file.c_str(), results[i].info_log.c_str());
+                failed = true;
+                continue;
+            }
+
+            if (!spirv_reflection.reflect_shader_resources(entry.stage, results[i].spirv, items[i].resources, entry.variant))
+            {
+                std::fprintf(stderr, "%s:%zu: %s: reflection failed\n", manifest_path.c_str(), entry.line, entry.file.c_str());
+                failed = true;
+                continue;
+            }
+
+            // Variants preprocessing to the same output share a compile, and their blob in the archive
+            if (!results[i].deduplicated)
+            {
+                unoptimized_word_count += results[i].unoptimized_word_count;
+                word_count             += results[i].spirv.size();
+                compile_count++;
+            }
+
+            items[i].spirv = std::move(results[i].spirv);
+        }
+
+        // A partial archive would silently fall back to runtime compiles, leave the previous one in place instead
+        if (failed)
+        {
+            return 1;
+        }
+
+        vkb::ShaderArchive::write(archive_path, items);
+
+        std::printf("Wrote %zu shader variants to %s\n", items.size(), archive_path.c_str());
+        std::printf("Compiled %zu distinct shaders, collapse ratio %.2f\n", compile_count, compile_count ? static_cast<float>(items.size()) / compile_count : 0.0f);
+        std::printf("%zu SPIR-V words, %zu before optimization\n", word_count, unoptimized_word_count);
+    }
+    catch (const std::exception& e)
+    {
+        std::fprintf(stderr, "%s\n", e.what());
+        return 1;
+    }
+
+    return 0;
+}
\ No newline at end of file